@@ -39,10 +39,18 @@ typedef struct {
     obstacle_zone_t zone;        /*!< Zone identifier */
     gpio_num_t scl_pin;          /*!< I2C SCL pin for this zone */
     gpio_num_t sda_pin;          /*!< I2C SDA pin for this zone */
+    gpio_num_t xshut_pin;        /*!< Sensor XSHUT pin, GPIO_NUM_NC if tied high */
+    gpio_num_t gpio_int_pin;     /*!< Sensor GPIO1 pin, GPIO_NUM_NC if not wired */
     uint16_t warning_distance_mm; /*!< Warning distance threshold */
     uint16_t critical_distance_mm;/*!< Critical distance threshold */
-    vl53l0x_mode_t mode;         /*!< Sensor mode for this zone */
+    vl53l0x_mode_t mode;         /*!< Sensor mode for this zone (starting mode when adaptive) */
+    uint16_t rate_hz;            /*!< Sample rate budget, 0 = as fast as the mode allows */
+    bool adaptive;               /*!< Pick the mode per sample from distance, closing speed and commanded speed */
+    bool threshold_wakeup;       /*!< Let the sensor flag band changes itself (see obstacle_detection_init) */
     bool enabled;                /*!< Enable/disable this zone */
+#ifdef VL53L0X_SIMULATOR
+    vl53l0x_sim_handle_t simulator; /*!< Simulated sensor for this zone, NULL for hardware */
+#endif
 } obstacle_zone_config_t;
 
 /**
@@ -52,7 +60,8 @@ typedef enum {
     OBSTACLE_EVENT_CLEAR,        /*!< Path is clear */
     OBSTACLE_EVENT_WARNING,      /*!< Obstacle in warning range */
     OBSTACLE_EVENT_CRITICAL,     /*!< Obstacle in critical range */
-    OBSTACLE_EVENT_ERROR         /*!< Sensor error */
+    OBSTACLE_EVENT_ERROR,        /*!< Sensor error */
+    OBSTACLE_EVENT_DEGRADED      /*!< Sensor stopped delivering samples (bus fault); zone is not clear */
 } obstacle_event_t;
 
 /**
@@ -66,18 +75,82 @@ typedef enum {
 typedef void (*obstacle_callback_t)(obstacle_zone_t zone, uint16_t distance_mm, 
                                      obstacle_event_t event, void* user_data);
 
+/**
+ * @brief Per-zone ranging counters
+ */
+typedef struct {
+    uint32_t samples;            /*!< Samples processed since obstacle_detection_start() */
+    float rate_hz;               /*!< samples over the time since start */
+    uint32_t missed_slots;       /*!< Single-shot slots skipped because the zone was still ranging */
+    bool scheduled;              /*!< Ranged by the shared scheduler (false: the sensor's own task) */
+} obstacle_zone_stats_t;
+
+/**
+ * @brief Latest result of one zone
+ */
+typedef struct {
+    uint16_t distance_mm;        /*!< Last distance read (kept while the sensor is degraded) */
+    obstacle_event_t status;     /*!< Band of that distance, ERROR if invalid, DEGRADED if the sensor stopped */
+    int64_t timestamp_us;        /*!< esp_timer time of the sample distance_mm comes from, 0 = none yet */
+    uint32_t age_us;             /*!< Time from timestamp_us to the snapshot (UINT32_MAX if none yet) */
+} obstacle_zone_snapshot_t;
+
+/**
+ * @brief Every zone as of one instant
+ */
+typedef struct {
+    obstacle_zone_snapshot_t zones[ZONE_MAX]; /*!< Indexed like the configuration array */
+    uint8_t num_zones;           /*!< Entries filled */
+    int64_t taken_us;            /*!< esp_timer time the frame was read */
+} obstacle_snapshot_t;
+
+/**
+ * @brief Ranging counters and task cost of the whole system
+ */
+typedef struct {
+    obstacle_zone_stats_t zones[ZONE_MAX]; /*!< Indexed like the configuration array */
+    uint8_t tasks;               /*!< Ranging tasks running */
+    uint32_t stack_bytes;        /*!< Stack reserved by those tasks */
+} obstacle_detection_stats_t;
+
 /**
  * @brief Initialize obstacle detection system
  * 
+ * A zone with threshold_wakeup keeps the sensor's interrupt thresholds on
+ * the edges of the band (clear / warning / critical) its last sample fell
+ * in, so samples that stay in the band are never read: with gpio_int_pin
+ * wired the zone costs no bus traffic until the band changes, without it
+ * one status byte per sample. The distance is refreshed at least every
+ * heartbeat (250 ms) even so. Threshold zones cannot be adaptive.
+ * 
+ * Zone sensors get addresses 0x29, 0x2A, ... in array order. Zones
+ * sharing a bus need XSHUT pins so the addresses can be handed out one
+ * sensor at a time; calibration then runs for all zones concurrently
+ * (vl53l0x_init_multi).
+ * 
  * @param zones Array of zone configurations
  * @param num_zones Number of zones
- * @return ESP_OK on success
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for an adaptive threshold zone
  */
 esp_err_t obstacle_detection_init(const obstacle_zone_config_t* zones, size_t num_zones);
 
 /**
  * @brief Start obstacle detection
  * 
+ * One scheduler task serves every zone. When the zones' timing budgets
+ * fit in their periods (sum of budget * rate_hz up to 1, for example 6
+ * HIGH_SPEED zones at 8 Hz), it ranges them with single shots: each zone
+ * is triggered once per 1 / rate_hz, zone start times are spread evenly
+ * over the period, and no two sensors range at the same time, so
+ * neighbouring sensors cannot see each other's pulses. Otherwise, or
+ * with a single zone, the zones share ranging time anyway: each sensor
+ * runs hardware ranging at rate_hz (back-to-back when 0), started at its
+ * slot, and the scheduler only reads the samples out, at about a quarter
+ * of the bus traffic of single shots.
+ * 
+ * Threshold wakeup and MULTI_SHOT zones need the sensor ranging on its
+ * own and keep the driver's continuous task, at rate_hz when set.
+ * 
  * @param callback Callback function for obstacle events
  * @param user_data User data to pass to callback
  * @return ESP_OK on success
@@ -87,10 +160,30 @@ esp_err_t obstacle_detection_start(obstacle_callback_t callback, void* user_data
 /**
  * @brief Stop obstacle detection
  * 
- * @return ESP_OK on success
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT if the scheduler or a zone's
+ *         ranging task is still running
  */
 esp_err_t obstacle_detection_stop(void);
 
+/**
+ * @brief Get achieved per-zone rates and the ranging task cost
+ * 
+ * @param stats Pointer to store the counters
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t obstacle_detection_get_stats(obstacle_detection_stats_t* stats);
+
+/**
+ * @brief Set the commanded vehicle speed used by adaptive zones
+ * 
+ * Front zones see it as approach speed, the rear zone when it is negative;
+ * left and right zones only use the closing speed they measure.
+ * 
+ * @param speed_mm_s Commanded forward speed (negative when reversing)
+ * @return ESP_OK on success
+ */
+esp_err_t obstacle_detection_set_speed(int16_t speed_mm_s);
+
 /**
  * @brief Get distance for specific zone
  * 
@@ -100,9 +193,26 @@ esp_err_t obstacle_detection_stop(void);
  */
 esp_err_t obstacle_detection_get_distance(obstacle_zone_t zone, uint16_t* distance_mm);
 
+/**
+ * @brief Get the latest result of every zone, all from the same instant
+ * 
+ * Lock-free: each zone's task publishes under a sequence counter and the
+ * reader retries if any zone changed while it was copying, so readers
+ * never block the ranging tasks and a frame never mixes an old result of
+ * one zone with a newer result of another. A read is a few dozen loads
+ * and stores, so a control loop can call it at 500 Hz or more.
+ * 
+ * @param snapshot Pointer to store the frame
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT if writers kept interrupting the read
+ */
+esp_err_t obstacle_detection_get_snapshot(obstacle_snapshot_t* snapshot);
+
 /**
  * @brief Check if path is clear (all zones)
  * 
+ * Evaluated on one snapshot. A zone whose sensor is degraded never counts
+ * as clear.
+ * 
  * @return true if all zones are clear
  */
 bool obstacle_detection_is_path_clear(void);
@@ -126,7 +236,10 @@ const char* obstacle_detection_get_zone_name(obstacle_zone_t zone);
 /**
  * @brief Deinitialize obstacle detection system
  * 
- * @return ESP_OK on success
+ * Stops detection first and frees nothing if that fails. Sensors that
+ * fail to deinitialize are kept, so the call can be retried.
+ * 
+ * @return ESP_OK on success, the stop or sensor error otherwise
  */
 esp_err_t obstacle_detection_deinit(void);
 
@@ -4,25 +4,178 @@
  */
 
 #include "obstacle_detection.h"
+#include "vl53l0x_adaptive.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include <stdatomic.h>
 #include <string.h>
 
 static const char *TAG = "OBSTACLE_DET";
 
+#define SCHEDULER_TASK_STACK        4096    // Same call depth as a sensor task: driver, ST API, user callback
+#define SCHEDULER_TASK_PRIORITY     5
+#define SCHEDULER_TRIGGER_GAP_US    1000    // Least spacing between two triggers (one bus burst at a time)
+#define SCHEDULER_POLL_US           1000    // Completion poll interval once a sample is due
+#define SCHEDULER_LOST_MARGIN_US    15000   // Past 2 budgets plus this the driver has given the shot up
+#define SCHEDULER_IDLE_MS           10      // Longest sleep, bounds the stop latency
+#define SCHEDULER_STOP_MS           500
+#define SNAPSHOT_RETRIES            16      // Torn reads retried before giving up
+
 typedef struct {
     vl53l0x_handle_t sensor;
     obstacle_zone_config_t config;
-    uint16_t last_distance;
     obstacle_event_t last_event;
+    vl53l0x_adaptive_t adaptive; // Mode policy, used when config.adaptive is set
+    obstacle_event_t window;     // Band the sensor thresholds are set around (threshold_wakeup)
+    bool window_set;
+    bool scheduled;              // Served by the scheduler task
+    bool hw_ranging;             // Scheduled zone ranging on its own, the scheduler only reads it out
+    bool pending;                // Single shot in flight, or hardware ranging running
+    uint32_t period_us;          // 1 / rate_hz, 0 = trigger again as soon as a sample is read
+    uint32_t budget_us;          // Timing budget of the current mode
+    int64_t next_trigger_us;     // Slot of the next trigger
+    int64_t trigger_us;          // When the pending shot was triggered
+    int64_t due_us;              // Next completion check of the pending shot
+    uint32_t samples;
+    uint32_t missed_slots;
 } zone_state_t;
 
+/**
+ * @brief Latest result of a zone, published under a sequence counter
+ * 
+ * Only the task ranging the zone writes it. Readers copy it and retry if
+ * the counter moved meanwhile, so they never hold up that task.
+ */
+typedef struct {
+    atomic_uint seq;             // Odd while the zone's task is writing
+    uint16_t distance_mm;        // Stays at the last sample while degraded
+    obstacle_event_t status;
+    int64_t timestamp_us;        // Sample distance_mm comes from, 0 = none yet
+} zone_record_t;
+
 static zone_state_t zones[ZONE_MAX];
+static zone_record_t records[ZONE_MAX];
 static size_t num_active_zones = 0;
 static obstacle_callback_t global_callback = NULL;
 static void* global_user_data = NULL;
 static bool is_running = false;
+static volatile int16_t commanded_speed_mm_s = 0;
+static TaskHandle_t scheduler_task = NULL;
+static int64_t start_us = 0;
+
+/**
+ * @brief Commanded speed toward what a zone's sensor sees
+ */
+static uint16_t approach_speed(obstacle_zone_t zone) {
+    int16_t speed = commanded_speed_mm_s;
+    
+    switch (zone) {
+        case ZONE_FRONT:
+        case ZONE_FRONT_LEFT:
+        case ZONE_FRONT_RIGHT:
+            return speed > 0 ? (uint16_t)speed : 0;
+        case ZONE_REAR:
+            return speed < 0 ? (uint16_t)(-speed) : 0;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Move the sensor thresholds to the edges of the band an event belongs to
+ * 
+ * Only samples leaving the band are read afterwards. Errors keep the
+ * current window: the heartbeat sample brings the zone back.
+ */
+static void update_threshold_window(zone_state_t* state, obstacle_event_t event) {
+    uint16_t low_mm, high_mm;
+    
+    switch (event) {
+        case OBSTACLE_EVENT_CRITICAL:
+            low_mm = 0;
+            high_mm = state->config.critical_distance_mm;
+            break;
+        case OBSTACLE_EVENT_WARNING:
+            low_mm = state->config.critical_distance_mm + 1;
+            high_mm = state->config.warning_distance_mm;
+            break;
+        case OBSTACLE_EVENT_CLEAR:
+            low_mm = state->config.warning_distance_mm + 1;
+            high_mm = VL53L0X_THRESHOLD_MAX_MM;
+            break;
+        default:
+            return;
+    }
+    
+    if (state->window_set && state->window == event) {
+        return;
+    }
+    if (vl53l0x_set_threshold_window(state->sensor, low_mm, high_mm) == ESP_OK) {
+        state->window = event;
+        state->window_set = true;
+    }
+}
+
+/**
+ * @brief Publish a zone's latest result (called only by the zone's task)
+ */
+static void publish_record(size_t zone, uint16_t distance_mm, obstacle_event_t status, int64_t timestamp_us) {
+    zone_record_t* record = &records[zone];
+    uint32_t seq = atomic_load_explicit(&record->seq, memory_order_relaxed);
+    
+    // Mark the record busy before touching the payload
+    atomic_store_explicit(&record->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    
+    record->distance_mm = distance_mm;
+    record->status = status;
+    record->timestamp_us = timestamp_us;
+    
+    atomic_store_explicit(&record->seq, seq + 2, memory_order_release);
+}
+
+/**
+ * @brief Copy the records of zones [first, first + count) as of one instant
+ * 
+ * Every counter is read, then every record, then every counter again. If
+ * none moved, no zone changed while copying, so the copies all held at
+ * once between the two passes.
+ * 
+ * @return false if writers kept getting in the way for SNAPSHOT_RETRIES attempts
+ */
+static bool read_records(size_t first, size_t count, obstacle_zone_snapshot_t* out) {
+    uint32_t before[ZONE_MAX];
+    
+    for (int attempt = 0; attempt < SNAPSHOT_RETRIES; attempt++) {
+        bool busy = false;
+        for (size_t i = 0; i < count; i++) {
+            before[i] = atomic_load_explicit(&records[first + i].seq, memory_order_acquire);
+            busy |= (before[i] & 1) != 0;
+        }
+        if (busy) {
+            continue;
+        }
+        
+        for (size_t i = 0; i < count; i++) {
+            const zone_record_t* record = &records[first + i];
+            out[i].distance_mm = record->distance_mm;
+            out[i].status = record->status;
+            out[i].timestamp_us = record->timestamp_us;
+        }
+        
+        atomic_thread_fence(memory_order_acquire);
+        bool stable = true;
+        for (size_t i = 0; i < count; i++) {
+            stable &= atomic_load_explicit(&records[first + i].seq, memory_order_relaxed) == before[i];
+        }
+        if (stable) {
+            return true;
+        }
+    }
+    return false;
+}
 
 static void sensor_callback(const vl53l0x_measurement_t* measurement, void* user_data) {
     obstacle_zone_t zone = (obstacle_zone_t)(uintptr_t)user_data;
@@ -30,11 +183,23 @@ static void sensor_callback(const vl53l0x_measurement_t* measurement, void* user
     if (zone >= num_active_zones) return;
     
     zone_state_t* state = &zones[zone];
-    state->last_distance = measurement->distance_mm;
+    state->samples++;
+    bool degraded = (measurement->health == VL53L0X_HEALTH_DEGRADED);
+    
+    if (state->config.adaptive) {
+        vl53l0x_mode_t previous = state->adaptive.mode;
+        vl53l0x_mode_t mode = vl53l0x_adaptive_update(&state->adaptive, measurement,
+                                                      approach_speed(state->config.zone));
+        if (mode != previous && vl53l0x_set_mode(state->sensor, mode) != ESP_OK) {
+            state->adaptive.mode = previous;
+        }
+    }
     
     obstacle_event_t event = OBSTACLE_EVENT_CLEAR;
     
-    if (!measurement->is_valid) {
+    if (degraded) {
+        event = OBSTACLE_EVENT_DEGRADED;
+    } else if (!measurement->is_valid) {
         event = OBSTACLE_EVENT_ERROR;
     } else if (measurement->distance_mm <= state->config.critical_distance_mm) {
         event = OBSTACLE_EVENT_CRITICAL;
@@ -42,18 +207,230 @@ static void sensor_callback(const vl53l0x_measurement_t* measurement, void* user
         event = OBSTACLE_EVENT_WARNING;
     }
     
+    // A degraded sensor leaves the last distance in place, aging
+    const zone_record_t* record = &records[zone];
+    publish_record(zone, degraded ? record->distance_mm : measurement->distance_mm, event,
+                   degraded ? record->timestamp_us : measurement->timestamp_us);
+    
+    if (state->config.threshold_wakeup) {
+        update_threshold_window(state, event);
+    }
+    
     if (event != state->last_event && global_callback) {
         global_callback(zone, measurement->distance_mm, event, global_user_data);
         state->last_event = event;
     }
 }
 
+/**
+ * @brief Report a failed single shot the way the continuous task would
+ * 
+ * Isolated failures are dropped; once the driver reports the sensor
+ * degraded each failure reaches the zone as a degraded placeholder.
+ */
+static void report_failure(size_t zone, int64_t now_us) {
+    vl53l0x_health_t health = VL53L0X_HEALTH_OK;
+    vl53l0x_get_health(zones[zone].sensor, &health);
+    if (health != VL53L0X_HEALTH_DEGRADED) {
+        return;
+    }
+    
+    vl53l0x_measurement_t measurement = {
+        .timestamp_us = now_us,
+        .health = VL53L0X_HEALTH_DEGRADED,
+    };
+    sensor_callback(&measurement, (void*)(uintptr_t)zone);
+}
+
+/**
+ * @brief Check the pending shot of a zone and process it once complete
+ */
+static void service_pending(size_t zone, int64_t now_us) {
+    zone_state_t* state = &zones[zone];
+    vl53l0x_measurement_t measurement;
+    esp_err_t ret = ESP_OK;
+    bool done = false;
+    
+    if (vl53l0x_poll_single(state->sensor, &done) != ESP_OK || !done) {
+        if (now_us < state->trigger_us + 2 * (int64_t)state->budget_us + SCHEDULER_LOST_MARGIN_US) {
+            state->due_us = now_us + SCHEDULER_POLL_US;
+            return;
+        }
+        // Past the driver's deadline: one last check, then it drops the shot
+        ret = vl53l0x_wait_single(state->sensor, 0);
+    }
+    
+    state->pending = false;
+    if (ret == ESP_OK) {
+        ret = vl53l0x_fetch_single(state->sensor, &measurement);
+    }
+    if (ret == ESP_OK) {
+        measurement.health = VL53L0X_HEALTH_OK;
+        sensor_callback(&measurement, (void*)(uintptr_t)zone);
+        if (state->config.adaptive) {
+            vl53l0x_get_timing_budget(state->sensor, &state->budget_us);
+        }
+    } else {
+        report_failure(zone, now_us);
+    }
+}
+
+/**
+ * @brief Time between two samples of a zone ranging on its own
+ */
+static int64_t sample_interval_us(const zone_state_t* state) {
+    return state->period_us > state->budget_us ? state->period_us : state->budget_us;
+}
+
+/**
+ * @brief Read out the sample of a hardware ranging zone once there is one
+ * 
+ * The next check comes one poll interval before the sample is expected,
+ * so a sensor running slightly fast is not read a sample late.
+ */
+static void service_ranging(size_t zone, int64_t now_us) {
+    zone_state_t* state = &zones[zone];
+    vl53l0x_measurement_t measurement;
+    bool ready = false;
+    
+    esp_err_t ret = vl53l0x_poll_ranging(state->sensor, &measurement, &ready);
+    if (ret == ESP_OK && !ready) {
+        state->due_us = now_us + SCHEDULER_POLL_US;
+        return;
+    }
+    
+    if (ret == ESP_OK) {
+        sensor_callback(&measurement, (void*)(uintptr_t)zone);
+        if (state->config.adaptive) {
+            vl53l0x_get_timing_budget(state->sensor, &state->budget_us);
+        }
+        state->due_us = measurement.timestamp_us + sample_interval_us(state) - SCHEDULER_POLL_US;
+    } else {
+        // The driver has restarted ranging
+        report_failure(zone, now_us);
+        state->due_us = now_us + sample_interval_us(state);
+    }
+}
+
+/**
+ * @brief Trigger the next shot of a zone and move it to its next slot
+ * 
+ * A hardware ranging zone is started instead, once, at its first slot.
+ */
+static void trigger_zone(size_t zone, int64_t now_us) {
+    zone_state_t* state = &zones[zone];
+    
+    state->trigger_us = now_us;
+    if (state->hw_ranging && vl53l0x_start_ranging(state->sensor) == ESP_OK) {
+        state->pending = true;
+        state->due_us = now_us + sample_interval_us(state) - SCHEDULER_POLL_US;
+    } else if (!state->hw_ranging && vl53l0x_trigger_single(state->sensor) == ESP_OK) {
+        state->pending = true;
+        state->due_us = now_us + state->budget_us;
+    } else {
+        report_failure(zone, now_us);
+    }
+    
+    if (state->period_us == 0) {
+        state->next_trigger_us = now_us;
+        return;
+    }
+    state->next_trigger_us += state->period_us;
+    while (state->next_trigger_us <= now_us) {
+        state->next_trigger_us += state->period_us;
+        state->missed_slots++;
+    }
+}
+
+/**
+ * @brief Ranging scheduler for every scheduled zone
+ * 
+ * Each pass reads out the zones whose sample is due, then triggers (or
+ * starts) the zones whose slot has come, at least SCHEDULER_TRIGGER_GAP_US
+ * apart, and sleeps until the earliest next event.
+ */
+static void scheduler_task_fn(void* arg) {
+    int64_t last_trigger_us = 0;
+    
+    while (is_running) {
+        int64_t now_us = esp_timer_get_time();
+        int64_t wake_us = now_us + SCHEDULER_IDLE_MS * 1000;
+        
+        for (size_t i = 0; i < num_active_zones; i++) {
+            zone_state_t* state = &zones[i];
+            if (!state->scheduled) continue;
+            
+            if (state->pending && now_us >= state->due_us) {
+                if (state->hw_ranging) {
+                    service_ranging(i, now_us);
+                } else {
+                    service_pending(i, now_us);
+                }
+                now_us = esp_timer_get_time();
+            }
+            
+            if (state->pending) {
+                // Still ranging: its slots pass by (a ranging sensor keeps its own time)
+                while (!state->hw_ranging && state->period_us && state->next_trigger_us <= now_us) {
+                    state->next_trigger_us += state->period_us;
+                    state->missed_slots++;
+                }
+            } else if (now_us >= state->next_trigger_us) {
+                if (now_us >= last_trigger_us + SCHEDULER_TRIGGER_GAP_US) {
+                    trigger_zone(i, now_us);
+                    last_trigger_us = now_us;
+                    now_us = esp_timer_get_time();
+                } else if (last_trigger_us + SCHEDULER_TRIGGER_GAP_US < wake_us) {
+                    wake_us = last_trigger_us + SCHEDULER_TRIGGER_GAP_US;
+                }
+            }
+            
+            int64_t event_us = state->pending ? state->due_us : state->next_trigger_us;
+            if (event_us < wake_us) {
+                wake_us = event_us;
+            }
+        }
+        
+        const int64_t tick_us = (int64_t)portTICK_PERIOD_MS * 1000;
+        int64_t remaining_us = wake_us - esp_timer_get_time();
+        if (remaining_us > 0) {
+            TickType_t ticks = (TickType_t)(remaining_us / tick_us);
+            vTaskDelay(ticks > 0 ? ticks : 1);
+        }
+    }
+    
+    // Leave every sensor idle with nothing pending
+    for (size_t i = 0; i < num_active_zones; i++) {
+        if (!zones[i].scheduled || !zones[i].pending) continue;
+        
+        if (zones[i].hw_ranging) {
+            vl53l0x_stop_ranging(zones[i].sensor);
+        } else {
+            vl53l0x_measurement_t measurement;
+            vl53l0x_wait_single(zones[i].sensor, SCHEDULER_STOP_MS);
+            vl53l0x_fetch_single(zones[i].sensor, &measurement);
+        }
+        zones[i].pending = false;
+    }
+    
+    scheduler_task = NULL;
+    vTaskDelete(NULL);
+}
+
 esp_err_t obstacle_detection_init(const obstacle_zone_config_t* zone_configs, size_t num_zones) {
     if (!zone_configs || num_zones == 0 || num_zones > ZONE_MAX) {
         return ESP_ERR_INVALID_ARG;
     }
     
+    vl53l0x_config_t sensor_configs[ZONE_MAX];
+    vl53l0x_handle_t sensors[ZONE_MAX];
+    size_t zone_of[ZONE_MAX];
+    size_t num_sensors = 0;
+    
     memset(zones, 0, sizeof(zones));
+    for (size_t i = 0; i < ZONE_MAX; i++) {
+        publish_record(i, 0, OBSTACLE_EVENT_CLEAR, 0);
+    }
     num_active_zones = num_zones;
     
     for (size_t i = 0; i < num_zones; i++) {
@@ -61,21 +438,70 @@ esp_err_t obstacle_detection_init(const obstacle_zone_config_t* zone_configs, si
         
         if (!zone_configs[i].enabled) continue;
         
+        // The adaptive policy needs every sample
+        if (zone_configs[i].threshold_wakeup && zone_configs[i].adaptive) {
+            ESP_LOGE(TAG, "Zone %s: threshold wakeup and adaptive mode are exclusive",
+                     obstacle_detection_get_zone_name(zone_configs[i].zone));
+            return ESP_ERR_INVALID_ARG;
+        }
+        
         vl53l0x_config_t sensor_config = {
             .scl_pin = zone_configs[i].scl_pin,
             .sda_pin = zone_configs[i].sda_pin,
             .i2c_freq_hz = 400000,
             .mode = zone_configs[i].mode,
-            .i2c_address = 0x29 + i  // Different address per sensor
+            .fixed_mode = !zone_configs[i].adaptive,   // Only adaptive zones switch modes
+            .i2c_address = 0x29 + i,  // Different address per sensor
+            .xshut_pin = zone_configs[i].xshut_pin,
+            .gpio_int_pin = zone_configs[i].gpio_int_pin,
+            .target_rate_hz = zone_configs[i].rate_hz,
+            .threshold_heartbeat_ms = 0,
+            .history_depth = 2,     // Zones consume samples through the callback only
+#ifdef VL53L0X_SIMULATOR
+            .simulator = zone_configs[i].simulator,
+#endif
         };
+        sensor_configs[num_sensors] = sensor_config;
+        zone_of[num_sensors++] = i;
+    }
+    
+    // Sensors come up one at a time, then calibrate concurrently
+    esp_err_t ret = ESP_OK;
+    if (num_sensors > 0) {
+        ret = vl53l0x_init_multi(sensor_configs, num_sensors, sensors);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to init zone sensors: %s", esp_err_to_name(ret));
+        num_active_zones = 0;
+        return ret;
+    }
+    
+    for (size_t n = 0; n < num_sensors; n++) {
+        size_t i = zone_of[n];
+        zones[i].sensor = sensors[n];
         
-        esp_err_t ret = vl53l0x_init(&sensor_config, &zones[i].sensor);
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to init sensor for zone %d", zone_configs[i].zone);
-            return ret;
+        // Report every sample until the first one places the zone in a band
+        if (zone_configs[i].threshold_wakeup) {
+            ret = vl53l0x_set_threshold_window(zones[i].sensor, 0, 0);
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to arm thresholds for zone %d", zone_configs[i].zone);
+                return ret;
+            }
         }
         
-        ESP_LOGI(TAG, "Initialized zone %s", obstacle_detection_get_zone_name(zone_configs[i].zone));
+        vl53l0x_adaptive_config_t adaptive_config = VL53L0X_ADAPTIVE_DEFAULT_CONFIG();
+        adaptive_config.critical_distance_mm = zone_configs[i].critical_distance_mm;
+        vl53l0x_adaptive_init(&zones[i].adaptive, &adaptive_config, zone_configs[i].mode);
+        
+        // The sensor has to range on its own to filter by thresholds or group shots
+        zones[i].scheduled = !zone_configs[i].threshold_wakeup &&
+                             zone_configs[i].mode != VL53L0X_MODE_MULTI_SHOT;
+        zones[i].period_us = zone_configs[i].rate_hz ? 1000000 / zone_configs[i].rate_hz : 0;
+        
+        vl53l0x_footprint_t footprint = {0};
+        vl53l0x_get_footprint(zones[i].sensor, &footprint);
+        ESP_LOGI(TAG, "Initialized zone %s (%lu bytes of sensor state)",
+                 obstacle_detection_get_zone_name(zone_configs[i].zone), (unsigned long)footprint.total_bytes);
     }
     
     return ESP_OK;
@@ -86,45 +512,177 @@ esp_err_t obstacle_detection_start(obstacle_callback_t callback, void* user_data
         return ESP_ERR_INVALID_ARG;
     }
     
+    if (is_running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
     global_callback = callback;
     global_user_data = user_data;
-    is_running = true;
+    start_us = esp_timer_get_time();
     
+    // Single shots keep every zone in its own slot, which only pays off when
+    // the slots can hold the zones' budgets. Otherwise the zones share ranging
+    // time anyway and the sensors range on their own: a sample then costs 3
+    // transfers instead of a single shot's ~14.
+    size_t num_scheduled = 0;
+    bool unlimited = false;
+    float load = 0.0f;
     for (size_t i = 0; i < num_active_zones; i++) {
-        if (!zones[i].config.enabled) continue;
+        zone_state_t* state = &zones[i];
+        if (!state->config.enabled || !state->scheduled) continue;
+        
+        vl53l0x_get_timing_budget(state->sensor, &state->budget_us);
+        if (state->period_us) {
+            load += (float)state->budget_us / state->period_us;
+        } else {
+            unlimited = true;
+        }
+        num_scheduled++;
+    }
+    bool single_shots = num_scheduled > 1 && !unlimited && load <= 1.0f;
+    
+    // Spread the scheduled zones' first triggers (or ranging starts) evenly over their periods
+    size_t slot = 0;
+    for (size_t i = 0; i < num_active_zones; i++) {
+        zone_state_t* state = &zones[i];
+        state->samples = 0;
+        state->missed_slots = 0;
+        if (!state->config.enabled) continue;
         
-        vl53l0x_start_continuous(zones[i].sensor, sensor_callback, (void*)(uintptr_t)i);
+        if (!state->scheduled) {
+            vl53l0x_start_continuous(state->sensor, sensor_callback, (void*)(uintptr_t)i);
+            continue;
+        }
+        state->hw_ranging = !single_shots;
+        uint32_t spacing_us = (state->period_us ? state->period_us : state->budget_us) / num_scheduled;
+        state->next_trigger_us = start_us + (int64_t)slot++ * spacing_us;
+        state->pending = false;
     }
     
-    ESP_LOGI(TAG, "Obstacle detection started");
+    is_running = true;
+    if (num_scheduled > 0 &&
+        xTaskCreate(scheduler_task_fn, "obstacle_sched", SCHEDULER_TASK_STACK, NULL,
+                    SCHEDULER_TASK_PRIORITY, &scheduler_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create the ranging scheduler");
+        obstacle_detection_stop();
+        return ESP_ERR_NO_MEM;
+    }
+    
+    ESP_LOGI(TAG, "Obstacle detection started (%u zones on the scheduler, %s)", (unsigned)num_scheduled,
+             single_shots ? "single shots" : "hardware ranging");
     return ESP_OK;
 }
 
 esp_err_t obstacle_detection_stop(void) {
     is_running = false;
     
+    // The scheduler finishes its pass and drains the shots in flight
+    TickType_t timeout = pdMS_TO_TICKS(SCHEDULER_IDLE_MS + SCHEDULER_STOP_MS + 100);
+    TickType_t start = xTaskGetTickCount();
+    while (scheduler_task && (xTaskGetTickCount() - start) < timeout) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    
+    esp_err_t ret = scheduler_task ? ESP_ERR_TIMEOUT : ESP_OK;
     for (size_t i = 0; i < num_active_zones; i++) {
-        if (zones[i].sensor) {
-            vl53l0x_stop_continuous(zones[i].sensor);
+        if (zones[i].sensor && !zones[i].scheduled) {
+            esp_err_t err = vl53l0x_stop_continuous(zones[i].sensor);
+            if (err != ESP_OK) {
+                ret = err;
+            }
+        }
+    }
+    
+    return ret;
+}
+
+esp_err_t obstacle_detection_get_stats(obstacle_detection_stats_t* stats) {
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    memset(stats, 0, sizeof(*stats));
+    float elapsed_s = (esp_timer_get_time() - start_us) / 1e6f;
+    
+    if (scheduler_task) {
+        stats->tasks++;
+        stats->stack_bytes += SCHEDULER_TASK_STACK;
+    }
+    for (size_t i = 0; i < num_active_zones; i++) {
+        obstacle_zone_stats_t* zone = &stats->zones[i];
+        zone->samples = zones[i].samples;
+        zone->rate_hz = (start_us && elapsed_s > 0.0f) ? zone->samples / elapsed_s : 0.0f;
+        zone->missed_slots = zones[i].missed_slots;
+        zone->scheduled = zones[i].scheduled;
+        
+        vl53l0x_footprint_t footprint;
+        if (zones[i].sensor && vl53l0x_get_footprint(zones[i].sensor, &footprint) == ESP_OK &&
+            footprint.task_stack_bytes > 0) {
+            stats->tasks++;
+            stats->stack_bytes += footprint.task_stack_bytes;
         }
     }
     
     return ESP_OK;
 }
 
+esp_err_t obstacle_detection_set_speed(int16_t speed_mm_s) {
+    commanded_speed_mm_s = speed_mm_s;
+    return ESP_OK;
+}
+
 esp_err_t obstacle_detection_get_distance(obstacle_zone_t zone, uint16_t* distance_mm) {
     if (zone >= num_active_zones || !distance_mm) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    *distance_mm = zones[zone].last_distance;
+    obstacle_zone_snapshot_t record;
+    if (!read_records(zone, 1, &record)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    
+    *distance_mm = record.distance_mm;
+    return ESP_OK;
+}
+
+esp_err_t obstacle_detection_get_snapshot(obstacle_snapshot_t* snapshot) {
+    if (!snapshot) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    size_t count = num_active_zones;
+    if (!read_records(0, count, snapshot->zones)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    
+    snapshot->num_zones = (uint8_t)count;
+    snapshot->taken_us = esp_timer_get_time();
+    for (size_t i = 0; i < count; i++) {
+        obstacle_zone_snapshot_t* zone = &snapshot->zones[i];
+        int64_t age_us = snapshot->taken_us - zone->timestamp_us;
+        zone->age_us = (zone->timestamp_us == 0 || age_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)age_us;
+    }
+    
     return ESP_OK;
 }
 
+/**
+ * @brief Clear test on a published record: a degraded zone is never clear
+ */
+static bool record_is_clear(size_t zone, const obstacle_zone_snapshot_t* record) {
+    return record->status != OBSTACLE_EVENT_DEGRADED &&
+           record->distance_mm > zones[zone].config.warning_distance_mm;
+}
+
 bool obstacle_detection_is_path_clear(void) {
-    for (size_t i = 0; i < num_active_zones; i++) {
+    obstacle_snapshot_t snapshot;
+    if (obstacle_detection_get_snapshot(&snapshot) != ESP_OK) {
+        return false;
+    }
+    
+    for (size_t i = 0; i < snapshot.num_zones; i++) {
         if (!zones[i].config.enabled) continue;
-        if (zones[i].last_distance <= zones[i].config.warning_distance_mm) {
+        if (!record_is_clear(i, &snapshot.zones[i])) {
             return false;
         }
     }
@@ -133,7 +691,9 @@ bool obstacle_detection_is_path_clear(void) {
 
 bool obstacle_detection_is_zone_clear(obstacle_zone_t zone) {
     if (zone >= num_active_zones) return false;
-    return zones[zone].last_distance > zones[zone].config.warning_distance_mm;
+    
+    obstacle_zone_snapshot_t record;
+    return read_records(zone, 1, &record) && record_is_clear(zone, &record);
 }
 
 const char* obstacle_detection_get_zone_name(obstacle_zone_t zone) {
@@ -149,14 +709,28 @@ const char* obstacle_detection_get_zone_name(obstacle_zone_t zone) {
 }
 
 esp_err_t obstacle_detection_deinit(void) {
-    obstacle_detection_stop();
+    // Sensors are only freed once nothing ranges them any more
+    esp_err_t ret = obstacle_detection_stop();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Ranging did not stop, zones kept: %s", esp_err_to_name(ret));
+        return ret;
+    }
     
     for (size_t i = 0; i < num_active_zones; i++) {
         if (zones[i].sensor) {
-            vl53l0x_deinit(zones[i].sensor);
+            esp_err_t err = vl53l0x_deinit(zones[i].sensor);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to deinit zone %s: %s",
+                         obstacle_detection_get_zone_name(zones[i].config.zone), esp_err_to_name(err));
+                ret = err;
+                continue;
+            }
+            zones[i].sensor = NULL;
         }
     }
     
-    num_active_zones = 0;
-    return ESP_OK;
+    if (ret == ESP_OK) {
+        num_active_zones = 0;
+    }
+    return ret;
 }
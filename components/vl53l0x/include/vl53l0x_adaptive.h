@@ -0,0 +1,88 @@
+/**
+ * @file vl53l0x_adaptive.h
+ * @brief Speed- and distance-adaptive mode selection for VL53L0X sensors
+ *
+ * Picks the operation mode (and so the timing budget) for the next samples
+ * from the last distance, its rate of change and the commanded speed of the
+ * vehicle: short budgets when the target is far or closing fast, long ones
+ * only when the vehicle is stopped close to something.
+ */
+
+#ifndef VL53L0X_ADAPTIVE_H
+#define VL53L0X_ADAPTIVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "vl53l0x_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Adaptive policy parameters
+ */
+typedef struct {
+    uint16_t critical_distance_mm;   /*!< Distance at which the vehicle must have stopped */
+    uint16_t precision_distance_mm;  /*!< HIGH_ACCURACY only closer than this, and only when stopped */
+    uint16_t far_distance_mm;        /*!< Beyond this (or with no target) at most HIGH_SPEED */
+    uint16_t still_speed_mm_s;       /*!< Closing speeds below this count as stopped */
+    uint16_t speed_window_ms;        /*!< Baseline of the closing speed estimate */
+    float travel_per_sample;         /*!< Share of the remaining margin the vehicle may cover in one sample */
+} vl53l0x_adaptive_config_t;
+
+/**
+ * @brief Default adaptive policy
+ */
+#define VL53L0X_ADAPTIVE_DEFAULT_CONFIG() { \
+    .critical_distance_mm = 50,             \
+    .precision_distance_mm = 300,           \
+    .far_distance_mm = 1000,                \
+    .still_speed_mm_s = 50,                 \
+    .speed_window_ms = 100,                 \
+    .travel_per_sample = 0.1f,              \
+}
+
+/**
+ * @brief Adaptive policy state (one per sensor)
+ */
+typedef struct {
+    vl53l0x_adaptive_config_t config;
+    vl53l0x_mode_t mode;             /*!< Mode selected by the last update */
+    bool has_reference;              /*!< ref_* hold a valid sample */
+    uint16_t ref_distance_mm;        /*!< Start of the current speed window */
+    int64_t ref_timestamp_us;
+    float closing_speed_mm_s;        /*!< Approach speed measured by the sensor (positive = closing) */
+} vl53l0x_adaptive_t;
+
+/**
+ * @brief Initialize the policy state
+ *
+ * @param ctl State to initialize
+ * @param config Policy parameters
+ * @param initial_mode Mode the sensor was initialized with
+ */
+void vl53l0x_adaptive_init(vl53l0x_adaptive_t* ctl, const vl53l0x_adaptive_config_t* config,
+                           vl53l0x_mode_t initial_mode);
+
+/**
+ * @brief Feed one sample and get the mode for the next ones
+ *
+ * Pure computation, no I/O: apply the result with vl53l0x_set_mode() when
+ * it differs from the current mode. Moving to a shorter budget is
+ * immediate; moving to a longer one needs some margin, so the choice does
+ * not flap on noise.
+ *
+ * @param ctl Policy state
+ * @param measurement Latest sample (invalid samples count as no target)
+ * @param approach_speed_mm_s Commanded vehicle speed toward what this sensor sees
+ * @return Mode to use
+ */
+vl53l0x_mode_t vl53l0x_adaptive_update(vl53l0x_adaptive_t* ctl, const vl53l0x_measurement_t* measurement,
+                                       uint16_t approach_speed_mm_s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VL53L0X_ADAPTIVE_H
@@ -10,9 +10,13 @@
 #define VL53L0X_DRIVER_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include <stdbool.h>
 #include "esp_err.h"
 #include "driver/gpio.h"
+#ifdef VL53L0X_SIMULATOR
+#include "vl53l0x_sim.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -25,9 +29,21 @@ typedef enum {
     VL53L0X_MODE_DEFAULT,        /*!< Default mode (~30ms, ±3%) */
     VL53L0X_MODE_HIGH_ACCURACY,  /*!< High accuracy mode (~200ms, ±1%) */
     VL53L0X_MODE_HIGH_SPEED,     /*!< High speed mode (~20ms, ±3%) */
-    VL53L0X_MODE_LONG_RANGE      /*!< Long range mode (~33ms, up to 2m) */
+    VL53L0X_MODE_LONG_RANGE,     /*!< Long range mode (~33ms, up to 2m) */
+    VL53L0X_MODE_ULTRA_FAST,     /*!< Ultra fast mode (~8ms, ±8%, up to ~1m): TCC/MSRC/DSS off */
+    VL53L0X_MODE_MULTI_SHOT      /*!< Up to multi_shot_count 20 ms shots combined into one sample */
 } vl53l0x_mode_t;
 
+/**
+ * @brief Most shots combined into one MULTI_SHOT sample
+ */
+#define VL53L0X_MULTI_SHOT_MAX 16
+
+/**
+ * @brief Largest distance a threshold window can express (12-bit register, 2 mm steps)
+ */
+#define VL53L0X_THRESHOLD_MAX_MM 8190
+
 /**
  * @brief VL53L0X configuration structure
  */
@@ -36,14 +52,63 @@ typedef struct {
     gpio_num_t sda_pin;          /*!< I2C SDA pin */
     uint32_t i2c_freq_hz;        /*!< I2C frequency in Hz (typically 400000) */
     vl53l0x_mode_t mode;         /*!< Operation mode */
-    uint8_t i2c_address;         /*!< I2C address (default 0x29) */
+    bool fixed_mode;             /*!< The mode never changes: skip the mode presets (about 300 bytes
+                                      and their capture at init). vl53l0x_set_mode() then only
+                                      moves between HIGH_SPEED and MULTI_SHOT */
+    uint8_t i2c_address;         /*!< I2C address (default 0x29); other values are assigned at init */
+    gpio_num_t xshut_pin;        /*!< Sensor XSHUT (reset) pin, GPIO_NUM_NC if tied high */
+    gpio_num_t gpio_int_pin;     /*!< Sensor GPIO1 (data ready) pin, GPIO_NUM_NC to poll over I2C */
+    uint16_t target_rate_hz;     /*!< Continuous rate in Hz, 0 = as fast as the timing budget allows */
+    bool cache_calibration;      /*!< Reuse reference calibration stored in NVS (needs nvs_flash_init) */
+    bool force_recalibration;    /*!< Recalibrate even if a cached record exists (drops it, then stores the new one) */
+#ifdef VL53L0X_SIMULATOR
+    vl53l0x_sim_handle_t simulator; /*!< Simulated sensor to use instead of the I2C bus, NULL for hardware */
+#endif
+    uint8_t multi_shot_count;    /*!< MULTI_SHOT: shots per sample (2 - VL53L0X_MULTI_SHOT_MAX, 0 = 8) */
+    float multi_shot_target_sd_mm; /*!< MULTI_SHOT: stop early once the estimated standard deviation
+                                      is below this (0 = always take every shot). Saves time on
+                                      easy targets but costs some precision: the estimate from
+                                      few shots is itself noisy */
+    uint16_t threshold_heartbeat_ms; /*!< Threshold window: longest gap between reported samples,
+                                      so a dead sensor still shows up (0 = 250) */
+    uint8_t history_depth;       /*!< Samples kept for readers, rounded up to a power of two
+                                      (2 - 128, 0 = 32) */
 } vl53l0x_config_t;
 
+/**
+ * @brief Default configuration for VL53L0X
+ */
+#define VL53L0X_DEFAULT_CONFIG() {          \
+    .scl_pin = GPIO_NUM_5,                  \
+    .sda_pin = GPIO_NUM_6,                  \
+    .i2c_freq_hz = 400000,                  \
+    .mode = VL53L0X_MODE_DEFAULT,           \
+    .fixed_mode = false,                    \
+    .i2c_address = 0x29,                    \
+    .xshut_pin = GPIO_NUM_NC,               \
+    .gpio_int_pin = GPIO_NUM_NC,            \
+    .target_rate_hz = 0,                    \
+    .cache_calibration = false,             \
+    .force_recalibration = false,           \
+    .multi_shot_count = 8,                  \
+    .multi_shot_target_sd_mm = 0.0f,        \
+    .threshold_heartbeat_ms = 250,          \
+    .history_depth = 32,                    \
+}
+
 /**
  * @brief VL53L0X handle (opaque)
  */
 typedef struct vl53l0x_handle_s* vl53l0x_handle_t;
 
+/**
+ * @brief Sensor health as seen by the driver
+ */
+typedef enum {
+    VL53L0X_HEALTH_OK,           /*!< Samples are completing */
+    VL53L0X_HEALTH_DEGRADED,     /*!< Consecutive samples failed; the driver keeps recovering */
+} vl53l0x_health_t;
+
 /**
  * @brief Measurement data structure
  */
@@ -53,8 +118,84 @@ typedef struct {
     float signal_rate_mcps;      /*!< Signal rate in MCPS */
     float ambient_rate_mcps;     /*!< Ambient rate in MCPS */
     bool is_valid;               /*!< True if measurement is valid */
+    int64_t timestamp_us;        /*!< esp_timer time the sample was seen complete */
+    uint32_t seq;                /*!< Per-sensor sample sequence number */
+    vl53l0x_health_t health;     /*!< DEGRADED for the placeholder reported when samples fail */
+    uint8_t shots;               /*!< Ranging shots combined into this sample (1 outside MULTI_SHOT) */
+    float variance_mm2;          /*!< Estimated variance of distance_mm (MULTI_SHOT only, 0 otherwise) */
 } vl53l0x_measurement_t;
 
+/**
+ * @brief Read cursor into a sensor's sample history
+ * 
+ * Each consumer owns one; any number of readers may drain the same sensor.
+ */
+typedef struct {
+    uint32_t next_seq;           /*!< Sequence number of the next sample to read */
+    uint32_t dropped;            /*!< Samples lost because the reader fell behind */
+} vl53l0x_reader_t;
+
+/**
+ * @brief Per-bus I2C utilization report
+ */
+typedef struct {
+    int port;                    /*!< I2C controller number */
+    gpio_num_t scl_pin;          /*!< SCL pin of the bus */
+    gpio_num_t sda_pin;          /*!< SDA pin of the bus */
+    uint8_t num_devices;         /*!< Sensors attached to the bus */
+    uint32_t transactions;       /*!< Completed transfers in the window */
+    uint32_t errors;             /*!< Failed transfers in the window */
+    uint32_t recoveries;         /*!< Bus recoveries in the window */
+    uint64_t bytes;              /*!< Bytes transferred in the window */
+    uint64_t busy_us;            /*!< Time the bus spent transferring */
+    uint64_t window_us;          /*!< Length of the accounting window */
+    float utilization;           /*!< busy_us / window_us (0.0 - 1.0) */
+} vl53l0x_bus_stats_t;
+
+/**
+ * @brief Completion wait counters (per sensor)
+ */
+typedef struct {
+    uint32_t measurements;               /*!< Completed waits */
+    uint32_t data_ready_polls;           /*!< Data ready register reads over all waits */
+    uint32_t max_polls_per_measurement;  /*!< Worst single wait */
+    uint32_t timeouts;                   /*!< Waits that hit the sensor deadline (a caller's shorter
+                                              vl53l0x_wait_single() timeout does not count) */
+} vl53l0x_wait_stats_t;
+
+/**
+ * @brief Mode switch counters (per sensor)
+ * 
+ * Durations cover the whole vl53l0x_set_mode() call under the sensor lock,
+ * including stopping and restarting continuous ranging.
+ */
+typedef struct {
+    uint32_t switches;           /*!< Mode changes applied */
+    uint32_t last_registers;     /*!< Registers written by the last switch */
+    uint32_t last_us;            /*!< Duration of the last switch */
+    uint32_t max_us;             /*!< Slowest switch */
+    uint64_t total_us;           /*!< Sum of switch durations */
+} vl53l0x_mode_stats_t;
+
+/**
+ * @brief RAM held by one sensor (per sensor)
+ * 
+ * Heap blocks are counted at their requested size, without allocator
+ * overhead.
+ */
+typedef struct {
+    uint32_t handle_bytes;       /*!< Driver state, ST device state included */
+    uint32_t device_bytes;       /*!< ST device state alone */
+    uint32_t history_bytes;      /*!< Sample history (config.history_depth slots) */
+    uint32_t multi_shot_bytes;   /*!< MULTI_SHOT group buffer, 0 until the mode is used */
+    uint32_t presets_bytes;      /*!< Mode presets and switch counters, 0 with config.fixed_mode */
+    uint32_t async_bytes;        /*!< Async single shot state, 0 until vl53l0x_trigger_single() */
+    uint32_t wait_stats_bytes;   /*!< Polling counters, 0 until vl53l0x_reset_wait_stats() */
+    uint32_t lock_bytes;         /*!< Sensor mutex */
+    uint32_t task_stack_bytes;   /*!< Continuous task stack, 0 while not ranging continuously */
+    uint32_t total_bytes;        /*!< Sum of the above, device_bytes counted once */
+} vl53l0x_footprint_t;
+
 /**
  * @brief Callback function for continuous measurements
  * 
@@ -66,24 +207,114 @@ typedef void (*vl53l0x_measurement_cb_t)(const vl53l0x_measurement_t* measuremen
 /**
  * @brief Initialize VL53L0X sensor
  * 
+ * With an XSHUT pin the sensor is reset first. A sensor out of reset
+ * answers at 0x29; any other config.i2c_address is then programmed into
+ * it, so no other sensor on the bus may be at 0x29 at that point.
+ * 
  * @param config Pointer to configuration structure
  * @param handle Pointer to store sensor handle
  * @return ESP_OK on success, error code otherwise
  */
 esp_err_t vl53l0x_init(const vl53l0x_config_t* config, vl53l0x_handle_t* handle);
 
+/**
+ * @brief Initialize several sensors, calibrating them concurrently
+ * 
+ * Every sensor with an XSHUT pin is held in reset, then the sensors are
+ * released and moved to their addresses one at a time, so they can share
+ * a bus. Data init, tuning, reference calibration and mode capture then
+ * run in one worker task per sensor: total time is about that of the
+ * slowest sensor instead of the sum. Sensors without XSHUT must be alone
+ * on their bus or already at their address.
+ * 
+ * @param configs Array of configurations
+ * @param count Number of sensors
+ * @param handles Array to store the handles, in config order
+ * @return ESP_OK when every sensor is up; otherwise none is left
+ *         initialized and the first error is returned
+ */
+esp_err_t vl53l0x_init_multi(const vl53l0x_config_t* configs, size_t count, vl53l0x_handle_t* handles);
+
 /**
  * @brief Perform single distance measurement
  * 
+ * In VL53L0X_MODE_MULTI_SHOT this takes the configured shots back to back
+ * and returns their combination.
+ * 
  * @param handle Sensor handle
  * @param measurement Pointer to store measurement data
  * @return ESP_OK on success, error code otherwise
  */
 esp_err_t vl53l0x_read_single(vl53l0x_handle_t handle, vl53l0x_measurement_t* measurement);
 
+/**
+ * @brief Start a single measurement without waiting for it
+ * 
+ * The handle mutex is only held while the start command goes out; the
+ * caller is free until vl53l0x_poll_single() or vl53l0x_wait_single()
+ * reports completion, then collects the sample with vl53l0x_fetch_single().
+ * One measurement can be in flight per sensor, and the calls should come
+ * from the same task. In VL53L0X_MODE_MULTI_SHOT this is one shot. The
+ * first call allocates the 16 bytes that track the measurement.
+ * 
+ * @param handle Sensor handle
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if a measurement is
+ *         already pending or continuous mode is running, ESP_ERR_NO_MEM
+ */
+esp_err_t vl53l0x_trigger_single(vl53l0x_handle_t handle);
+
+/**
+ * @brief Check whether the triggered measurement has completed
+ * 
+ * Never blocks. With a GPIO1 pin configured no I2C traffic is generated.
+ * 
+ * @param handle Sensor handle
+ * @param done Pointer to store completion status
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if nothing is pending
+ */
+esp_err_t vl53l0x_poll_single(vl53l0x_handle_t handle, bool* done);
+
+/**
+ * @brief Wait for the triggered measurement to complete
+ * 
+ * Sleeps rather than spinning and does not hold the handle mutex while
+ * sleeping. If the sensor does not finish within twice its timing budget
+ * the measurement is dropped, counts as a failed sample for
+ * vl53l0x_get_health(), and a new one may be triggered. A timeout of 0
+ * checks without sleeping.
+ * 
+ * @param handle Sensor handle
+ * @param timeout_ms Maximum time to wait
+ * @return ESP_OK when the sample is ready, ESP_ERR_TIMEOUT otherwise,
+ *         ESP_ERR_INVALID_STATE if nothing is pending or the sample was
+ *         fetched or dropped by another caller during the wait
+ */
+esp_err_t vl53l0x_wait_single(vl53l0x_handle_t handle, uint32_t timeout_ms);
+
+/**
+ * @brief Read out the triggered measurement
+ * 
+ * @param handle Sensor handle
+ * @param measurement Pointer to store measurement data
+ * @return ESP_OK on success, ESP_ERR_NOT_FINISHED if the sample is not
+ *         ready yet, ESP_ERR_INVALID_STATE if nothing is pending
+ */
+esp_err_t vl53l0x_fetch_single(vl53l0x_handle_t handle, vl53l0x_measurement_t* measurement);
+
 /**
  * @brief Start continuous measurements with callback
  * 
+ * The sensor runs in hardware back-to-back ranging, or in timed ranging
+ * when config.target_rate_hz is below the rate the timing budget allows.
+ * While running, vl53l0x_read_single() returns the latest sample. In
+ * VL53L0X_MODE_MULTI_SHOT the callback gets one combined sample per group
+ * of shots.
+ * 
+ * When samples keep failing the sensor is reported as degraded: the
+ * callback receives an invalid measurement with health set to
+ * VL53L0X_HEALTH_DEGRADED for every failed sample while the driver
+ * restarts ranging, until a sample completes again.
+ * 
  * @param handle Sensor handle
  * @param callback Callback function for measurements
  * @param user_data User data to pass to callback
@@ -101,15 +332,116 @@ esp_err_t vl53l0x_start_continuous(vl53l0x_handle_t handle,
  */
 esp_err_t vl53l0x_stop_continuous(vl53l0x_handle_t handle);
 
+/**
+ * @brief Start continuous ranging without a driver task
+ * 
+ * The sensor ranges as in vl53l0x_start_continuous(), back-to-back or
+ * timed at config.target_rate_hz, but the caller reads every sample with
+ * vl53l0x_poll_ranging(), so one task can serve several sensors. While
+ * running, vl53l0x_read_single() returns the latest sample and
+ * vl53l0x_stop_continuous() is refused.
+ * 
+ * @param handle Sensor handle
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if continuous ranging
+ *         or an async single shot is running, ESP_ERR_NOT_SUPPORTED with a
+ *         threshold window armed, ESP_FAIL on bus error
+ */
+esp_err_t vl53l0x_start_ranging(vl53l0x_handle_t handle);
+
+/**
+ * @brief Read out the next sample of vl53l0x_start_ranging(), if it is ready
+ * 
+ * One read answers data ready and fetches the sample; a ready sample adds
+ * the interrupt clear. In VL53L0X_MODE_MULTI_SHOT, ready is only set once
+ * a group of shots is complete. A sample overdue by more than one period
+ * counts as failed: the driver restarts ranging and health follows, as
+ * with the continuous task.
+ * 
+ * @param handle Sensor handle
+ * @param measurement Pointer to store the sample when ready
+ * @param ready Set when measurement holds a new sample
+ * @return ESP_OK (see ready), ESP_ERR_TIMEOUT if the sample is overdue,
+ *         ESP_FAIL on bus error, ESP_ERR_INVALID_STATE if not ranging
+ */
+esp_err_t vl53l0x_poll_ranging(vl53l0x_handle_t handle, vl53l0x_measurement_t* measurement, bool* ready);
+
+/**
+ * @brief Stop ranging started with vl53l0x_start_ranging()
+ * 
+ * @param handle Sensor handle
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not ranging,
+ *         ESP_FAIL on bus error
+ */
+esp_err_t vl53l0x_stop_ranging(vl53l0x_handle_t handle);
+
+/**
+ * @brief Only report continuous samples that leave a distance window
+ * 
+ * Programs the sensor's interrupt thresholds and switches GPIO1 to
+ * "threshold crossed out": the sensor keeps ranging on its own but only
+ * flags samples closer than low_mm or farther than high_mm. With a GPIO1
+ * pin the continuous task sleeps until then; without one it polls the
+ * one-byte interrupt status instead of reading every result. The 2 mm
+ * register steps are rounded so a sample outside the window is never
+ * missed, at the cost of the odd one up to 1 mm inside. low_mm = high_mm
+ * = 0 reports every sample while keeping the thresholds armed.
+ * 
+ * Whatever the window, the latest sample is read and reported at least
+ * every config.threshold_heartbeat_ms, so a sensor that stops ranging is
+ * still reported degraded. A lost target reads as 8190 mm or more and is
+ * only flagged by a high_mm below that.
+ * 
+ * Can be called before or during continuous mode; moving an armed window
+ * only rewrites the four threshold bytes, the first call while running
+ * restarts ranging. vl53l0x_read_single() during continuous mode returns
+ * the last reported sample. Not available in VL53L0X_MODE_MULTI_SHOT
+ * or during vl53l0x_start_ranging().
+ * 
+ * @param handle Sensor handle
+ * @param low_mm Samples closer than this are reported
+ * @param high_mm Samples farther than this are reported (at most VL53L0X_THRESHOLD_MAX_MM)
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED in MULTI_SHOT mode or
+ *         during vl53l0x_start_ranging(), error code otherwise
+ */
+esp_err_t vl53l0x_set_threshold_window(vl53l0x_handle_t handle, uint16_t low_mm, uint16_t high_mm);
+
+/**
+ * @brief Report every continuous sample again
+ * 
+ * Returns GPIO1 to "new sample ready"; restarts ranging if running.
+ * 
+ * @param handle Sensor handle
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t vl53l0x_clear_threshold_window(vl53l0x_handle_t handle);
+
 /**
  * @brief Change operation mode
  * 
+ * Every mode is captured once at init; a switch only rewrites the
+ * registers that differ from the current mode and is a no-op when the
+ * mode is already active. See vl53l0x_get_mode_stats() for its cost.
+ * 
  * @param handle Sensor handle
  * @param mode New operation mode
- * @return ESP_OK on success, error code otherwise
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED for MULTI_SHOT while a
+ *         threshold window is set or for a mode with other timing when
+ *         config.fixed_mode is set, error code otherwise
  */
 esp_err_t vl53l0x_set_mode(vl53l0x_handle_t handle, vl53l0x_mode_t mode);
 
+/**
+ * @brief Get the timing budget of the current mode
+ * 
+ * One shot of the mode completes about this long after it is triggered
+ * (one MULTI_SHOT shot, not the whole group).
+ * 
+ * @param handle Sensor handle
+ * @param budget_us Pointer to store the budget in microseconds
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t vl53l0x_get_timing_budget(vl53l0x_handle_t handle, uint32_t* budget_us);
+
 /**
  * @brief Get current distance (quick read)
  * 
@@ -131,11 +463,135 @@ esp_err_t vl53l0x_is_ready(vl53l0x_handle_t handle, bool* is_ready);
 /**
  * @brief Deinitialize sensor and free resources
  * 
+ * Stops continuous or polled ranging first. If the ranging task does not exit in
+ * time nothing is freed and the handle stays valid, so deinit can be
+ * retried.
+ * 
  * @param handle Sensor handle
- * @return ESP_OK on success, error code otherwise
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT if the ranging task is still
+ *         running, error code otherwise
  */
 esp_err_t vl53l0x_deinit(vl53l0x_handle_t handle);
 
+/**
+ * @brief Attach a reader to a sensor's sample history
+ * 
+ * Every sample the driver produces (continuous, single and async) is
+ * published with its timestamp and sequence number into a per-sensor ring.
+ * The reader starts at the next sample to be published.
+ * 
+ * @param handle Sensor handle
+ * @param reader Reader to initialize
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t vl53l0x_reader_init(vl53l0x_handle_t handle, vl53l0x_reader_t* reader);
+
+/**
+ * @brief Drain samples published since the reader's last call
+ * 
+ * Lock-free and never blocks the sensor task. A reader that falls more
+ * than the ring depth behind skips ahead and counts the lost samples in
+ * reader->dropped.
+ * 
+ * @param handle Sensor handle
+ * @param reader Reader cursor
+ * @param samples Array to fill, oldest first
+ * @param max_samples Capacity of the array
+ * @return Number of samples copied
+ */
+size_t vl53l0x_read_samples(vl53l0x_handle_t handle, vl53l0x_reader_t* reader,
+                            vl53l0x_measurement_t* samples, size_t max_samples);
+
+/**
+ * @brief Get the most recent sample without blocking
+ * 
+ * @param handle Sensor handle
+ * @param sample Pointer to store the sample
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if nothing was published yet
+ */
+esp_err_t vl53l0x_get_latest(vl53l0x_handle_t handle, vl53l0x_measurement_t* sample);
+
+/**
+ * @brief Get data ready polling counters
+ * 
+ * data_ready_polls / measurements is the average number of I2C polls per
+ * sample (0 when the GPIO1 interrupt is used). Counting starts with the
+ * first vl53l0x_reset_wait_stats().
+ * 
+ * @param handle Sensor handle
+ * @param stats Pointer to store the counters
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE before counting has
+ *         started, error code otherwise
+ */
+esp_err_t vl53l0x_get_wait_stats(vl53l0x_handle_t handle, vl53l0x_wait_stats_t* stats);
+
+/**
+ * @brief Reset data ready polling counters
+ * 
+ * The first call allocates the counters and starts counting.
+ * 
+ * @param handle Sensor handle
+ * @return ESP_OK on success, ESP_ERR_NO_MEM, error code otherwise
+ */
+esp_err_t vl53l0x_reset_wait_stats(vl53l0x_handle_t handle);
+
+/**
+ * @brief Get sensor health
+ * 
+ * @param handle Sensor handle
+ * @param health Pointer to store the health state
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t vl53l0x_get_health(vl53l0x_handle_t handle, vl53l0x_health_t* health);
+
+/**
+ * @brief Get mode switch counters
+ * 
+ * All zero with config.fixed_mode, which never switches.
+ * 
+ * @param handle Sensor handle
+ * @param stats Pointer to store the counters
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t vl53l0x_get_mode_stats(vl53l0x_handle_t handle, vl53l0x_mode_stats_t* stats);
+
+/**
+ * @brief Get the RAM a sensor holds
+ * 
+ * @param handle Sensor handle
+ * @param footprint Pointer to store the report
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t vl53l0x_get_footprint(vl53l0x_handle_t handle, vl53l0x_footprint_t* footprint);
+
+/**
+ * @brief Get utilization of every active I2C bus
+ * 
+ * Sensors are assigned to I2C controllers by their SCL/SDA pin pair;
+ * each distinct pair gets its own controller so transfers can overlap.
+ * 
+ * @param stats Array to fill, one entry per active bus
+ * @param max_stats Capacity of the array
+ * @param count Pointer to store the number of entries written
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t vl53l0x_get_bus_stats(vl53l0x_bus_stats_t* stats, size_t max_stats, size_t* count);
+
+/**
+ * @brief Reset bus counters and start a new utilization window
+ */
+void vl53l0x_reset_bus_stats(void);
+
+/**
+ * @brief Get number of heap allocations made by the I2C platform layer
+ * 
+ * Register writes go through a per-sensor scratch buffer; only writes
+ * larger than VL53L0X_I2C_SCRATCH_SIZE fall back to the heap.
+ * 
+ * @return Allocations since boot
+ */
+uint32_t vl53l0x_get_platform_alloc_count(void);
+
 /**
  * @brief Get mode name string
  * 
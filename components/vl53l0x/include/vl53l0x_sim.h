@@ -0,0 +1,159 @@
+/**
+ * @file vl53l0x_sim.h
+ * @brief Register-level VL53L0X simulator
+ *
+ * Answers the platform layer's register reads and writes in place of a real
+ * sensor, so the driver, the ST API and the components above them can run
+ * and be measured without hardware. Set vl53l0x_config_t.simulator to route
+ * a handle to a simulator instead of the I2C bus.
+ *
+ * Only built with the VL53L0X_SIMULATOR option: the host build in test/host
+ * enables it, firmware builds leave it out unless asked for
+ * (idf.py -DVL53L0X_SIMULATOR=1 build). Without it neither this header nor
+ * the simulator field of the configuration structures is visible.
+ */
+
+#ifndef VL53L0X_SIM_H
+#define VL53L0X_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Simulator handle (opaque)
+ */
+typedef struct vl53l0x_sim_s* vl53l0x_sim_handle_t;
+
+/**
+ * @brief Target distance provider for moving-target profiles
+ *
+ * @param time_us esp_timer time the sample completes
+ * @param user_data User data from the configuration
+ * @return Distance in millimeters
+ */
+typedef uint16_t (*vl53l0x_sim_range_fn_t)(int64_t time_us, void* user_data);
+
+/**
+ * @brief Injectable faults
+ */
+typedef enum {
+    VL53L0X_SIM_FAULT_NONE,          /*!< Clear pending faults */
+    VL53L0X_SIM_FAULT_BUS_ERROR,     /*!< Next transfers fail (NACK / bus error) */
+    VL53L0X_SIM_FAULT_NO_COMPLETION, /*!< Next measurements never complete */
+    VL53L0X_SIM_FAULT_BUS_STUCK,     /*!< SDA held low: transfers time out until bus resets */
+} vl53l0x_sim_fault_t;
+
+/**
+ * @brief Simulator configuration
+ */
+typedef struct {
+    uint16_t distance_mm;        /*!< Static target distance */
+    uint16_t noise_mm;           /*!< Peak-to-peak uniform range noise at a 33 ms budget,
+                                      scaled by sqrt(33 ms / budget) */
+    uint16_t max_range_mm;       /*!< Targets beyond this report a signal failure */
+    float signal_rate_mcps;      /*!< Reported return signal rate */
+    float ambient_rate_mcps;     /*!< Reported ambient rate */
+    vl53l0x_sim_range_fn_t range_fn; /*!< Optional distance profile (overrides distance_mm) */
+    void* range_user_data;       /*!< Passed to range_fn */
+    uint16_t outlier_per_mille;  /*!< Valid-looking samples with a random range and a quarter of the signal */
+    uint32_t error_every_n;      /*!< Fail every Nth transfer (0 = never) */
+    uint32_t seed;               /*!< Noise generator seed */
+    uint32_t uid_upper;          /*!< Unique ID reported by the NVM */
+    uint32_t uid_lower;
+} vl53l0x_sim_config_t;
+
+/**
+ * @brief Default simulator configuration: 500 mm target, ±5 mm noise
+ */
+#define VL53L0X_SIM_DEFAULT_CONFIG() {      \
+    .distance_mm = 500,                     \
+    .noise_mm = 10,                         \
+    .max_range_mm = 2000,                   \
+    .signal_rate_mcps = 10.0f,              \
+    .ambient_rate_mcps = 0.5f,              \
+    .range_fn = NULL,                       \
+    .range_user_data = NULL,                \
+    .outlier_per_mille = 0,                 \
+    .error_every_n = 0,                     \
+    .seed = 1,                              \
+    .uid_upper = 0x5A5A0001,                \
+    .uid_lower = 0x00000001,                \
+}
+
+/**
+ * @brief Simulator counters
+ *
+ * bus_us is the time the same traffic would occupy a real bus at the
+ * sensor's configured I2C speed (9 clocks per byte plus start/stop).
+ */
+typedef struct {
+    uint32_t writes;             /*!< Write transfers */
+    uint32_t reads;              /*!< Read transfers */
+    uint64_t bytes;              /*!< Bytes on the wire, addresses included */
+    uint64_t bus_us;             /*!< Modeled bus time */
+    uint32_t samples;            /*!< Completed measurements */
+    uint32_t faults;             /*!< Injected failures */
+    uint32_t bus_resets;         /*!< Bus recoveries issued by the host */
+    uint32_t measurement_us;     /*!< Measurement time programmed in the sequencer registers at the last start */
+} vl53l0x_sim_stats_t;
+
+/**
+ * @brief Create a simulated sensor
+ *
+ * @param config Pointer to configuration structure
+ * @param sim Pointer to store simulator handle
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t vl53l0x_sim_create(const vl53l0x_sim_config_t* config, vl53l0x_sim_handle_t* sim);
+
+/**
+ * @brief Change the static target distance
+ *
+ * @param sim Simulator handle
+ * @param distance_mm New distance
+ */
+void vl53l0x_sim_set_distance(vl53l0x_sim_handle_t sim, uint16_t distance_mm);
+
+/**
+ * @brief Inject a fault
+ *
+ * @param sim Simulator handle
+ * @param fault Fault type
+ * @param count Transfers (bus errors), measurements (no completion) or bus
+ *              resets needed to release the bus (stuck bus) affected
+ */
+void vl53l0x_sim_inject_fault(vl53l0x_sim_handle_t sim, vl53l0x_sim_fault_t fault, uint32_t count);
+
+/**
+ * @brief Get simulator counters
+ *
+ * @param sim Simulator handle
+ * @param stats Pointer to store the counters
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t vl53l0x_sim_get_stats(vl53l0x_sim_handle_t sim, vl53l0x_sim_stats_t* stats);
+
+/**
+ * @brief Reset simulator counters
+ *
+ * @param sim Simulator handle
+ */
+void vl53l0x_sim_reset_stats(vl53l0x_sim_handle_t sim);
+
+/**
+ * @brief Free a simulator (the sensor handle using it must be deinitialized first)
+ *
+ * @param sim Simulator handle
+ */
+void vl53l0x_sim_delete(vl53l0x_sim_handle_t sim);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VL53L0X_SIM_H
@@ -0,0 +1,165 @@
+/**
+ * @file vl53l0x_trace.h
+ * @brief Opt-in I2C transaction tracer for the VL53L0X platform layer
+ *
+ * When the component is built with VL53L0X_I2C_TRACE defined
+ * (idf.py -DVL53L0X_I2C_TRACE=1 build), every register transfer is recorded
+ * into a fixed-size ring and attributed to the innermost ST API call in
+ * progress, with per-call counts and latency histograms. In a normal build
+ * the hooks compile to nothing and these functions return
+ * ESP_ERR_NOT_SUPPORTED.
+ */
+
+#ifndef VL53L0X_TRACE_H
+#define VL53L0X_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Transfers kept in the trace ring (oldest are overwritten)
+ */
+#define VL53L0X_TRACE_RING_SIZE 256
+
+/**
+ * @brief Distinct ST API functions tracked
+ */
+#define VL53L0X_TRACE_MAX_APIS 64
+
+/**
+ * @brief Latency histogram buckets
+ *
+ * Bucket 0 counts durations under 2 us, bucket k durations in
+ * [2^k, 2^(k+1)) us; the last bucket also holds everything longer.
+ */
+#define VL53L0X_TRACE_HIST_BUCKETS 16
+
+/**
+ * @brief API index of transfers issued outside any ST API call
+ */
+#define VL53L0X_TRACE_API_DIRECT 0
+
+/**
+ * @brief Event flags
+ */
+#define VL53L0X_TRACE_FLAG_READ  0x01  /*!< Register read (write otherwise) */
+#define VL53L0X_TRACE_FLAG_ERROR 0x02  /*!< Transfer failed */
+
+/**
+ * @brief One recorded transfer (12 bytes, also the binary dump record)
+ */
+typedef struct {
+    uint32_t time_us;            /*!< Start time, low 32 bits of esp_timer */
+    uint16_t duration_us;        /*!< Transfer time, saturated at 65535 */
+    uint8_t address;             /*!< I2C address of the sensor */
+    uint8_t reg;                 /*!< First register index */
+    uint8_t length;              /*!< Payload bytes, saturated at 255 */
+    uint8_t flags;               /*!< VL53L0X_TRACE_FLAG_* */
+    uint8_t api;                 /*!< Index into the API table */
+    uint8_t reserved;
+} vl53l0x_trace_event_t;
+
+/**
+ * @brief Aggregated cost of one ST API function
+ *
+ * Transfers and bytes count only I/O issued while the function was the
+ * innermost call; durations include nested calls.
+ */
+typedef struct {
+    const char* name;            /*!< Function name */
+    uint32_t calls;              /*!< Completed calls */
+    uint32_t transfers;          /*!< I2C transfers issued */
+    uint32_t bytes;              /*!< Payload bytes moved */
+    uint64_t total_us;           /*!< Sum of call durations */
+    uint32_t max_us;             /*!< Longest call */
+    uint32_t hist[VL53L0X_TRACE_HIST_BUCKETS]; /*!< Call duration histogram */
+} vl53l0x_trace_api_t;
+
+/**
+ * @brief Sink for the binary dump
+ *
+ * @param data Bytes to write
+ * @param len Number of bytes
+ * @param ctx User context passed to vl53l0x_trace_dump_binary()
+ */
+typedef void (*vl53l0x_trace_write_fn_t)(const void* data, size_t len, void* ctx);
+
+/**
+ * @brief Binary dump header
+ *
+ * Followed by the transfer latency histogram (hist_buckets x uint32_t),
+ * api_count API records (uint8_t name length, name bytes, then calls,
+ * transfers, bytes, total_us truncated to 32 bits, max_us and the call
+ * histogram, all uint32_t) and event_count vl53l0x_trace_event_t records,
+ * oldest first. Multi-byte fields are little-endian.
+ */
+typedef struct {
+    char magic[4];               /*!< "VLTR" */
+    uint8_t version;             /*!< Format version, currently 1 */
+    uint8_t hist_buckets;        /*!< VL53L0X_TRACE_HIST_BUCKETS */
+    uint16_t api_count;          /*!< API records that follow */
+    uint32_t event_count;        /*!< Event records that follow */
+    uint32_t lost_events;        /*!< Events overwritten before the dump */
+} vl53l0x_trace_header_t;
+
+/**
+ * @brief Copy the recorded transfers, oldest first
+ *
+ * @param events Array to fill
+ * @param max_events Size of the array
+ * @param count Pointer to store the number of events copied
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if tracing is compiled out
+ */
+esp_err_t vl53l0x_trace_get_events(vl53l0x_trace_event_t* events, size_t max_events, size_t* count);
+
+/**
+ * @brief Copy the per-API aggregates
+ *
+ * Index VL53L0X_TRACE_API_DIRECT holds transfers made outside ST API calls.
+ *
+ * @param apis Array to fill
+ * @param max_apis Size of the array
+ * @param count Pointer to store the number of entries copied
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if tracing is compiled out
+ */
+esp_err_t vl53l0x_trace_get_apis(vl53l0x_trace_api_t* apis, size_t max_apis, size_t* count);
+
+/**
+ * @brief Copy the latency histogram of individual transfers
+ *
+ * @param hist Array of VL53L0X_TRACE_HIST_BUCKETS counters to fill
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if tracing is compiled out
+ */
+esp_err_t vl53l0x_trace_get_histogram(uint32_t hist[VL53L0X_TRACE_HIST_BUCKETS]);
+
+/**
+ * @brief Clear the ring and all counters
+ */
+void vl53l0x_trace_reset(void);
+
+/**
+ * @brief Log the per-API table and the transfer histogram
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if tracing is compiled out
+ */
+esp_err_t vl53l0x_trace_dump(void);
+
+/**
+ * @brief Stream everything in the compact binary format
+ *
+ * @param write Sink called with consecutive chunks (not from a critical section)
+ * @param ctx User context for the sink
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if tracing is compiled out
+ */
+esp_err_t vl53l0x_trace_dump_binary(vl53l0x_trace_write_fn_t write, void* ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VL53L0X_TRACE_H
@@ -0,0 +1,119 @@
+/**
+ * @file vl53l0x_adaptive.c
+ * @brief Speed- and distance-adaptive mode selection
+ */
+
+#include "vl53l0x_adaptive.h"
+#include <math.h>
+#include <string.h>
+
+#define STEP_UP_MARGIN  1.5f    // A longer budget must fit this many times over before switching to it
+
+/**
+ * @brief Modes the policy moves between, shortest sample period first
+ *
+ * Periods are the nominal timing budgets of the modes. LONG_RANGE is left
+ * out: it trades precision for reach, which is never what a fast vehicle
+ * needs from a near target.
+ */
+static const struct {
+    vl53l0x_mode_t mode;
+    uint32_t period_us;
+} ladder[] = {
+    { VL53L0X_MODE_ULTRA_FAST, 8000 },
+    { VL53L0X_MODE_HIGH_SPEED, 20000 },
+    { VL53L0X_MODE_DEFAULT, 33000 },
+    { VL53L0X_MODE_HIGH_ACCURACY, 200000 },
+};
+
+#define RUNG_HIGH_SPEED     1
+#define RUNG_DEFAULT        2
+#define RUNG_HIGH_ACCURACY  3
+
+/**
+ * @brief Position of a mode on the ladder (LONG_RANGE ranks with its 33 ms budget)
+ */
+static int rung_of(vl53l0x_mode_t mode) {
+    for (int i = 0; i < (int)(sizeof(ladder) / sizeof(ladder[0])); i++) {
+        if (ladder[i].mode == mode) {
+            return i;
+        }
+    }
+    return RUNG_DEFAULT;
+}
+
+/**
+ * @brief Closing speed over a window of at least speed_window_ms
+ *
+ * A single-sample difference would turn range noise into meters per second
+ * at the fast modes' rates.
+ */
+static void update_speed(vl53l0x_adaptive_t* ctl, const vl53l0x_measurement_t* measurement) {
+    if (!ctl->has_reference) {
+        ctl->has_reference = true;
+        ctl->ref_distance_mm = measurement->distance_mm;
+        ctl->ref_timestamp_us = measurement->timestamp_us;
+        return;
+    }
+
+    int64_t elapsed_us = measurement->timestamp_us - ctl->ref_timestamp_us;
+    if (elapsed_us < (int64_t)ctl->config.speed_window_ms * 1000) {
+        return;
+    }
+
+    ctl->closing_speed_mm_s = ((float)ctl->ref_distance_mm - (float)measurement->distance_mm) * 1e6f /
+                              (float)elapsed_us;
+    ctl->ref_distance_mm = measurement->distance_mm;
+    ctl->ref_timestamp_us = measurement->timestamp_us;
+}
+
+void vl53l0x_adaptive_init(vl53l0x_adaptive_t* ctl, const vl53l0x_adaptive_config_t* config,
+                           vl53l0x_mode_t initial_mode) {
+    memset(ctl, 0, sizeof(*ctl));
+    ctl->config = *config;
+    ctl->mode = initial_mode;
+}
+
+vl53l0x_mode_t vl53l0x_adaptive_update(vl53l0x_adaptive_t* ctl, const vl53l0x_measurement_t* measurement,
+                                       uint16_t approach_speed_mm_s) {
+    const vl53l0x_adaptive_config_t* config = &ctl->config;
+    uint32_t distance_mm = config->far_distance_mm;
+
+    if (measurement->is_valid && measurement->health == VL53L0X_HEALTH_OK) {
+        distance_mm = measurement->distance_mm;
+        update_speed(ctl, measurement);
+    } else {
+        // No target in range: nothing to approach
+        ctl->has_reference = false;
+        ctl->closing_speed_mm_s = 0.0f;
+    }
+
+    float speed_mm_s = fmaxf(ctl->closing_speed_mm_s, (float)approach_speed_mm_s);
+
+    // Longest sample period that keeps the travel per sample within the margin
+    float margin_mm = (distance_mm > config->critical_distance_mm) ?
+                      (float)(distance_mm - config->critical_distance_mm) : 0.0f;
+    float max_period_us = (speed_mm_s > 0.0f) ?
+                          config->travel_per_sample * margin_mm * 1e6f / speed_mm_s : INFINITY;
+
+    // Precision only pays off close to a target while stopped
+    int cap = RUNG_HIGH_ACCURACY;
+    if (distance_mm >= config->far_distance_mm) {
+        cap = RUNG_HIGH_SPEED;
+    } else if (distance_mm >= config->precision_distance_mm || speed_mm_s >= config->still_speed_mm_s) {
+        cap = RUNG_DEFAULT;
+    }
+
+    int current = rung_of(ctl->mode);
+    int pick = 0;
+    for (int i = cap; i > 0; i--) {
+        float needed_us = (float)ladder[i].period_us * ((i > current) ? STEP_UP_MARGIN : 1.0f);
+        if (needed_us <= max_period_us) {
+            pick = i;
+            break;
+        }
+    }
+
+    ctl->mode = ladder[pick].mode;
+    return ctl->mode;
+}
@@ -0,0 +1,275 @@
+/**
+ * @file vl53l0x_bus.c
+ * @brief I2C bus registry: one entry per controller in use, keyed by pin pair
+ */
+
+#include "vl53l0x_bus.h"
+#include "vl53l0x_driver.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
+#include "soc/soc_caps.h"
+#include <string.h>
+
+static const char *TAG = "VL53L0X_BUS";
+
+#define VL53L0X_MAX_BUSES SOC_I2C_NUM
+
+// Let the I2C driver pick a free controller, so buses the application
+// creates itself (on any port) do not collide with the sensors'
+#define I2C_PORT_AUTO (-1)
+
+static vl53l0x_i2c_bus_t buses[VL53L0X_MAX_BUSES];
+
+// Serializes registry changes against bus resets: a reset from one sensor
+// must not run while another sensor's release deletes the same bus.
+// Created on first use and kept for the life of the program.
+static SemaphoreHandle_t registry_mutex = NULL;
+static portMUX_TYPE registry_init_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Take the registry mutex, creating it on first use
+ */
+static bool registry_lock(void) {
+    if (!registry_mutex) {
+        SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+        if (!mutex) {
+            return false;
+        }
+        portENTER_CRITICAL(&registry_init_lock);
+        if (!registry_mutex) {
+            registry_mutex = mutex;
+            mutex = NULL;
+        }
+        portEXIT_CRITICAL(&registry_init_lock);
+        if (mutex) {
+            vSemaphoreDelete(mutex);  // Another task created it first
+        }
+    }
+    xSemaphoreTake(registry_mutex, portMAX_DELAY);
+    return true;
+}
+
+static void registry_unlock(void) {
+    xSemaphoreGive(registry_mutex);
+}
+
+/**
+ * @brief Find the registered bus using this pin pair
+ */
+static vl53l0x_i2c_bus_t* find_bus(gpio_num_t scl_pin, gpio_num_t sda_pin) {
+    for (int i = 0; i < VL53L0X_MAX_BUSES; i++) {
+        if (buses[i].handle && buses[i].scl_pin == scl_pin && buses[i].sda_pin == sda_pin) {
+            return &buses[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Controller number the I2C driver gave a bus
+ */
+static i2c_port_num_t port_of(i2c_master_bus_handle_t handle) {
+    for (i2c_port_num_t port = 0; port < SOC_I2C_NUM; port++) {
+        i2c_master_bus_handle_t port_handle;
+        if (i2c_master_get_bus_handle(port, &port_handle) == ESP_OK && port_handle == handle) {
+            return port;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Check whether a pin is already routed to another bus
+ */
+static bool pin_in_use(gpio_num_t pin) {
+    for (int i = 0; i < VL53L0X_MAX_BUSES; i++) {
+        if (buses[i].handle && (buses[i].scl_pin == pin || buses[i].sda_pin == pin)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief vl53l0x_bus_acquire() body, called with the registry mutex held
+ */
+static esp_err_t acquire_locked(gpio_num_t scl_pin, gpio_num_t sda_pin, vl53l0x_i2c_bus_t** bus) {
+    vl53l0x_i2c_bus_t* entry = find_bus(scl_pin, sda_pin);
+    if (entry) {
+        entry->num_devices++;
+        *bus = entry;
+        return ESP_OK;
+    }
+    
+    if (pin_in_use(scl_pin) || pin_in_use(sda_pin)) {
+        ESP_LOGE(TAG, "Pins SCL:%d/SDA:%d overlap an existing bus", scl_pin, sda_pin);
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // Take a free registry slot; the driver picks the controller
+    for (int i = 0; i < VL53L0X_MAX_BUSES; i++) {
+        if (buses[i].handle) continue;
+        
+        i2c_master_bus_config_t bus_config = {
+            .i2c_port = I2C_PORT_AUTO,
+            .sda_io_num = sda_pin,
+            .scl_io_num = scl_pin,
+            .clk_source = I2C_CLK_SRC_DEFAULT,
+            .glitch_ignore_cnt = 7,
+            .flags.enable_internal_pullup = true,
+        };
+        
+        i2c_master_bus_handle_t handle;
+        esp_err_t ret = i2c_new_master_bus(&bus_config, &handle);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "No I2C controller for SCL:%d/SDA:%d: %s", scl_pin, sda_pin, esp_err_to_name(ret));
+            return ret;
+        }
+        
+        memset(&buses[i], 0, sizeof(buses[i]));
+        buses[i].handle = handle;
+        buses[i].port = port_of(handle);
+        buses[i].scl_pin = scl_pin;
+        buses[i].sda_pin = sda_pin;
+        buses[i].num_devices = 1;
+        buses[i].lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+        buses[i].window_start_us = esp_timer_get_time();
+        
+        ESP_LOGI(TAG, "I2C%d initialized (SDA: GPIO%d, SCL: GPIO%d)", (int)buses[i].port, sda_pin, scl_pin);
+        *bus = &buses[i];
+        return ESP_OK;
+    }
+    
+    ESP_LOGE(TAG, "No free I2C controller for SCL:%d/SDA:%d (%d in use)",
+             scl_pin, sda_pin, VL53L0X_MAX_BUSES);
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t vl53l0x_bus_acquire(gpio_num_t scl_pin, gpio_num_t sda_pin, vl53l0x_i2c_bus_t** bus) {
+    if (!bus) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!registry_lock()) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t ret = acquire_locked(scl_pin, sda_pin, bus);
+    registry_unlock();
+    return ret;
+}
+
+void vl53l0x_bus_release(vl53l0x_i2c_bus_t* bus) {
+    if (!bus || !registry_lock()) {
+        return;
+    }
+    
+    if (bus->handle && bus->num_devices > 0 && --bus->num_devices == 0) {
+        i2c_del_master_bus(bus->handle);
+        bus->handle = NULL;
+        ESP_LOGI(TAG, "I2C%d released", (int)bus->port);
+    }
+    registry_unlock();
+}
+
+void vl53l0x_bus_account(vl53l0x_i2c_bus_t* bus, uint32_t bytes, uint32_t elapsed_us, bool ok) {
+    if (!bus) {
+        return;
+    }
+    
+    portENTER_CRITICAL(&bus->lock);
+    if (ok) {
+        bus->transactions++;
+    } else {
+        bus->errors++;
+    }
+    bus->bytes += bytes;
+    bus->busy_us += elapsed_us;
+    portEXIT_CRITICAL(&bus->lock);
+}
+
+esp_err_t vl53l0x_bus_recover(vl53l0x_i2c_bus_t* bus) {
+    if (!bus) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!registry_lock()) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (!bus->handle) {
+        registry_unlock();
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // i2c_master_bus_reset() issues the 9-clock SCL sequence and a STOP
+    esp_err_t ret = i2c_master_bus_reset(bus->handle);
+    
+    portENTER_CRITICAL(&bus->lock);
+    bus->recoveries++;
+    portEXIT_CRITICAL(&bus->lock);
+    registry_unlock();
+    
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "I2C%d recovery failed: %s", (int)bus->port, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+esp_err_t vl53l0x_get_bus_stats(vl53l0x_bus_stats_t* stats, size_t max_stats, size_t* count) {
+    if (!stats || !count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!registry_lock()) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    int64_t now = esp_timer_get_time();
+    size_t n = 0;
+    
+    for (int i = 0; i < VL53L0X_MAX_BUSES && n < max_stats; i++) {
+        vl53l0x_i2c_bus_t* bus = &buses[i];
+        if (!bus->handle) continue;
+        
+        vl53l0x_bus_stats_t* out = &stats[n++];
+        out->port = bus->port;
+        out->scl_pin = bus->scl_pin;
+        out->sda_pin = bus->sda_pin;
+        out->num_devices = bus->num_devices;
+        
+        portENTER_CRITICAL(&bus->lock);
+        out->transactions = bus->transactions;
+        out->errors = bus->errors;
+        out->recoveries = bus->recoveries;
+        out->bytes = bus->bytes;
+        out->busy_us = bus->busy_us;
+        out->window_us = (uint64_t)(now - bus->window_start_us);
+        portEXIT_CRITICAL(&bus->lock);
+        
+        out->utilization = out->window_us ? (float)out->busy_us / (float)out->window_us : 0.0f;
+    }
+    
+    registry_unlock();
+    
+    *count = n;
+    return ESP_OK;
+}
+
+void vl53l0x_reset_bus_stats(void) {
+    if (!registry_lock()) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    
+    for (int i = 0; i < VL53L0X_MAX_BUSES; i++) {
+        vl53l0x_i2c_bus_t* bus = &buses[i];
+        if (!bus->handle) continue;
+        
+        portENTER_CRITICAL(&bus->lock);
+        bus->transactions = 0;
+        bus->errors = 0;
+        bus->recoveries = 0;
+        bus->bytes = 0;
+        bus->busy_us = 0;
+        bus->window_start_us = now;
+        portEXIT_CRITICAL(&bus->lock);
+    }
+    registry_unlock();
+}
@@ -0,0 +1,87 @@
+/**
+ * @file vl53l0x_bus.h
+ * @brief Internal I2C bus registry shared by the driver and platform layer
+ */
+
+#ifndef VL53L0X_BUS_H
+#define VL53L0X_BUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "driver/i2c_master.h"
+#include "freertos/FreeRTOS.h"
+#include "vl53l0x_platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief One I2C controller and the pin pair it drives
+ */
+struct vl53l0x_i2c_bus_s {
+    i2c_master_bus_handle_t handle;  // ESP-IDF bus handle (NULL when slot is free)
+    i2c_port_num_t port;             // I2C controller the driver picked
+    gpio_num_t scl_pin;
+    gpio_num_t sda_pin;
+    uint8_t num_devices;             // Sensors attached to this bus
+    portMUX_TYPE lock;               // Protects the counters below
+    uint32_t transactions;           // Completed transfers since last reset
+    uint32_t errors;                 // Failed transfers since last reset
+    uint32_t recoveries;             // Bus resets since last reset
+    uint64_t bytes;                  // Payload bytes (register index included)
+    uint64_t busy_us;                // Time spent inside i2c_master_* calls
+    int64_t window_start_us;         // Start of the current accounting window
+};
+
+typedef struct vl53l0x_i2c_bus_s vl53l0x_i2c_bus_t;
+
+/**
+ * @brief Get the bus for a pin pair, creating it on a free controller if needed
+ *
+ * Registry changes and bus resets are serialized by one registry mutex.
+ */
+esp_err_t vl53l0x_bus_acquire(gpio_num_t scl_pin, gpio_num_t sda_pin, vl53l0x_i2c_bus_t** bus);
+
+/**
+ * @brief Drop one device reference, deleting the bus when it becomes unused
+ */
+void vl53l0x_bus_release(vl53l0x_i2c_bus_t* bus);
+
+/**
+ * @brief Account one finished transfer (called by the platform layer)
+ */
+void vl53l0x_bus_account(vl53l0x_i2c_bus_t* bus, uint32_t bytes, uint32_t elapsed_us, bool ok);
+
+/**
+ * @brief Free a stuck bus: clock SCL until slaves release SDA, then reset the controller
+ *
+ * Runs under the registry mutex, so the bus cannot be deleted meanwhile.
+ */
+esp_err_t vl53l0x_bus_recover(vl53l0x_i2c_bus_t* bus);
+
+/**
+ * @brief Start queuing register writes for a device
+ *
+ * Writes to consecutive registers are merged into one transfer. Pending
+ * writes go out before any read or polling delay and at the outermost
+ * vl53l0x_batch_end(). Sections nest.
+ */
+VL53L0X_Error vl53l0x_batch_begin(VL53L0X_DEV Dev);
+
+/**
+ * @brief Close a batch section, flushing pending writes when it is the outermost
+ */
+VL53L0X_Error vl53l0x_batch_end(VL53L0X_DEV Dev);
+
+/**
+ * @brief Forget the cached 0xFF page value (after a hardware reset)
+ */
+void vl53l0x_invalidate_page(VL53L0X_DEV Dev);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VL53L0X_BUS_H
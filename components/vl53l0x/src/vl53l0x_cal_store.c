@@ -0,0 +1,99 @@
+/**
+ * @file vl53l0x_cal_store.c
+ * @brief VL53L0X reference calibration cache in NVS, keyed by sensor unique ID
+ */
+
+#include "vl53l0x_cal_store.h"
+#include "nvs.h"
+#include "esp_log.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "VL53L0X_CAL";
+
+#define CAL_NAMESPACE   "vl53l0x_cal"
+#define CAL_VERSION     1
+
+/**
+ * @brief Build the NVS key for a sensor (15 chars max)
+ */
+static void make_key(uint32_t uid_upper, uint32_t uid_lower, char key[16]) {
+    snprintf(key, 16, "%08" PRIx32 "%07" PRIx32, uid_upper, uid_lower & 0x0FFFFFFF);
+}
+
+esp_err_t vl53l0x_cal_load(uint32_t uid_upper, uint32_t uid_lower, vl53l0x_ref_cal_t* cal) {
+    if (!cal) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(CAL_NAMESPACE, NVS_READONLY, &nvs);
+    if (ret != ESP_OK) {
+        // Namespace missing means nothing was ever stored
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    char key[16];
+    make_key(uid_upper, uid_lower, key);
+    
+    size_t size = sizeof(*cal);
+    ret = nvs_get_blob(nvs, key, cal, &size);
+    nvs_close(nvs);
+    
+    if (ret != ESP_OK || size != sizeof(*cal) || cal->version != CAL_VERSION ||
+        cal->uid_upper != uid_upper || cal->uid_lower != uid_lower) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    return ESP_OK;
+}
+
+esp_err_t vl53l0x_cal_save(const vl53l0x_ref_cal_t* cal) {
+    if (!cal) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(CAL_NAMESPACE, NVS_READWRITE, &nvs);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to open NVS: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    vl53l0x_ref_cal_t record = *cal;
+    record.version = CAL_VERSION;
+    
+    char key[16];
+    make_key(cal->uid_upper, cal->uid_lower, key);
+    
+    ret = nvs_set_blob(nvs, key, &record, sizeof(record));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+    
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to store calibration: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+esp_err_t vl53l0x_cal_erase(uint32_t uid_upper, uint32_t uid_lower) {
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(CAL_NAMESPACE, NVS_READWRITE, &nvs);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    char key[16];
+    make_key(uid_upper, uid_lower, key);
+    
+    ret = nvs_erase_key(nvs, key);
+    if (ret == ESP_OK) {
+        ret = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+    
+    return (ret == ESP_ERR_NVS_NOT_FOUND) ? ESP_OK : ret;
+}
@@ -0,0 +1,50 @@
+/**
+ * @file vl53l0x_cal_store.h
+ * @brief Internal NVS cache for VL53L0X reference calibration
+ */
+
+#ifndef VL53L0X_CAL_STORE_H
+#define VL53L0X_CAL_STORE_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Reference calibration of one sensor
+ */
+typedef struct {
+    uint32_t uid_upper;          // Sensor unique ID (verified on load)
+    uint32_t uid_lower;
+    uint32_t ref_spad_count;     // Reference SPAD count
+    uint8_t is_aperture_spads;   // Reference SPAD type
+    uint8_t vhv_settings;        // VHV calibration
+    uint8_t phase_cal;           // Phase calibration
+    uint8_t version;             // Record layout version
+} vl53l0x_ref_cal_t;
+
+/**
+ * @brief Load the cached calibration for a sensor
+ *
+ * @return ESP_OK if a matching record was found, ESP_ERR_NOT_FOUND otherwise
+ */
+esp_err_t vl53l0x_cal_load(uint32_t uid_upper, uint32_t uid_lower, vl53l0x_ref_cal_t* cal);
+
+/**
+ * @brief Store a sensor's calibration (cal->uid_* select the record)
+ */
+esp_err_t vl53l0x_cal_save(const vl53l0x_ref_cal_t* cal);
+
+/**
+ * @brief Delete a sensor's cached calibration
+ */
+esp_err_t vl53l0x_cal_erase(uint32_t uid_upper, uint32_t uid_lower);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VL53L0X_CAL_STORE_H
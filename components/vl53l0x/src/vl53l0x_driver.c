@@ -6,45 +6,541 @@
 #include "vl53l0x_driver.h"
 #include "vl53l0x_api.h"
 #include "vl53l0x_platform.h"
+#include "vl53l0x_bus.h"
+#include "vl53l0x_cal_store.h"
+#include "vl53l0x_ring.h"
+#ifdef VL53L0X_SIMULATOR
+#include "vl53l0x_sim_io.h"
+#endif
+#include "vl53l0x_api_core.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 #include "driver/i2c_master.h"
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
 
 static const char *TAG = "VL53L0X_DRV";
 
-// I2C bus handle (one per I2C bus)
-static i2c_master_bus_handle_t i2c_bus_handle = NULL;
-static bool i2c_bus_initialized = false;
+#define POLL_SPIN_MAX_US        2000    // Longest sub-tick remainder busy-waited instead of slept
+#define POLL_FAST_INTERVAL_US   250     // Spacing of the first polls after the expected completion
+#define POLL_FAST_COUNT         8       // Fast polls before falling back to one-tick sleeps
+#define WAIT_MARGIN_US          10000   // Slack added to measurement deadlines
+#define DEGRADED_AFTER_FAILURES 2       // Consecutive failed samples before reporting degraded
+#define THRESHOLD_DEFAULT_HEARTBEAT_MS 250  // Longest gap between samples read in threshold mode
 
-// Current device handle for platform layer access
-i2c_master_dev_handle_t g_current_vl53l0x_dev_handle = NULL;
+#define VL53L0X_BOOT_ADDRESS        0x29    // 7-bit address after reset
+#define XSHUT_RESET_US              1000    // XSHUT low time before release
+#define XSHUT_BOOT_US               2000    // Boot time after XSHUT release (1.2 ms max)
+#define ADDRESS_PROBE_TIMEOUT_MS    10
+#define INIT_TASK_STACK             4096    // bring_up() workers of vl53l0x_init_multi()
+#define INIT_TASK_PRIORITY          5
+#define CONTINUOUS_TASK_STACK       4096
+#define CONTINUOUS_TASK_PRIORITY    5
+
+// Ultra fast mode: only pre-range and final range run, at the shortest VCSEL periods
+#define ULTRA_FAST_BUDGET_US        8000
+#define ULTRA_FAST_PRE_RANGE_MS     1.0     // Pre-range timeout; final range gets the rest
+#define ULTRA_FAST_VCSEL_PRE_RANGE  12
+#define ULTRA_FAST_VCSEL_FINAL      8
+
+// Multi-shot mode: HIGH_SPEED shots combined by a signal-weighted trimmed mean
+#define MULTI_SHOT_DEFAULT_COUNT    8
+#define MULTI_SHOT_MIN_SHOTS        4       // Shots before an early exit is considered
+#define MULTI_SHOT_TRIM_DIVISOR     8       // Drop about 1/8 of the valid shots at each end...
+#define MULTI_SHOT_TRIM_ROUND       4       // ...rounded so one goes from four shots on
+
+#define MODE_COUNT          (VL53L0X_MODE_MULTI_SHOT + 1)
+#define PRESET_COUNT        (VL53L0X_MODE_ULTRA_FAST + 1)   // MULTI_SHOT runs on the HIGH_SPEED preset
+#define PRESET_NONE         0xFF    // active_preset when the device state is unknown
+#define PRESET_IMAGE_SIZE   16      // Bytes covered by preset_runs
+
+/**
+ * @brief Page 0 registers a mode change touches, as runs of consecutive indices
+ */
+static const struct {
+    uint8_t reg;
+    uint8_t len;
+} preset_runs[] = {
+    { VL53L0X_REG_SYSTEM_SEQUENCE_CONFIG, 1 },
+    { VL53L0X_REG_ALGO_PHASECAL_CONFIG_TIMEOUT, 1 },
+    { VL53L0X_REG_GLOBAL_CONFIG_VCSEL_WIDTH, 1 },
+    { VL53L0X_REG_FINAL_RANGE_CONFIG_MIN_COUNT_RATE_RTN_LIMIT, 5 },  // Rate limit, MSRC timeout, final valid phase
+    { VL53L0X_REG_PRE_RANGE_CONFIG_VCSEL_PERIOD, 3 },                 // Pre-range VCSEL period and timeout
+    { VL53L0X_REG_PRE_RANGE_CONFIG_VALID_PHASE_LOW, 2 },
+    { VL53L0X_REG_FINAL_RANGE_CONFIG_VCSEL_PERIOD, 3 },               // Final range VCSEL period and timeout
+};
+
+/**
+ * @brief Device and ST API state of one mode, captured at init
+ */
+typedef struct {
+    uint8_t image[PRESET_IMAGE_SIZE];        // preset_runs registers, in table order
+    uint8_t phasecal_lim;                    // ALGO_PHASECAL_LIM (page 1)
+    uint8_t phasecal;                        // Phase calibration result (private register 0xEE)
+    uint8_t pre_range_vcsel;
+    uint8_t final_range_vcsel;
+    uint16_t last_encoded_timeout;
+    uint32_t budget_us;
+    uint32_t pre_range_us;
+    uint32_t final_range_us;
+    FixPoint1616_t limit_values[VL53L0X_CHECKENABLE_NUMBER_OF_CHECKS];
+} mode_preset_t;
+
+/**
+ * @brief What a mode switch needs, left out with config.fixed_mode
+ */
+typedef struct {
+    mode_preset_t presets[PRESET_COUNT];     // Register image of every mode
+    vl53l0x_mode_stats_t stats;
+} mode_table_t;
+
+/**
+ * @brief Timestamps of the async single shot
+ */
+typedef struct {
+    int64_t start_us;                        // When it was started
+    int64_t done_us;                         // When it was first seen complete (0 = not yet)
+} async_shot_t;
+
+/**
+ * @brief One shot of a MULTI_SHOT sample
+ */
+typedef struct {
+    uint16_t distance_mm;
+    uint8_t range_status;
+    float signal_rate_mcps;
+    float ambient_rate_mcps;
+} shot_t;
 
 /**
  * @brief Internal handle structure
+ * 
+ * Fields used on every sample come first; the ring slots follow the
+ * structure in the same allocation. State that only some applications
+ * use sits in separate blocks, allocated when first needed.
  */
 struct vl53l0x_handle_s {
-    VL53L0X_Dev_t device;
-    i2c_master_dev_handle_t i2c_dev_handle;  // I2C device handle
+    VL53L0X_Dev_t device;                    // ST device (carries its own I2C handle)
     vl53l0x_config_t config;
+    SemaphoreHandle_t mutex;
+    TaskHandle_t waiting_task;               // Task blocked on the data-ready interrupt
     vl53l0x_measurement_cb_t callback;
     void* user_data;
-    TaskHandle_t task_handle;
-    SemaphoreHandle_t mutex;
+    int64_t last_sample_us;                  // When the previous continuous sample completed
+    uint32_t sample_period_ms;               // Expected time between continuous samples
+    uint32_t consecutive_failures;           // Failed samples since the last good one
+    uint32_t continuous_seq;                 // Ring head when continuous ranging started
+    vl53l0x_health_t health;
+    volatile bool irq_fired;                 // GPIO1 edge seen since the last trigger
+    bool threshold_armed;                    // Continuous samples are read only on window crossings
     bool is_continuous;
+    bool polled;                             // Continuous ranging read out by vl53l0x_poll_ranging(), no task
     bool is_initialized;
+    bool async_pending;                      // Async single shot in flight
+    uint8_t shot_count;
+    uint8_t active_preset;                   // Preset the device holds, PRESET_NONE if unknown
+    shot_t* shots;                           // MULTI_SHOT group being accumulated, NULL until needed
+    vl53l0x_ring_t ring;                     // Timestamped sample history
+    
+    TaskHandle_t task_handle;
+    mode_table_t* modes;                     // NULL with config.fixed_mode
+    async_shot_t* async;                     // NULL until the first async single shot
+    vl53l0x_wait_stats_t* wait_stats;        // Data ready polling counters, NULL until reset
 };
 
 /**
- * @brief Configure sensor mode
+ * @brief Preset a mode runs on: MULTI_SHOT takes HIGH_SPEED shots
+ */
+static inline uint8_t preset_of(vl53l0x_mode_t mode) {
+    return (mode == VL53L0X_MODE_MULTI_SHOT) ? VL53L0X_MODE_HIGH_SPEED : (uint8_t)mode;
+}
+
+/**
+ * @brief Allocate the MULTI_SHOT group buffer if not done yet
+ */
+static esp_err_t alloc_shots(vl53l0x_handle_t handle) {
+    if (!handle->shots) {
+        handle->shots = (shot_t*)calloc(handle->config.multi_shot_count, sizeof(shot_t));
+    }
+    return handle->shots ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+/**
+ * @brief Free a handle and every block hanging from it
+ */
+static void free_handle(vl53l0x_handle_t handle) {
+    free(handle->shots);
+    free(handle->modes);
+    free(handle->async);
+    free(handle->wait_stats);
+    free(handle);
+}
+
+/**
+ * @brief GPIO1 (data ready) interrupt handler
+ */
+static void IRAM_ATTR data_ready_isr(void* arg) {
+    vl53l0x_handle_t handle = (vl53l0x_handle_t)arg;
+    BaseType_t higher_priority_woken = pdFALSE;
+    
+    handle->irq_fired = true;
+    TaskHandle_t task = handle->waiting_task;
+    if (task) {
+        vTaskNotifyGiveFromISR(task, &higher_priority_woken);
+    }
+    portYIELD_FROM_ISR(higher_priority_woken);
+}
+
+/**
+ * @brief Configure sensor GPIO1 as "new sample ready" and hook its interrupt
+ */
+static esp_err_t configure_data_ready_interrupt(vl53l0x_handle_t handle) {
+    gpio_num_t pin = handle->config.gpio_int_pin;
+    
+    // GPIO1 is open-drain and pulled low while a result is pending
+    VL53L0X_Error status = VL53L0X_SetGpioConfig(&handle->device, 0,
+            VL53L0X_DEVICEMODE_SINGLE_RANGING,
+            VL53L0X_GPIOFUNCTIONALITY_NEW_MEASURE_READY,
+            VL53L0X_INTERRUPTPOLARITY_LOW);
+    if (status != VL53L0X_ERROR_NONE) {
+        ESP_LOGE(TAG, "SetGpioConfig failed: %d", status);
+        return ESP_FAIL;
+    }
+    
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << pin,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_NEGEDGE,
+    };
+    esp_err_t ret = gpio_config(&io_conf);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    // The ISR service may already be installed by another sensor or component
+    ret = gpio_install_isr_service(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "Failed to install GPIO ISR service: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    ret = gpio_isr_handler_add(pin, data_ready_isr, handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add GPIO%d ISR: %s", pin, esp_err_to_name(ret));
+        return ret;
+    }
+    
+    ESP_LOGI(TAG, "Data ready interrupt on GPIO%d", pin);
+    return ESP_OK;
+}
+
+/**
+ * @brief Account one wait in the per-handle poll counters
+ * 
+ * @param finished false when the caller's own timeout ended the wait before
+ *                 the sample or the sensor deadline: only the polls count
+ */
+static void record_wait(vl53l0x_handle_t handle, uint32_t polls, VL53L0X_Error status, bool finished,
+                        bool lock_bus) {
+    if (lock_bus) {
+        xSemaphoreTake(handle->mutex, portMAX_DELAY);
+    }
+    
+    // Not counting until vl53l0x_reset_wait_stats()
+    vl53l0x_wait_stats_t* stats = handle->wait_stats;
+    if (stats) {
+        stats->data_ready_polls += polls;
+        if (finished) {
+            stats->measurements++;
+            if (polls > stats->max_polls_per_measurement) {
+                stats->max_polls_per_measurement = polls;
+            }
+            if (status == VL53L0X_ERROR_TIME_OUT) {
+                stats->timeouts++;
+            }
+        }
+    }
+    
+    if (lock_bus) {
+        xSemaphoreGive(handle->mutex);
+    }
+}
+
+/**
+ * @brief Read the data ready flag once, optionally taking the handle mutex
+ * 
+ * With data set, a ready sample is fetched and its interrupt cleared in
+ * the same poll (VL53L0X_GetRangingMeasurementDataFast).
+ */
+static VL53L0X_Error read_data_ready(vl53l0x_handle_t handle, uint8_t* ready,
+                                     VL53L0X_RangingMeasurementData_t* data, bool lock_bus) {
+    if (lock_bus) {
+        xSemaphoreTake(handle->mutex, portMAX_DELAY);
+    }
+    VL53L0X_Error status = data ? VL53L0X_GetRangingMeasurementDataFast(&handle->device, ready, data)
+                                : VL53L0X_GetMeasurementDataReady(&handle->device, ready);
+    if (lock_bus) {
+        xSemaphoreGive(handle->mutex);
+    }
+    return status;
+}
+
+/**
+ * @brief Sleep until the expected completion time, then poll data ready
+ * 
+ * The task sleeps in whole ticks up to the expected completion time and
+ * only busy-waits a short sub-tick remainder. A few closely spaced polls
+ * follow; after that it falls back to one-tick sleeps until the deadline.
+ * 
+ * @param expected_us esp_timer time at which the sample should be ready
+ * @param deadline_us esp_timer time after which the wait times out
+ * @param caller_deadline deadline_us is the caller's timeout, not the
+ *                        sensor's: running into it is not a sensor timeout
+ * @param data If set, the sample is read out by the poll that finds it ready
+ * @param lock_bus Take the handle mutex around each poll
+ */
+static VL53L0X_Error wait_for_completion(vl53l0x_handle_t handle, int64_t expected_us,
+                                         int64_t deadline_us, bool caller_deadline,
+                                         VL53L0X_RangingMeasurementData_t* data, bool lock_bus) {
+    const int64_t tick_us = (int64_t)portTICK_PERIOD_MS * 1000;
+    int64_t remaining_us = expected_us - esp_timer_get_time();
+    
+    if (remaining_us >= tick_us) {
+        vTaskDelay((TickType_t)(remaining_us / tick_us));
+        remaining_us = expected_us - esp_timer_get_time();
+    }
+    if (remaining_us > POLL_SPIN_MAX_US) {
+        vTaskDelay(1);
+    } else if (remaining_us > 0) {
+        esp_rom_delay_us((uint32_t)remaining_us);
+    }
+    
+    VL53L0X_Error status;
+    uint32_t polls = 0;
+    uint8_t ready = 0;
+    
+    while (1) {
+        status = read_data_ready(handle, &ready, data, lock_bus);
+        polls++;
+        
+        if (status != VL53L0X_ERROR_NONE || ready) {
+            break;
+        }
+        if (esp_timer_get_time() >= deadline_us) {
+            status = VL53L0X_ERROR_TIME_OUT;
+            break;
+        }
+        
+        if (polls < POLL_FAST_COUNT) {
+            esp_rom_delay_us(POLL_FAST_INTERVAL_US);
+        } else {
+            vTaskDelay(1);
+        }
+    }
+    
+    record_wait(handle, polls, status, !(caller_deadline && status == VL53L0X_ERROR_TIME_OUT), lock_bus);
+    return status;
+}
+
+/**
+ * @brief Sleep on the GPIO1 interrupt until the sample is ready
+ * 
+ * If the edge was missed, the status register is checked once before
+ * reporting a timeout. With data set, the announced sample is read out.
+ */
+static VL53L0X_Error wait_for_interrupt(vl53l0x_handle_t handle, int64_t deadline_us,
+                                        VL53L0X_RangingMeasurementData_t* data, bool lock_bus) {
+    const int64_t tick_us = (int64_t)portTICK_PERIOD_MS * 1000;
+    int64_t remaining_us = deadline_us - esp_timer_get_time();
+    TickType_t timeout = remaining_us > 0 ? (TickType_t)(remaining_us / tick_us) + 1 : 1;
+    
+    bool notified = ulTaskNotifyTake(pdTRUE, timeout) > 0;
+    if (notified && !data) {
+        record_wait(handle, 0, VL53L0X_ERROR_NONE, true, lock_bus);
+        return VL53L0X_ERROR_NONE;
+    }
+    
+    uint8_t ready = 0;
+    VL53L0X_Error status = read_data_ready(handle, &ready, data, lock_bus);
+    if (status == VL53L0X_ERROR_NONE && !ready) {
+        status = VL53L0X_ERROR_TIME_OUT;
+    }
+    
+    record_wait(handle, notified ? 0 : 1, status, true, lock_bus);
+    return status;
+}
+
+/**
+ * @brief Poll the interrupt status until a threshold crossing or the deadline
+ * 
+ * Without GPIO1 a crossing is only visible in RESULT_INTERRUPT_STATUS: one
+ * byte per sample period instead of the whole result block. The sample is
+ * read out once flagged, or at the deadline to prove the sensor is still
+ * ranging. Continuous mode only; takes the mutex around each poll.
+ */
+static VL53L0X_Error wait_for_threshold(vl53l0x_handle_t handle, int64_t deadline_us,
+                                        VL53L0X_RangingMeasurementData_t* data) {
+    const int64_t period_us = (int64_t)handle->sample_period_ms * 1000;
+    TickType_t period_ticks = pdMS_TO_TICKS(handle->sample_period_ms);
+    VL53L0X_Error status = VL53L0X_ERROR_NONE;
+    uint32_t mask = 0;
+    uint32_t polls = 0;
+    
+    while (handle->is_continuous && mask == 0 && esp_timer_get_time() + period_us < deadline_us) {
+        vTaskDelay(period_ticks > 0 ? period_ticks : 1);
+        
+        xSemaphoreTake(handle->mutex, portMAX_DELAY);
+        status = VL53L0X_GetInterruptMaskStatus(&handle->device, &mask);
+        xSemaphoreGive(handle->mutex);
+        polls++;
+        
+        if (status == VL53L0X_ERROR_RANGE_ERROR) {
+            // Error bits next to the cause: let the readout decode the sample
+            status = VL53L0X_ERROR_NONE;
+            mask = 1;
+        } else if (status != VL53L0X_ERROR_NONE) {
+            record_wait(handle, polls, status, true, true);
+            return status;
+        }
+    }
+    
+    uint8_t ready = 0;
+    status = read_data_ready(handle, &ready, data, true);
+    polls++;
+    if (status == VL53L0X_ERROR_NONE && !ready) {
+        status = VL53L0X_ERROR_TIME_OUT;
+    }
+    
+    record_wait(handle, polls, status, true, true);
+    return status;
+}
+
+/**
+ * @brief Run one single-shot ranging
+ * 
+ * Waits on the GPIO1 interrupt when a pin is configured, otherwise sleeps
+ * for the timing budget before polling. Must be called with the mutex held.
+ */
+static VL53L0X_Error perform_single_ranging(vl53l0x_handle_t handle,
+                                            VL53L0X_RangingMeasurementData_t* data,
+                                            int64_t* complete_us) {
+    VL53L0X_DEV dev = &handle->device;
+    bool use_irq = (handle->config.gpio_int_pin != GPIO_NUM_NC);
+    uint32_t budget_us;
+    VL53L0X_GETPARAMETERFIELD(dev, MeasurementTimingBudgetMicroSeconds, budget_us);
+    
+    VL53L0X_Error status = VL53L0X_SetDeviceMode(dev, VL53L0X_DEVICEMODE_SINGLE_RANGING);
+    
+    if (use_irq) {
+        handle->waiting_task = xTaskGetCurrentTaskHandle();
+        ulTaskNotifyTake(pdTRUE, 0);  // Drop any stale notification
+    }
+    
+    if (status == VL53L0X_ERROR_NONE) {
+        vl53l0x_batch_begin(dev);
+        status = VL53L0X_StartMeasurement(dev);
+        VL53L0X_Error flush_status = vl53l0x_batch_end(dev);
+        if (status == VL53L0X_ERROR_NONE) {
+            status = flush_status;
+        }
+    }
+    
+    // Allow twice the timing budget before declaring the sensor stuck
+    int64_t start_us = esp_timer_get_time();
+    int64_t deadline_us = start_us + 2 * (int64_t)budget_us + WAIT_MARGIN_US;
+    
+    if (status == VL53L0X_ERROR_NONE) {
+        status = use_irq ? wait_for_interrupt(handle, deadline_us, NULL, false)
+                         : wait_for_completion(handle, start_us + budget_us, deadline_us, false, NULL, false);
+    }
+    
+    handle->waiting_task = NULL;
+    *complete_us = esp_timer_get_time();
+    
+    if (status == VL53L0X_ERROR_NONE) {
+        PALDevDataSet(dev, PalState, VL53L0X_STATE_IDLE);
+        status = VL53L0X_GetRangingMeasurementData(dev, data);
+    }
+    if (status == VL53L0X_ERROR_NONE) {
+        status = VL53L0X_ClearInterruptMask(dev, 0);
+    }
+    
+    return status;
+}
+
+/**
+ * @brief Program the ultra fast sequence
+ * 
+ * TCC (target centre check), MSRC (minimum signal rate check) and DSS
+ * (dynamic SPAD selection) are dropped: the first two only gate weak or
+ * off-centre returns and DSS mostly matters for close, highly reflective
+ * targets, where the short integration keeps the SPADs out of saturation
+ * anyway. Pre-range stays on because the final range relies on its
+ * ambient and phase estimate.
+ */
+static VL53L0X_Error apply_ultra_fast(vl53l0x_handle_t handle) {
+    VL53L0X_DEV dev = &handle->device;
+    
+    // Steps off first: each change recomputes the final range from the budget
+    VL53L0X_Error status = VL53L0X_SetSequenceStepEnable(dev, VL53L0X_SEQUENCESTEP_TCC, 0);
+    if (status == VL53L0X_ERROR_NONE) {
+        status = VL53L0X_SetSequenceStepEnable(dev, VL53L0X_SEQUENCESTEP_MSRC, 0);
+    }
+    if (status == VL53L0X_ERROR_NONE) {
+        status = VL53L0X_SetSequenceStepEnable(dev, VL53L0X_SEQUENCESTEP_DSS, 0);
+    }
+    if (status == VL53L0X_ERROR_NONE) {
+        status = VL53L0X_SetVcselPulsePeriod(dev, VL53L0X_VCSEL_PERIOD_PRE_RANGE,
+                                             ULTRA_FAST_VCSEL_PRE_RANGE);
+    }
+    if (status == VL53L0X_ERROR_NONE) {
+        status = VL53L0X_SetVcselPulsePeriod(dev, VL53L0X_VCSEL_PERIOD_FINAL_RANGE,
+                                             ULTRA_FAST_VCSEL_FINAL);
+    }
+    if (status == VL53L0X_ERROR_NONE) {
+        status = VL53L0X_SetSequenceStepTimeout(dev, VL53L0X_SEQUENCESTEP_PRE_RANGE,
+                                                (FixPoint1616_t)(ULTRA_FAST_PRE_RANGE_MS * 65536));
+    }
+    if (status == VL53L0X_ERROR_NONE) {
+        status = VL53L0X_SetLimitCheckValue(dev, VL53L0X_CHECKENABLE_SIGNAL_RATE_FINAL_RANGE,
+                                            (FixPoint1616_t)(0.25 * 65536));
+    }
+    if (status == VL53L0X_ERROR_NONE) {
+        status = VL53L0X_SetLimitCheckValue(dev, VL53L0X_CHECKENABLE_SIGMA_FINAL_RANGE,
+                                            (FixPoint1616_t)(60 * 65536));
+    }
+    if (status == VL53L0X_ERROR_NONE) {
+        status = VL53L0X_SetMeasurementTimingBudgetMicroSeconds(dev, ULTRA_FAST_BUDGET_US);
+    }
+    
+    return status;
+}
+
+/**
+ * @brief Program a mode through the ST API
+ * 
+ * Expects the device in the default configuration; only used to build the
+ * presets, or once at init with config.fixed_mode.
  */
-static esp_err_t configure_mode(vl53l0x_handle_t handle, vl53l0x_mode_t mode) {
+static VL53L0X_Error configure_mode(vl53l0x_handle_t handle, vl53l0x_mode_t mode) {
     VL53L0X_Error status = VL53L0X_ERROR_NONE;
     
+    vl53l0x_batch_begin(&handle->device);
+    
     switch (mode) {
+        case VL53L0X_MODE_ULTRA_FAST:
+            status = apply_ultra_fast(handle);
+            break;
+            
         case VL53L0X_MODE_HIGH_ACCURACY:
             status = VL53L0X_SetLimitCheckValue(&handle->device,
                     VL53L0X_CHECKENABLE_SIGNAL_RATE_FINAL_RANGE,
@@ -60,6 +556,7 @@ static esp_err_t configure_mode(vl53l0x_handle_t handle, vl53l0x_mode_t mode) {
             break;
             
         case VL53L0X_MODE_HIGH_SPEED:
+        case VL53L0X_MODE_MULTI_SHOT:
             status = VL53L0X_SetLimitCheckValue(&handle->device,
                     VL53L0X_CHECKENABLE_SIGNAL_RATE_FINAL_RANGE,
                     (FixPoint1616_t)(0.25 * 65536));
@@ -101,212 +598,1573 @@ static esp_err_t configure_mode(vl53l0x_handle_t handle, vl53l0x_mode_t mode) {
             break;
     }
     
-    return (status == VL53L0X_ERROR_NONE) ? ESP_OK : ESP_FAIL;
+    VL53L0X_Error flush_status = vl53l0x_batch_end(&handle->device);
+    if (status == VL53L0X_ERROR_NONE) {
+        status = flush_status;
+    }
+    
+    return status;
 }
 
 /**
- * @brief Continuous measurement task
+ * @brief Write one register, counting it if it reaches the sensor
+ * 
+ * Page selects that the platform layer drops as redundant are not counted.
  */
-static void continuous_task(void* arg) {
-    vl53l0x_handle_t handle = (vl53l0x_handle_t)arg;
-    VL53L0X_RangingMeasurementData_t measurement_data;
-    vl53l0x_measurement_t measurement;
+static VL53L0X_Error write_counted(VL53L0X_DEV dev, uint8_t index, uint8_t value, uint32_t* written) {
+    if (index != 0xFF || !dev->i2c_page_valid || dev->i2c_page != value) {
+        (*written)++;
+    }
+    return VL53L0X_WrByte(dev, index, value);
+}
+
+/**
+ * @brief Access the phase calibration registers
+ * 
+ * The result register sits behind the same unlock sequence
+ * VL53L0X_ref_calibration_io() uses. It is restored raw, bit 7 included,
+ * which is safe because it comes from the same device.
+ * 
+ * @param written Incremented by the registers written, unlock sequence included
+ */
+static VL53L0X_Error phasecal_io(VL53L0X_DEV dev, bool read, uint8_t* lim, uint8_t* phasecal,
+                                 uint32_t* written) {
+    VL53L0X_Error status = write_counted(dev, 0xFF, 0x01, written);
+    status |= read ? VL53L0X_RdByte(dev, VL53L0X_REG_ALGO_PHASECAL_LIM, lim)
+                   : write_counted(dev, VL53L0X_REG_ALGO_PHASECAL_LIM, *lim, written);
+    status |= write_counted(dev, 0x00, 0x00, written);
+    status |= write_counted(dev, 0xFF, 0x00, written);
+    status |= read ? VL53L0X_RdByte(dev, 0xEE, phasecal)
+                   : write_counted(dev, 0xEE, *phasecal, written);
+    status |= write_counted(dev, 0xFF, 0x01, written);
+    status |= write_counted(dev, 0x00, 0x01, written);
+    status |= write_counted(dev, 0xFF, 0x00, written);
     
-    while (handle->is_continuous) {
-        VL53L0X_Error status = VL53L0X_PerformSingleRangingMeasurement(&handle->device, &measurement_data);
-        
+    return status;
+}
+
+/**
+ * @brief Read back the current device and ST API state into a preset
+ */
+static VL53L0X_Error capture_preset(vl53l0x_handle_t handle, mode_preset_t* preset) {
+    VL53L0X_DEV dev = &handle->device;
+    VL53L0X_Error status = VL53L0X_ERROR_NONE;
+    uint8_t* image = preset->image;
+    
+    for (size_t i = 0; i < sizeof(preset_runs) / sizeof(preset_runs[0]); i++) {
+        status = VL53L0X_ReadMulti(dev, preset_runs[i].reg, image, preset_runs[i].len);
+        if (status != VL53L0X_ERROR_NONE) {
+            return status;
+        }
+        image += preset_runs[i].len;
+    }
+    uint32_t written = 0;
+    status = phasecal_io(dev, true, &preset->phasecal_lim, &preset->phasecal, &written);
+    
+    VL53L0X_GETPARAMETERFIELD(dev, MeasurementTimingBudgetMicroSeconds, preset->budget_us);
+    for (int i = 0; i < VL53L0X_CHECKENABLE_NUMBER_OF_CHECKS; i++) {
+        VL53L0X_GETARRAYPARAMETERFIELD(dev, LimitChecksValue, i, preset->limit_values[i]);
+    }
+    preset->pre_range_vcsel = VL53L0X_GETDEVICESPECIFICPARAMETER(dev, PreRangeVcselPulsePeriod);
+    preset->final_range_vcsel = VL53L0X_GETDEVICESPECIFICPARAMETER(dev, FinalRangeVcselPulsePeriod);
+    preset->pre_range_us = VL53L0X_GETDEVICESPECIFICPARAMETER(dev, PreRangeTimeoutMicroSecs);
+    preset->final_range_us = VL53L0X_GETDEVICESPECIFICPARAMETER(dev, FinalRangeTimeoutMicroSecs);
+    preset->last_encoded_timeout = VL53L0X_GETDEVICESPECIFICPARAMETER(dev, LastEncodedTimeout);
+    
+    return status;
+}
+
+/**
+ * @brief Switch the device to a captured mode
+ * 
+ * Only the register runs that differ from the active preset are written,
+ * all inside one batch section and without any read; the ST API state is
+ * then overwritten so later calls see the mode as if it had been
+ * programmed normally. The runs are not adjacent, so each one is still a
+ * transfer, and the phase calibration sequence adds up to eight more.
+ * 
+ * @param registers Set to the number of registers written, may be NULL
+ */
+static VL53L0X_Error apply_preset(vl53l0x_handle_t handle, vl53l0x_mode_t mode, uint32_t* registers) {
+    VL53L0X_DEV dev = &handle->device;
+    mode_preset_t* preset = &handle->modes->presets[preset_of(mode)];
+    const mode_preset_t* active = (handle->active_preset < PRESET_COUNT) ?
+                                  &handle->modes->presets[handle->active_preset] : NULL;
+    VL53L0X_Error status = VL53L0X_ERROR_NONE;
+    uint32_t written = 0;
+    size_t offset = 0;
+    
+    // Unknown until the whole image is out: a failure forces a full rewrite next time
+    handle->active_preset = PRESET_NONE;
+    
+    vl53l0x_batch_begin(dev);
+    for (size_t i = 0; i < sizeof(preset_runs) / sizeof(preset_runs[0]) && status == VL53L0X_ERROR_NONE; i++) {
+        uint8_t len = preset_runs[i].len;
+        if (!active || memcmp(&preset->image[offset], &active->image[offset], len) != 0) {
+            status = VL53L0X_WriteMulti(dev, preset_runs[i].reg, &preset->image[offset], len);
+            written += len;
+        }
+        offset += len;
+    }
+    if (status == VL53L0X_ERROR_NONE &&
+        (!active || active->phasecal_lim != preset->phasecal_lim || active->phasecal != preset->phasecal)) {
+        status = phasecal_io(dev, false, &preset->phasecal_lim, &preset->phasecal, &written);
+    }
+    VL53L0X_Error flush_status = vl53l0x_batch_end(dev);
+    if (status == VL53L0X_ERROR_NONE) {
+        status = flush_status;
+    }
+    if (registers) {
+        *registers = written;
+    }
+    if (status != VL53L0X_ERROR_NONE) {
+        return status;
+    }
+    
+    // image[0] is SYSTEM_SEQUENCE_CONFIG, which the ST API mirrors
+    PALDevDataSet(dev, SequenceConfig, preset->image[0]);
+    VL53L0X_SETPARAMETERFIELD(dev, MeasurementTimingBudgetMicroSeconds, preset->budget_us);
+    for (int i = 0; i < VL53L0X_CHECKENABLE_NUMBER_OF_CHECKS; i++) {
+        VL53L0X_SETARRAYPARAMETERFIELD(dev, LimitChecksValue, i, preset->limit_values[i]);
+    }
+    VL53L0X_SETDEVICESPECIFICPARAMETER(dev, PreRangeVcselPulsePeriod, preset->pre_range_vcsel);
+    VL53L0X_SETDEVICESPECIFICPARAMETER(dev, FinalRangeVcselPulsePeriod, preset->final_range_vcsel);
+    VL53L0X_SETDEVICESPECIFICPARAMETER(dev, PreRangeTimeoutMicroSecs, preset->pre_range_us);
+    VL53L0X_SETDEVICESPECIFICPARAMETER(dev, FinalRangeTimeoutMicroSecs, preset->final_range_us);
+    VL53L0X_SETDEVICESPECIFICPARAMETER(dev, LastEncodedTimeout, preset->last_encoded_timeout);
+    handle->active_preset = preset_of(mode);
+    
+    return VL53L0X_ERROR_NONE;
+}
+
+/**
+ * @brief Build the preset of every mode but MULTI_SHOT, which shares HIGH_SPEED's
+ * 
+ * Each mode is programmed through the ST API on top of the default
+ * configuration and read back, so mode switches afterwards never
+ * recompute timeouts or rerun the phase calibration.
+ */
+static VL53L0X_Error capture_presets(vl53l0x_handle_t handle) {
+    VL53L0X_Error status = capture_preset(handle, &handle->modes->presets[VL53L0X_MODE_DEFAULT]);
+    if (status == VL53L0X_ERROR_NONE) {
+        handle->active_preset = VL53L0X_MODE_DEFAULT;
+    }
+    
+    for (int mode = VL53L0X_MODE_DEFAULT + 1; mode < PRESET_COUNT && status == VL53L0X_ERROR_NONE; mode++) {
+        status = apply_preset(handle, VL53L0X_MODE_DEFAULT, NULL);
         if (status == VL53L0X_ERROR_NONE) {
-            measurement.distance_mm = measurement_data.RangeMilliMeter;
-            measurement.range_status = measurement_data.RangeStatus;
-            measurement.signal_rate_mcps = measurement_data.SignalRateRtnMegaCps / 65536.0f;
-            measurement.ambient_rate_mcps = measurement_data.AmbientRateRtnMegaCps / 65536.0f;
-            measurement.is_valid = (measurement_data.RangeStatus == 0);
-            
-            if (handle->callback) {
-                handle->callback(&measurement, handle->user_data);
+            status = configure_mode(handle, (vl53l0x_mode_t)mode);
+        }
+        if (status == VL53L0X_ERROR_NONE) {
+            status = capture_preset(handle, &handle->modes->presets[mode]);
+        }
+        if (status == VL53L0X_ERROR_NONE) {
+            handle->active_preset = mode;
+        }
+    }
+    
+    return status;
+}
+
+/**
+ * @brief Convert ST ranging data to the driver measurement format
+ */
+static void fill_measurement(const VL53L0X_RangingMeasurementData_t* data, int64_t timestamp_us,
+                             vl53l0x_measurement_t* measurement) {
+    measurement->timestamp_us = timestamp_us;
+    measurement->seq = 0;
+    measurement->distance_mm = data->RangeMilliMeter;
+    measurement->range_status = data->RangeStatus;
+    measurement->signal_rate_mcps = data->SignalRateRtnMegaCps / 65536.0f;
+    measurement->ambient_rate_mcps = data->AmbientRateRtnMegaCps / 65536.0f;
+    measurement->is_valid = (data->RangeStatus == 0);
+    measurement->health = VL53L0X_HEALTH_OK;
+    measurement->shots = 1;
+    measurement->variance_mm2 = 0.0f;
+}
+
+/**
+ * @brief Combine the valid shots of a group
+ * 
+ * Valid shots are sorted by distance and about an eighth trimmed off each
+ * end (at least one shot from four on), so a spurious return cannot drag
+ * the result; the rest are averaged weighted by signal rate. The variance
+ * follows the trimmed-mean estimate from the winsorized spread: the kept
+ * shots alone sit closer together than the population does.
+ * 
+ * @return false when fewer than two shots were valid
+ */
+static bool combine_shots(const shot_t* shots, uint8_t count, vl53l0x_measurement_t* combined) {
+    const shot_t* valid[VL53L0X_MULTI_SHOT_MAX];
+    uint8_t n = 0;
+    
+    for (uint8_t i = 0; i < count; i++) {
+        if (shots[i].range_status != 0) {
+            continue;
+        }
+        // Insertion sort by distance
+        uint8_t j = n++;
+        while (j > 0 && valid[j - 1]->distance_mm > shots[i].distance_mm) {
+            valid[j] = valid[j - 1];
+            j--;
+        }
+        valid[j] = &shots[i];
+    }
+    if (n < 2) {
+        return false;
+    }
+    
+    uint8_t trim = (n + MULTI_SHOT_TRIM_ROUND) / MULTI_SHOT_TRIM_DIVISOR;
+    uint8_t kept = n - 2 * trim;
+    float sum_w = 0.0f, sum_wd = 0.0f, sum_d = 0.0f, signal = 0.0f, ambient = 0.0f;
+    for (uint8_t i = trim; i < n - trim; i++) {
+        float w = valid[i]->signal_rate_mcps > 0.0f ? valid[i]->signal_rate_mcps : 1e-3f;
+        sum_w += w;
+        sum_wd += w * valid[i]->distance_mm;
+        sum_d += valid[i]->distance_mm;
+        signal += valid[i]->signal_rate_mcps;
+        ambient += valid[i]->ambient_rate_mcps;
+    }
+    
+    // Winsorize: trimmed shots count as the nearest kept one
+    float low = valid[trim]->distance_mm;
+    float high = valid[n - trim - 1]->distance_mm;
+    float winsorized_mean = (sum_d + trim * (low + high)) / n;
+    float spread = 0.0f;
+    for (uint8_t i = 0; i < n; i++) {
+        float d = fminf(fmaxf(valid[i]->distance_mm, low), high) - winsorized_mean;
+        spread += d * d;
+    }
+    
+    combined->distance_mm = (uint16_t)(sum_wd / sum_w + 0.5f);
+    combined->range_status = 0;
+    combined->is_valid = true;
+    combined->signal_rate_mcps = signal / kept;
+    combined->ambient_rate_mcps = ambient / kept;
+    combined->variance_mm2 = spread / (n - 1) * n / ((float)kept * kept);
+    return true;
+}
+
+/**
+ * @brief Add one shot to the MULTI_SHOT group
+ * 
+ * The group closes after config.multi_shot_count shots, or earlier once at
+ * least MULTI_SHOT_MIN_SHOTS are in and the combined standard deviation is
+ * below config.multi_shot_target_sd_mm. Must be called with the mutex held.
+ * 
+ * @param shot Sample read from the sensor
+ * @param combined Filled with the group result when it closes
+ * @return true when the group closed
+ */
+static bool add_shot(vl53l0x_handle_t handle, const vl53l0x_measurement_t* shot,
+                     vl53l0x_measurement_t* combined) {
+    shot_t* slot = &handle->shots[handle->shot_count++];
+    slot->distance_mm = shot->distance_mm;
+    slot->range_status = shot->range_status;
+    slot->signal_rate_mcps = shot->signal_rate_mcps;
+    slot->ambient_rate_mcps = shot->ambient_rate_mcps;
+    
+    uint8_t count = handle->shot_count;
+    float target_sd = handle->config.multi_shot_target_sd_mm;
+    bool full = (count >= handle->config.multi_shot_count);
+    if (!full && (count < MULTI_SHOT_MIN_SHOTS || target_sd <= 0.0f)) {
+        return false;
+    }
+    
+    *combined = *shot;
+    bool valid = combine_shots(handle->shots, count, combined);
+    if (!full && (!valid || combined->variance_mm2 > target_sd * target_sd)) {
+        return false;
+    }
+    
+    if (!valid) {
+        // Fewer than two valid shots: no usable sample, report why a shot failed
+        combined->is_valid = false;
+        combined->variance_mm2 = 0.0f;
+        for (uint8_t i = 0; i < count; i++) {
+            if (handle->shots[i].range_status != 0) {
+                combined->range_status = handle->shots[i].range_status;
+                break;
+            }
+        }
+    }
+    combined->shots = count;
+    handle->shot_count = 0;
+    return true;
+}
+
+/**
+ * @brief Track consecutive sample failures and the resulting health state
+ * 
+ * Must be called with the handle mutex held.
+ */
+static void update_health(vl53l0x_handle_t handle, bool sample_ok) {
+    if (sample_ok) {
+        if (handle->health != VL53L0X_HEALTH_OK) {
+            ESP_LOGI(TAG, "Sensor 0x%02X recovered after %lu failed samples",
+                     handle->config.i2c_address, (unsigned long)handle->consecutive_failures);
+        }
+        handle->consecutive_failures = 0;
+        handle->health = VL53L0X_HEALTH_OK;
+        return;
+    }
+    
+    handle->consecutive_failures++;
+    if (handle->consecutive_failures >= DEGRADED_AFTER_FAILURES &&
+        handle->health != VL53L0X_HEALTH_DEGRADED) {
+        ESP_LOGW(TAG, "Sensor 0x%02X degraded", handle->config.i2c_address);
+        handle->health = VL53L0X_HEALTH_DEGRADED;
+    }
+}
+
+/**
+ * @brief Set what GPIO1 (and the interrupt status) flags, if it changes
+ * 
+ * The threshold functionalities only take effect at the next
+ * VL53L0X_StartMeasurement, which loads their tuning.
+ */
+static VL53L0X_Error set_gpio_functionality(vl53l0x_handle_t handle, VL53L0X_GpioFunctionality functionality) {
+    VL53L0X_DEV dev = &handle->device;
+    
+    if (VL53L0X_GETDEVICESPECIFICPARAMETER(dev, Pin0GpioFunctionality) == functionality) {
+        return VL53L0X_ERROR_NONE;
+    }
+    return VL53L0X_SetGpioConfig(dev, 0, VL53L0X_DEVICEMODE_CONTINUOUS_RANGING, functionality,
+                                 VL53L0X_INTERRUPTPOLARITY_LOW);
+}
+
+/**
+ * @brief Put the sensor in hardware continuous or timed ranging
+ * 
+ * GPIO1 flags threshold crossings when a window is armed. Must be called
+ * with the handle mutex held.
+ */
+static VL53L0X_Error start_hw_continuous(vl53l0x_handle_t handle) {
+    VL53L0X_DEV dev = &handle->device;
+    uint32_t budget_us;
+    VL53L0X_GETPARAMETERFIELD(dev, MeasurementTimingBudgetMicroSeconds, budget_us);
+    
+    uint32_t budget_ms = (budget_us + 999) / 1000;
+    uint32_t period_ms = handle->config.target_rate_hz ? 1000 / handle->config.target_rate_hz : 0;
+    VL53L0X_Error status;
+    
+    vl53l0x_batch_begin(dev);
+    
+    if (period_ms > budget_ms) {
+        // Timed ranging: the sensor idles between samples
+        status = VL53L0X_SetDeviceMode(dev, VL53L0X_DEVICEMODE_CONTINUOUS_TIMED_RANGING);
+        if (status == VL53L0X_ERROR_NONE) {
+            status = VL53L0X_SetInterMeasurementPeriodMilliSeconds(dev, period_ms);
+        }
+        handle->sample_period_ms = period_ms;
+    } else {
+        // Back-to-back: a new sample as soon as the previous one ends
+        status = VL53L0X_SetDeviceMode(dev, VL53L0X_DEVICEMODE_CONTINUOUS_RANGING);
+        handle->sample_period_ms = budget_ms;
+    }
+    
+    if (status == VL53L0X_ERROR_NONE) {
+        status = set_gpio_functionality(handle, handle->threshold_armed ?
+                                        VL53L0X_GPIOFUNCTIONALITY_THRESHOLD_CROSSED_OUT :
+                                        VL53L0X_GPIOFUNCTIONALITY_NEW_MEASURE_READY);
+    }
+    if (status == VL53L0X_ERROR_NONE) {
+        status = VL53L0X_ClearInterruptMask(dev, 0);
+    }
+    if (status == VL53L0X_ERROR_NONE) {
+        status = VL53L0X_StartMeasurement(dev);
+    }
+    
+    VL53L0X_Error flush_status = vl53l0x_batch_end(dev);
+    if (status == VL53L0X_ERROR_NONE) {
+        status = flush_status;
+    }
+    handle->last_sample_us = esp_timer_get_time();
+    handle->shot_count = 0;
+    
+    return status;
+}
+
+/**
+ * @brief Stop hardware ranging and return the sensor to single-shot mode
+ * 
+ * Must be called with the handle mutex held.
+ */
+static VL53L0X_Error stop_hw_continuous(vl53l0x_handle_t handle) {
+    VL53L0X_DEV dev = &handle->device;
+    uint32_t stop_status = 1;
+    uint32_t loops = 0;
+    
+    VL53L0X_Error status = VL53L0X_StopMeasurement(dev);
+    
+    // The sensor finishes the running sample before it stops
+    while (status == VL53L0X_ERROR_NONE && stop_status != 0 && loops++ < VL53L0X_DEFAULT_MAX_LOOP) {
+        status = VL53L0X_GetStopCompletedStatus(dev, &stop_status);
+        if (stop_status != 0) {
+            VL53L0X_PollingDelay(dev);
+        }
+    }
+    
+    // Single shots wait for "new sample ready", whatever the window
+    if (status == VL53L0X_ERROR_NONE) {
+        status = set_gpio_functionality(handle, VL53L0X_GPIOFUNCTIONALITY_NEW_MEASURE_READY);
+    }
+    if (status == VL53L0X_ERROR_NONE) {
+        status = VL53L0X_ClearInterruptMask(dev, 0);
+    }
+    VL53L0X_SetDeviceMode(dev, VL53L0X_DEVICEMODE_SINGLE_RANGING);
+    
+    return status;
+}
+
+/**
+ * @brief Wait for the next continuous sample and read it out
+ * 
+ * The next sample is expected one sample period after the previous one.
+ * With a threshold window armed, the next one read is the next flagged
+ * sample, or the latest at the heartbeat. The poll that finds it ready
+ * also fetches it and clears the interrupt. The mutex is only held for
+ * bus access.
+ */
+static VL53L0X_Error wait_data_ready(vl53l0x_handle_t handle, VL53L0X_RangingMeasurementData_t* data) {
+    int64_t period_us = (int64_t)handle->sample_period_ms * 1000;
+    int64_t expected_us = handle->last_sample_us + period_us;
+    int64_t deadline_us = expected_us + period_us + WAIT_MARGIN_US;
+    
+    if (handle->threshold_armed) {
+        int64_t heartbeat_us = (int64_t)handle->config.threshold_heartbeat_ms * 1000;
+        if (handle->last_sample_us + heartbeat_us > deadline_us) {
+            deadline_us = handle->last_sample_us + heartbeat_us;
+        }
+        if (handle->config.gpio_int_pin == GPIO_NUM_NC) {
+            return wait_for_threshold(handle, deadline_us, data);
+        }
+    }
+    
+    if (handle->config.gpio_int_pin != GPIO_NUM_NC) {
+        return wait_for_interrupt(handle, deadline_us, data, true);
+    }
+    return wait_for_completion(handle, expected_us, deadline_us, false, data, true);
+}
+
+/**
+ * @brief Continuous measurement task
+ */
+static void continuous_task(void* arg) {
+    vl53l0x_handle_t handle = (vl53l0x_handle_t)arg;
+    VL53L0X_RangingMeasurementData_t measurement_data;
+    vl53l0x_measurement_t measurement;
+    
+    handle->waiting_task = xTaskGetCurrentTaskHandle();
+    
+    xSemaphoreTake(handle->mutex, portMAX_DELAY);
+    VL53L0X_Error status = start_hw_continuous(handle);
+    if (status != VL53L0X_ERROR_NONE) {
+        handle->is_continuous = false;
+    }
+    xSemaphoreGive(handle->mutex);
+    
+    if (status != VL53L0X_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to start continuous ranging: %d", status);
+    }
+    
+    while (handle->is_continuous) {
+        status = wait_data_ready(handle, &measurement_data);
+        handle->last_sample_us = esp_timer_get_time();
+        
+        xSemaphoreTake(handle->mutex, portMAX_DELAY);
+        update_health(handle, status == VL53L0X_ERROR_NONE);
+        bool publish = true;
+        if (status == VL53L0X_ERROR_NONE) {
+            fill_measurement(&measurement_data, handle->last_sample_us, &measurement);
+            if (handle->config.mode == VL53L0X_MODE_MULTI_SHOT) {
+                publish = add_shot(handle, &measurement, &measurement);
+            }
+            if (publish) {
+                vl53l0x_ring_publish(&handle->ring, &measurement);
+            }
+        } else {
+            // A lost sample or a bus fault can leave the sensor idle: restart ranging
+            ESP_LOGW(TAG, "Continuous sample failed: %d", status);
+            stop_hw_continuous(handle);
+            start_hw_continuous(handle);
+            memset(&measurement, 0, sizeof(measurement));
+            measurement.timestamp_us = handle->last_sample_us;
+            measurement.health = handle->health;
+        }
+        xSemaphoreGive(handle->mutex);
+        
+        // Isolated failures are retried silently; a degraded sensor is reported
+        if (handle->callback && publish && (status == VL53L0X_ERROR_NONE ||
+                                            measurement.health == VL53L0X_HEALTH_DEGRADED)) {
+            handle->callback(&measurement, handle->user_data);
+        }
+        
+        if (status != VL53L0X_ERROR_NONE && handle->health == VL53L0X_HEALTH_DEGRADED) {
+            // Do not hammer a failing bus: retry at the sample rate
+            TickType_t ticks = pdMS_TO_TICKS(handle->sample_period_ms);
+            vTaskDelay(ticks > 0 ? ticks : 1);
+        }
+    }
+    
+    xSemaphoreTake(handle->mutex, portMAX_DELAY);
+    stop_hw_continuous(handle);
+    handle->waiting_task = NULL;
+    xSemaphoreGive(handle->mutex);
+    
+    handle->task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Reference SPAD and VHV/phase calibration, reusing the NVS copy when enabled
+ *
+ * PerformRefSpadManagement and PerformRefCalibration account for most of the
+ * boot time. Their results only depend on the module, so a record keyed by the
+ * sensor unique ID can be written back instead of measured again.
+ */
+static VL53L0X_Error calibrate_reference(vl53l0x_handle_t handle) {
+    VL53L0X_DEV dev = &handle->device;
+    VL53L0X_Error status = VL53L0X_ERROR_NONE;
+    vl53l0x_ref_cal_t cal = {0};
+    bool use_cache = handle->config.cache_calibration;
+    
+    if (use_cache) {
+        status = VL53L0X_get_info_from_device(dev, 4);
+        if (status != VL53L0X_ERROR_NONE) {
+            return status;
+        }
+        cal.uid_upper = VL53L0X_GETDEVICESPECIFICPARAMETER(dev, PartUIDUpper);
+        cal.uid_lower = VL53L0X_GETDEVICESPECIFICPARAMETER(dev, PartUIDLower);
+        
+        if (handle->config.force_recalibration) {
+            // The record is distrusted: if recalibrating fails, nothing stale is left to load
+            vl53l0x_cal_erase(cal.uid_upper, cal.uid_lower);
+        } else if (vl53l0x_cal_load(cal.uid_upper, cal.uid_lower, &cal) == ESP_OK) {
+            status = VL53L0X_SetReferenceSpads(dev, cal.ref_spad_count, cal.is_aperture_spads);
+            if (status == VL53L0X_ERROR_NONE) {
+                status = VL53L0X_SetRefCalibration(dev, cal.vhv_settings, cal.phase_cal);
+            }
+            if (status == VL53L0X_ERROR_NONE) {
+                ESP_LOGI(TAG, "Using cached calibration (spads: %lu, vhv: %u, phase: %u)",
+                         (unsigned long)cal.ref_spad_count, cal.vhv_settings, cal.phase_cal);
+                return status;
+            }
+            ESP_LOGW(TAG, "Cached calibration rejected (%d), recalibrating", status);
+        }
+    }
+    
+    uint32_t refSpadCount;
+    uint8_t isApertureSpads, VhvSettings, PhaseCal;
+    
+    status = VL53L0X_PerformRefCalibration(dev, &VhvSettings, &PhaseCal);
+    if (status == VL53L0X_ERROR_NONE) {
+        status = VL53L0X_PerformRefSpadManagement(dev, &refSpadCount, &isApertureSpads);
+    }
+    
+    if (status == VL53L0X_ERROR_NONE && use_cache) {
+        cal.ref_spad_count = refSpadCount;
+        cal.is_aperture_spads = isApertureSpads;
+        cal.vhv_settings = VhvSettings;
+        cal.phase_cal = PhaseCal;
+        // A failed save only costs a full calibration on the next boot
+        vl53l0x_cal_save(&cal);
+    }
+    
+    return status;
+}
+
+/**
+ * @brief Add the sensor to its bus at the given address
+ */
+static esp_err_t add_i2c_device(vl53l0x_handle_t handle, uint8_t address) {
+    i2c_device_config_t dev_config = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = address,
+        .scl_speed_hz = handle->config.i2c_freq_hz,
+    };
+    
+    // Store I2C device handle in the ST device so the platform layer routes per sensor
+    esp_err_t ret = i2c_master_bus_add_device(handle->device.i2c_bus->handle, &dev_config,
+                                              &handle->device.i2c_dev_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add I2C device 0x%02X: %s", address, esp_err_to_name(ret));
+        handle->device.i2c_dev_handle = NULL;
+    }
+    handle->device.I2cDevAddr = address;
+    
+    return ret;
+}
+
+/**
+ * @brief Connect the ST device to its I2C bus at an address, or to the configured simulator
+ */
+static esp_err_t attach_transport(vl53l0x_handle_t handle, uint8_t address) {
+    const vl53l0x_config_t* config = &handle->config;
+    
+#ifdef VL53L0X_SIMULATOR
+    if (config->simulator) {
+        handle->device.sim = config->simulator;
+        handle->device.I2cDevAddr = address;
+        return vl53l0x_sim_attach(config->simulator, &handle->device);
+    }
+#endif
+    
+    // Get (or create) the bus for this sensor's pin pair
+    esp_err_t ret = vl53l0x_bus_acquire(config->scl_pin, config->sda_pin, &handle->device.i2c_bus);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    ret = add_i2c_device(handle, address);
+    if (ret != ESP_OK) {
+        vl53l0x_bus_release(handle->device.i2c_bus);
+        handle->device.i2c_bus = NULL;
+    }
+    
+    return ret;
+}
+
+/**
+ * @brief Undo attach_transport()
+ */
+static void release_transport(vl53l0x_handle_t handle) {
+#ifdef VL53L0X_SIMULATOR
+    if (handle->device.sim) {
+        vl53l0x_sim_detach(handle->device.sim);
+        handle->device.sim = NULL;
+    }
+#endif
+    
+    if (handle->device.i2c_dev_handle) {
+        i2c_master_bus_rm_device(handle->device.i2c_dev_handle);
+        vl53l0x_bus_release(handle->device.i2c_bus);
+        handle->device.i2c_dev_handle = NULL;
+    }
+}
+
+/**
+ * @brief Put a sensor in reset (XSHUT low)
+ */
+static esp_err_t hold_in_reset(gpio_num_t xshut_pin) {
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << xshut_pin,
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    esp_err_t ret = gpio_config(&io_conf);
+    if (ret == ESP_OK) {
+        ret = gpio_set_level(xshut_pin, 0);
+    }
+    return ret;
+}
+
+/**
+ * @brief Reset the sensor through XSHUT and wait for it to boot
+ * 
+ * Without an XSHUT pin the sensor is assumed powered and running.
+ */
+static esp_err_t power_up(const vl53l0x_config_t* config) {
+    if (config->xshut_pin == GPIO_NUM_NC) {
+        return ESP_OK;
+    }
+    
+    esp_err_t ret = hold_in_reset(config->xshut_pin);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to drive XSHUT GPIO%d: %s", config->xshut_pin, esp_err_to_name(ret));
+        return ret;
+    }
+    esp_rom_delay_us(XSHUT_RESET_US);
+    gpio_set_level(config->xshut_pin, 1);
+    esp_rom_delay_us(XSHUT_BOOT_US);
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief Whether a sensor already answers at an address
+ */
+static bool sensor_answers(const vl53l0x_config_t* config, uint8_t address) {
+    vl53l0x_i2c_bus_t* bus;
+    
+#ifdef VL53L0X_SIMULATOR
+    if (config->simulator) {
+        return false;
+    }
+#endif
+    if (vl53l0x_bus_acquire(config->scl_pin, config->sda_pin, &bus) != ESP_OK) {
+        return false;
+    }
+    bool present = (i2c_master_probe(bus->handle, address, ADDRESS_PROBE_TIMEOUT_MS) == ESP_OK);
+    vl53l0x_bus_release(bus);
+    
+    return present;
+}
+
+/**
+ * @brief Attach the transport and move the sensor to config.i2c_address
+ * 
+ * A sensor out of reset answers at VL53L0X_BOOT_ADDRESS. Without XSHUT it
+ * may still hold its address from before an MCU reset, so that is probed
+ * first. Only one sensor per bus may sit at the boot address meanwhile.
+ */
+static esp_err_t attach_and_address(vl53l0x_handle_t handle) {
+    const vl53l0x_config_t* config = &handle->config;
+    uint8_t address = config->i2c_address;
+    bool move = (address != VL53L0X_BOOT_ADDRESS);
+    
+    if (move && config->xshut_pin == GPIO_NUM_NC && sensor_answers(config, address)) {
+        move = false;
+    }
+    
+    esp_err_t ret = attach_transport(handle, move ? VL53L0X_BOOT_ADDRESS : address);
+    if (ret != ESP_OK || !move) {
+        return ret;
+    }
+    
+    // The ST API takes the 8-bit (write) address
+    if (VL53L0X_SetDeviceAddress(&handle->device, address << 1) != VL53L0X_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to move sensor from 0x%02X to 0x%02X", VL53L0X_BOOT_ADDRESS, address);
+        release_transport(handle);
+        return ESP_FAIL;
+    }
+    
+#ifdef VL53L0X_SIMULATOR
+    if (handle->device.sim) {
+        handle->device.I2cDevAddr = address;
+        return ESP_OK;
+    }
+#endif
+    i2c_master_bus_rm_device(handle->device.i2c_dev_handle);
+    ret = add_i2c_device(handle, address);
+    if (ret != ESP_OK) {
+        vl53l0x_bus_release(handle->device.i2c_bus);
+        handle->device.i2c_bus = NULL;
+    }
+    
+    return ret;
+}
+
+/**
+ * @brief Free a handle whose initialization did not complete
+ */
+static void destroy_handle(vl53l0x_handle_t handle) {
+    release_transport(handle);
+    vSemaphoreDelete(handle->mutex);
+    free_handle(handle);
+}
+
+/**
+ * @brief Allocate a handle, boot the sensor and give it its address
+ * 
+ * Touches the bus registry and the boot address, so calls must not overlap.
+ */
+static esp_err_t create_handle(const vl53l0x_config_t* config, vl53l0x_handle_t* handle) {
+    // Allocate handle, sample history behind it
+    uint32_t depth = vl53l0x_ring_depth(config->history_depth);
+    *handle = (vl53l0x_handle_t)calloc(1, sizeof(struct vl53l0x_handle_s) +
+                                          depth * sizeof(vl53l0x_ring_slot_t));
+    if (!*handle) {
+        return ESP_ERR_NO_MEM;
+    }
+    vl53l0x_ring_init(&(*handle)->ring, (vl53l0x_ring_slot_t*)(*handle + 1), depth);
+    
+    // Copy configuration
+    memcpy(&(*handle)->config, config, sizeof(vl53l0x_config_t));
+    (*handle)->config.history_depth = (uint8_t)depth;
+    
+    uint8_t* shots = &(*handle)->config.multi_shot_count;
+    if (*shots == 0) {
+        *shots = MULTI_SHOT_DEFAULT_COUNT;
+    } else if (*shots < 2) {
+        *shots = 2;
+    } else if (*shots > VL53L0X_MULTI_SHOT_MAX) {
+        *shots = VL53L0X_MULTI_SHOT_MAX;
+    }
+    if ((*handle)->config.threshold_heartbeat_ms == 0) {
+        (*handle)->config.threshold_heartbeat_ms = THRESHOLD_DEFAULT_HEARTBEAT_MS;
+    }
+    
+    if (!config->fixed_mode) {
+        (*handle)->modes = (mode_table_t*)calloc(1, sizeof(mode_table_t));
+    }
+    
+    // Create mutex
+    (*handle)->mutex = xSemaphoreCreateMutex();
+    if (!(*handle)->mutex || (!config->fixed_mode && !(*handle)->modes) ||
+        (config->mode == VL53L0X_MODE_MULTI_SHOT && alloc_shots(*handle) != ESP_OK)) {
+        if ((*handle)->mutex) {
+            vSemaphoreDelete((*handle)->mutex);
+        }
+        free_handle(*handle);
+        *handle = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    
+    esp_err_t ret = power_up(config);
+    if (ret == ESP_OK) {
+        ret = attach_and_address(*handle);
+    }
+    if (ret != ESP_OK) {
+        vSemaphoreDelete((*handle)->mutex);
+        free_handle(*handle);
+        *handle = NULL;
+        return ret;
+    }
+    
+    // Configure device structure
+    (*handle)->device.comms_type = 1;
+    (*handle)->device.comms_speed_khz = config->i2c_freq_hz / 1000;
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief Data init, tuning, reference calibration and mode capture
+ * 
+ * Only talks to its own sensor, so several can run at once.
+ */
+static VL53L0X_Error bring_up(vl53l0x_handle_t handle) {
+    VL53L0X_DEV dev = &handle->device;
+    
+    // Initialize sensor
+    VL53L0X_Error status = VL53L0X_DataInit(dev);
+    if (status != VL53L0X_ERROR_NONE) {
+        ESP_LOGE(TAG, "DataInit failed: %d", status);
+        return status;
+    }
+    
+    // Queue the tuning table so consecutive registers go out as one burst
+    vl53l0x_batch_begin(dev);
+    status = VL53L0X_StaticInit(dev);
+    VL53L0X_Error flush_status = vl53l0x_batch_end(dev);
+    if (status == VL53L0X_ERROR_NONE) {
+        status = flush_status;
+    }
+    
+    // Calibration
+    if (status == VL53L0X_ERROR_NONE) {
+        status = calibrate_reference(handle);
+    }
+    if (status == VL53L0X_ERROR_NONE) {
+        status = VL53L0X_SetDeviceMode(dev, VL53L0X_DEVICEMODE_SINGLE_RANGING);
+    }
+    
+    // Capture every mode once, then switch to the configured one
+    if (handle->modes) {
+        if (status == VL53L0X_ERROR_NONE) {
+            status = capture_presets(handle);
+        }
+        if (status == VL53L0X_ERROR_NONE) {
+            status = apply_preset(handle, handle->config.mode, NULL);
+        }
+    } else if (status == VL53L0X_ERROR_NONE) {
+        status = configure_mode(handle, handle->config.mode);
+        if (status == VL53L0X_ERROR_NONE) {
+            handle->active_preset = preset_of(handle->config.mode);
+        }
+    }
+    
+    return status;
+}
+
+/**
+ * @brief Hook the optional GPIO1 interrupt and mark the handle ready, or free it
+ * 
+ * @param status Result of bring_up()
+ */
+static esp_err_t finish_init(vl53l0x_handle_t handle, VL53L0X_Error status) {
+    // Optional data ready interrupt on GPIO1
+    if (status == VL53L0X_ERROR_NONE && handle->config.gpio_int_pin != GPIO_NUM_NC) {
+        if (configure_data_ready_interrupt(handle) != ESP_OK) {
+            status = VL53L0X_ERROR_GPIO_NOT_EXISTING;
+        }
+    }
+    
+    if (status != VL53L0X_ERROR_NONE) {
+        ESP_LOGE(TAG, "Initialization failed: %d", status);
+        destroy_handle(handle);
+        return ESP_FAIL;
+    }
+    
+    handle->is_initialized = true;
+    ESP_LOGI(TAG, "VL53L0X 0x%02X initialized successfully (mode: %s)",
+             handle->config.i2c_address, vl53l0x_get_mode_name(handle->config.mode));
+    
+    return ESP_OK;
+}
+
+esp_err_t vl53l0x_init(const vl53l0x_config_t* config, vl53l0x_handle_t* handle) {
+    if (!config || !handle || config->mode >= MODE_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    esp_err_t ret = create_handle(config, handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    ret = finish_init(*handle, bring_up(*handle));
+    if (ret != ESP_OK) {
+        *handle = NULL;
+    }
+    return ret;
+}
+
+/**
+ * @brief Work item of one bring_up() worker
+ */
+typedef struct {
+    vl53l0x_handle_t handle;
+    TaskHandle_t owner;          // Notified when done
+    VL53L0X_Error status;
+} init_job_t;
+
+static void init_worker(void* arg) {
+    init_job_t* job = (init_job_t*)arg;
+    
+    job->status = bring_up(job->handle);
+    xTaskNotifyGive(job->owner);
+    vTaskDelete(NULL);
+}
+
+esp_err_t vl53l0x_init_multi(const vl53l0x_config_t* configs, size_t count, vl53l0x_handle_t* handles) {
+    if (!configs || !handles || count == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (configs[i].mode >= MODE_COUNT) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    
+    init_job_t* jobs = (init_job_t*)calloc(count, sizeof(init_job_t));
+    if (!jobs) {
+        return ESP_ERR_NO_MEM;
+    }
+    memset(handles, 0, count * sizeof(vl53l0x_handle_t));
+    
+    // Keep every sensor with XSHUT in reset, so only the one being addressed answers at 0x29
+    esp_err_t ret = ESP_OK;
+    for (size_t i = 0; i < count && ret == ESP_OK; i++) {
+        if (configs[i].xshut_pin != GPIO_NUM_NC) {
+            ret = hold_in_reset(configs[i].xshut_pin);
+        }
+    }
+    
+    // Boot and address one sensor at a time
+    for (size_t i = 0; i < count && ret == ESP_OK; i++) {
+        ret = create_handle(&configs[i], &handles[i]);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Sensor %u (0x%02X) did not come up: %s", (unsigned)i,
+                     configs[i].i2c_address, esp_err_to_name(ret));
+        }
+    }
+    
+    // Calibrate all of them at once
+    size_t started = 0;
+    if (ret == ESP_OK) {
+        TaskHandle_t owner = xTaskGetCurrentTaskHandle();
+        for (size_t i = 0; i < count; i++) {
+            jobs[i].handle = handles[i];
+            jobs[i].owner = owner;
+            if (xTaskCreate(init_worker, "vl53l0x_init", INIT_TASK_STACK, &jobs[i], INIT_TASK_PRIORITY, NULL) == pdPASS) {
+                started++;
+            } else {
+                jobs[i].status = bring_up(handles[i]);
+            }
+        }
+        for (size_t i = 0; i < started; i++) {
+            ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+        }
+    }
+    
+    // Interrupt hookup uses the shared GPIO ISR service: one at a time again
+    for (size_t i = 0; i < count && ret == ESP_OK; i++) {
+        ret = finish_init(handles[i], jobs[i].status);
+        if (ret != ESP_OK) {
+            handles[i] = NULL;
+        }
+    }
+    
+    if (ret != ESP_OK) {
+        for (size_t i = 0; i < count; i++) {
+            if (!handles[i]) {
+                continue;
+            }
+            if (handles[i]->is_initialized) {
+                vl53l0x_deinit(handles[i]);
+            } else {
+                destroy_handle(handles[i]);
+            }
+            handles[i] = NULL;
+        }
+    }
+    
+    free(jobs);
+    return ret;
+}
+
+esp_err_t vl53l0x_read_single(vl53l0x_handle_t handle, vl53l0x_measurement_t* measurement) {
+    if (!handle || !handle->is_initialized || !measurement) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(handle->mutex, portMAX_DELAY);
+    
+    // The sensor is busy ranging on its own: hand out the latest sample
+    if (handle->is_continuous) {
+        bool has_measurement = vl53l0x_ring_head(&handle->ring) != handle->continuous_seq &&
+                               vl53l0x_ring_latest(&handle->ring, measurement);
+        xSemaphoreGive(handle->mutex);
+        return has_measurement ? ESP_OK : ESP_ERR_INVALID_STATE;
+    }
+    
+    if (handle->async_pending) {
+        xSemaphoreGive(handle->mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    VL53L0X_RangingMeasurementData_t data;
+    int64_t complete_us;
+    VL53L0X_Error status;
+    bool multi_shot = (handle->config.mode == VL53L0X_MODE_MULTI_SHOT);
+    
+    handle->shot_count = 0;
+    do {
+        status = perform_single_ranging(handle, &data, &complete_us);
+        update_health(handle, status == VL53L0X_ERROR_NONE);
+        if (status != VL53L0X_ERROR_NONE) {
+            break;
+        }
+        fill_measurement(&data, complete_us, measurement);
+    } while (multi_shot && !add_shot(handle, measurement, measurement));
+    
+    if (status == VL53L0X_ERROR_NONE) {
+        vl53l0x_ring_publish(&handle->ring, measurement);
+    }
+    
+    xSemaphoreGive(handle->mutex);
+    
+    return (status == VL53L0X_ERROR_NONE) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t vl53l0x_trigger_single(vl53l0x_handle_t handle) {
+    if (!handle || !handle->is_initialized) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(handle->mutex, portMAX_DELAY);
+    
+    if (handle->is_continuous || handle->async_pending) {
+        xSemaphoreGive(handle->mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!handle->async) {
+        handle->async = (async_shot_t*)calloc(1, sizeof(async_shot_t));
+        if (!handle->async) {
+            xSemaphoreGive(handle->mutex);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
+    VL53L0X_DEV dev = &handle->device;
+    handle->irq_fired = false;
+    
+    VL53L0X_Error status = VL53L0X_SetDeviceMode(dev, VL53L0X_DEVICEMODE_SINGLE_RANGING);
+    if (status == VL53L0X_ERROR_NONE) {
+        vl53l0x_batch_begin(dev);
+        status = VL53L0X_StartMeasurement(dev);
+        VL53L0X_Error flush_status = vl53l0x_batch_end(dev);
+        if (status == VL53L0X_ERROR_NONE) {
+            status = flush_status;
+        }
+    }
+    if (status == VL53L0X_ERROR_NONE) {
+        handle->async->start_us = esp_timer_get_time();
+        handle->async->done_us = 0;
+        handle->async_pending = true;
+    } else {
+        update_health(handle, false);
+    }
+    
+    xSemaphoreGive(handle->mutex);
+    
+    return (status == VL53L0X_ERROR_NONE) ? ESP_OK : ESP_FAIL;
+}
+
+/**
+ * @brief Check the pending async sample without blocking
+ * 
+ * With GPIO1 wired this never touches the bus. Must be called with the
+ * handle mutex held.
+ */
+static VL53L0X_Error async_check_ready(vl53l0x_handle_t handle, bool* ready) {
+    VL53L0X_Error status = VL53L0X_ERROR_NONE;
+    
+    if (handle->async->done_us) {
+        *ready = true;
+    } else if (handle->config.gpio_int_pin != GPIO_NUM_NC) {
+        *ready = handle->irq_fired;
+    } else {
+        uint8_t data_ready = 0;
+        status = read_data_ready(handle, &data_ready, NULL, false);
+        *ready = (data_ready != 0);
+    }
+    
+    if (*ready && !handle->async->done_us) {
+        handle->async->done_us = esp_timer_get_time();
+    }
+    return status;
+}
+
+esp_err_t vl53l0x_poll_single(vl53l0x_handle_t handle, bool* done) {
+    if (!handle || !done) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(handle->mutex, portMAX_DELAY);
+    
+    if (!handle->async_pending) {
+        xSemaphoreGive(handle->mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    VL53L0X_Error status = async_check_ready(handle, done);
+    
+    xSemaphoreGive(handle->mutex);
+    
+    return (status == VL53L0X_ERROR_NONE) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t vl53l0x_wait_single(vl53l0x_handle_t handle, uint32_t timeout_ms) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(handle->mutex, portMAX_DELAY);
+    
+    if (!handle->async_pending) {
+        xSemaphoreGive(handle->mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    VL53L0X_DEV dev = &handle->device;
+    uint32_t budget_us;
+    VL53L0X_GETPARAMETERFIELD(dev, MeasurementTimingBudgetMicroSeconds, budget_us);
+    int64_t start_us = handle->async->start_us;
+    bool done = handle->async->done_us != 0;
+    
+    xSemaphoreGive(handle->mutex);
+    
+    if (done) {
+        return ESP_OK;
+    }
+    
+    // Never wait past the point where the sensor is considered stuck
+    int64_t expected_us = start_us + budget_us;
+    int64_t sensor_deadline_us = start_us + 2 * (int64_t)budget_us + WAIT_MARGIN_US;
+    int64_t deadline_us = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    if (deadline_us > sensor_deadline_us) {
+        deadline_us = sensor_deadline_us;
+    }
+    
+    VL53L0X_Error status = VL53L0X_ERROR_NONE;
+    bool ready = false;
+    
+    if (handle->config.gpio_int_pin != GPIO_NUM_NC) {
+        const int64_t tick_us = (int64_t)portTICK_PERIOD_MS * 1000;
+        
+        handle->waiting_task = xTaskGetCurrentTaskHandle();
+        ulTaskNotifyTake(pdTRUE, 0);
+        if (!handle->irq_fired) {
+            int64_t remaining_us = deadline_us - esp_timer_get_time();
+            if (remaining_us > 0) {
+                ulTaskNotifyTake(pdTRUE, (TickType_t)(remaining_us / tick_us) + 1);
             }
         }
+        handle->waiting_task = NULL;
         
-        vTaskDelay(pdMS_TO_TICKS(50)); // Adjust based on mode
+        ready = handle->irq_fired;
+        if (!ready && deadline_us == sensor_deadline_us) {
+            // Edge may have been missed: check the status register once
+            uint8_t data_ready = 0;
+            xSemaphoreTake(handle->mutex, portMAX_DELAY);
+            status = read_data_ready(handle, &data_ready, NULL, false);
+            ready = (data_ready != 0);
+            handle->irq_fired = ready;
+            xSemaphoreGive(handle->mutex);
+        }
+    } else {
+        status = wait_for_completion(handle, expected_us < deadline_us ? expected_us : deadline_us,
+                                     deadline_us, deadline_us != sensor_deadline_us, NULL, true);
+        ready = (status == VL53L0X_ERROR_NONE);
+        if (status == VL53L0X_ERROR_TIME_OUT) {
+            status = VL53L0X_ERROR_NONE;
+        }
     }
     
-    vTaskDelete(NULL);
-}
-
-esp_err_t vl53l0x_init(const vl53l0x_config_t* config, vl53l0x_handle_t* handle) {
-    if (!config || !handle) {
-        return ESP_ERR_INVALID_ARG;
-    }
+    xSemaphoreTake(handle->mutex, portMAX_DELAY);
     
-    // Allocate handle
-    *handle = (vl53l0x_handle_t)calloc(1, sizeof(struct vl53l0x_handle_s));
-    if (!*handle) {
-        return ESP_ERR_NO_MEM;
+    // Fetched or dropped by another caller while this one slept
+    if (!handle->async_pending || handle->async->start_us != start_us) {
+        xSemaphoreGive(handle->mutex);
+        return ESP_ERR_INVALID_STATE;
     }
     
-    // Copy configuration
-    memcpy(&(*handle)->config, config, sizeof(vl53l0x_config_t));
-    
-    // Create mutex
-    (*handle)->mutex = xSemaphoreCreateMutex();
-    if (!(*handle)->mutex) {
-        free(*handle);
-        return ESP_ERR_NO_MEM;
+    if (status == VL53L0X_ERROR_NONE && ready) {
+        if (!handle->async->done_us) {
+            handle->async->done_us = esp_timer_get_time();
+        }
+        xSemaphoreGive(handle->mutex);
+        return ESP_OK;
     }
     
-    // Initialize I2C bus if not already done
-    if (!i2c_bus_initialized) {
-        i2c_master_bus_config_t bus_config = {
-            .i2c_port = I2C_NUM_0,
-            .sda_io_num = config->sda_pin,
-            .scl_io_num = config->scl_pin,
-            .clk_source = I2C_CLK_SRC_DEFAULT,
-            .glitch_ignore_cnt = 7,
-            .flags.enable_internal_pullup = true,
-        };
-        
-        esp_err_t ret = i2c_new_master_bus(&bus_config, &i2c_bus_handle);
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to initialize I2C bus: %s", esp_err_to_name(ret));
-            vSemaphoreDelete((*handle)->mutex);
-            free(*handle);
-            return ret;
-        }
-        i2c_bus_initialized = true;
-        ESP_LOGI(TAG, "I2C bus initialized (SDA: GPIO%d, SCL: GPIO%d)", config->sda_pin, config->scl_pin);
+    if (deadline_us == sensor_deadline_us) {
+        // The sample is lost; allow a new trigger
+        ESP_LOGW(TAG, "Async measurement timed out");
+        update_health(handle, false);
+        handle->async_pending = false;
     }
     
-    // Add device to I2C bus
-    i2c_device_config_t dev_config = {
-        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
-        .device_address = config->i2c_address,
-        .scl_speed_hz = config->i2c_freq_hz,
-    };
+    xSemaphoreGive(handle->mutex);
     
-    // Store I2C device handle in driver structure (not in ST structure)
-    esp_err_t ret = i2c_master_bus_add_device(i2c_bus_handle, &dev_config, &(*handle)->i2c_dev_handle);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to add I2C device: %s", esp_err_to_name(ret));
-        vSemaphoreDelete((*handle)->mutex);
-        free(*handle);
-        return ret;
+    return (status == VL53L0X_ERROR_NONE) ? ESP_ERR_TIMEOUT : ESP_FAIL;
+}
+
+esp_err_t vl53l0x_fetch_single(vl53l0x_handle_t handle, vl53l0x_measurement_t* measurement) {
+    if (!handle || !measurement) {
+        return ESP_ERR_INVALID_ARG;
     }
     
-    // Configure device structure
-    (*handle)->device.I2cDevAddr = config->i2c_address;
-    (*handle)->device.comms_type = 1;
-    (*handle)->device.comms_speed_khz = config->i2c_freq_hz / 1000;
+    xSemaphoreTake(handle->mutex, portMAX_DELAY);
     
-    // Set global handle for platform layer
-    g_current_vl53l0x_dev_handle = (*handle)->i2c_dev_handle;
+    if (!handle->async_pending) {
+        xSemaphoreGive(handle->mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
     
-    // Initialize sensor
-    VL53L0X_Error status = VL53L0X_DataInit(&(*handle)->device);
-    if (status != VL53L0X_ERROR_NONE) {
-        ESP_LOGE(TAG, "DataInit failed: %d", status);
-        vSemaphoreDelete((*handle)->mutex);
-        free(*handle);
+    bool ready = false;
+    if (async_check_ready(handle, &ready) != VL53L0X_ERROR_NONE) {
+        xSemaphoreGive(handle->mutex);
         return ESP_FAIL;
     }
+    if (!ready) {
+        xSemaphoreGive(handle->mutex);
+        return ESP_ERR_NOT_FINISHED;
+    }
     
-    // Calibration
-    uint32_t refSpadCount;
-    uint8_t isApertureSpads, VhvSettings, PhaseCal;
+    VL53L0X_DEV dev = &handle->device;
+    VL53L0X_RangingMeasurementData_t data;
     
-    status = VL53L0X_StaticInit(&(*handle)->device);
-    if (status == VL53L0X_ERROR_NONE) {
-        status = VL53L0X_PerformRefCalibration(&(*handle)->device, &VhvSettings, &PhaseCal);
-    }
+    PALDevDataSet(dev, PalState, VL53L0X_STATE_IDLE);
+    VL53L0X_Error status = VL53L0X_GetRangingMeasurementData(dev, &data);
     if (status == VL53L0X_ERROR_NONE) {
-        status = VL53L0X_PerformRefSpadManagement(&(*handle)->device, &refSpadCount, &isApertureSpads);
+        status = VL53L0X_ClearInterruptMask(dev, 0);
     }
+    update_health(handle, status == VL53L0X_ERROR_NONE);
     if (status == VL53L0X_ERROR_NONE) {
-        status = VL53L0X_SetDeviceMode(&(*handle)->device, VL53L0X_DEVICEMODE_SINGLE_RANGING);
+        fill_measurement(&data, handle->async->done_us, measurement);
+        vl53l0x_ring_publish(&handle->ring, measurement);
     }
+    handle->async_pending = false;
+    handle->irq_fired = false;
+    xSemaphoreGive(handle->mutex);
     
-    // Configure mode
-    if (status == VL53L0X_ERROR_NONE) {
-        configure_mode(*handle, config->mode);
+    return (status == VL53L0X_ERROR_NONE) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t vl53l0x_start_continuous(vl53l0x_handle_t handle, vl53l0x_measurement_cb_t callback, void* user_data) {
+    if (!handle || !handle->is_initialized || !callback) {
+        return ESP_ERR_INVALID_ARG;
     }
     
-    if (status != VL53L0X_ERROR_NONE) {
-        ESP_LOGE(TAG, "Initialization failed: %d", status);
-        vSemaphoreDelete((*handle)->mutex);
-        free(*handle);
-        return ESP_FAIL;
+    // Checked and claimed under the mutex, so a concurrent single shot sees one or the other.
+    // A task still winding down from the last stop also counts as running.
+    xSemaphoreTake(handle->mutex, portMAX_DELAY);
+    if (handle->is_continuous || handle->async_pending || handle->task_handle) {
+        xSemaphoreGive(handle->mutex);
+        return ESP_ERR_INVALID_STATE;
     }
     
-    (*handle)->is_initialized = true;
-    ESP_LOGI(TAG, "VL53L0X initialized successfully (mode: %s)", vl53l0x_get_mode_name(config->mode));
+    handle->callback = callback;
+    handle->user_data = user_data;
+    handle->continuous_seq = vl53l0x_ring_head(&handle->ring);
+    handle->is_continuous = true;
     
-    return ESP_OK;
+    // The task blocks on the mutex before touching the sensor, so creating it here is safe
+    BaseType_t ret = xTaskCreate(continuous_task, "vl53l0x_cont", CONTINUOUS_TASK_STACK, handle,
+                                 CONTINUOUS_TASK_PRIORITY, &handle->task_handle);
+    if (ret != pdPASS) {
+        handle->is_continuous = false;
+        handle->task_handle = NULL;
+    }
+    xSemaphoreGive(handle->mutex);
+    
+    return (ret == pdPASS) ? ESP_OK : ESP_FAIL;
 }
 
-esp_err_t vl53l0x_read_single(vl53l0x_handle_t handle, vl53l0x_measurement_t* measurement) {
-    if (!handle || !handle->is_initialized || !measurement) {
+esp_err_t vl53l0x_stop_continuous(vl53l0x_handle_t handle) {
+    if (!handle) {
         return ESP_ERR_INVALID_ARG;
     }
     
     xSemaphoreTake(handle->mutex, portMAX_DELAY);
+    if (handle->polled) {
+        xSemaphoreGive(handle->mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    handle->is_continuous = false;
+    xSemaphoreGive(handle->mutex);
     
-    VL53L0X_RangingMeasurementData_t data;
-    VL53L0X_Error status = VL53L0X_PerformSingleRangingMeasurement(&handle->device, &data);
+    // Wait for the task to stop the sensor and exit (at most one sample, or one heartbeat, plus margin)
+    uint32_t wait_ms = 2 * handle->sample_period_ms;
+    if (handle->threshold_armed && handle->config.threshold_heartbeat_ms > wait_ms) {
+        wait_ms = handle->config.threshold_heartbeat_ms;
+    }
+    TickType_t timeout = pdMS_TO_TICKS(wait_ms + 100);
+    TickType_t start = xTaskGetTickCount();
+    while (handle->task_handle && (xTaskGetTickCount() - start) < timeout) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
     
-    if (status == VL53L0X_ERROR_NONE) {
-        measurement->distance_mm = data.RangeMilliMeter;
-        measurement->range_status = data.RangeStatus;
-        measurement->signal_rate_mcps = data.SignalRateRtnMegaCps / 65536.0f;
-        measurement->ambient_rate_mcps = data.AmbientRateRtnMegaCps / 65536.0f;
-        measurement->is_valid = (data.RangeStatus == 0);
+    return handle->task_handle ? ESP_ERR_TIMEOUT : ESP_OK;
+}
+
+esp_err_t vl53l0x_start_ranging(vl53l0x_handle_t handle) {
+    if (!handle || !handle->is_initialized) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(handle->mutex, portMAX_DELAY);
+    if (handle->is_continuous || handle->async_pending || handle->task_handle) {
+        xSemaphoreGive(handle->mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (handle->threshold_armed) {
+        xSemaphoreGive(handle->mutex);
+        return ESP_ERR_NOT_SUPPORTED;
     }
     
+    handle->continuous_seq = vl53l0x_ring_head(&handle->ring);
+    VL53L0X_Error status = start_hw_continuous(handle);
+    if (status == VL53L0X_ERROR_NONE) {
+        handle->is_continuous = true;
+        handle->polled = true;
+    } else {
+        ESP_LOGE(TAG, "Failed to start ranging: %d", status);
+    }
     xSemaphoreGive(handle->mutex);
     
     return (status == VL53L0X_ERROR_NONE) ? ESP_OK : ESP_FAIL;
 }
 
-esp_err_t vl53l0x_start_continuous(vl53l0x_handle_t handle, vl53l0x_measurement_cb_t callback, void* user_data) {
-    if (!handle || !handle->is_initialized || !callback) {
+esp_err_t vl53l0x_poll_ranging(vl53l0x_handle_t handle, vl53l0x_measurement_t* measurement, bool* ready) {
+    if (!handle || !measurement || !ready) {
         return ESP_ERR_INVALID_ARG;
     }
+    *ready = false;
     
-    if (handle->is_continuous) {
+    xSemaphoreTake(handle->mutex, portMAX_DELAY);
+    if (!handle->polled) {
+        xSemaphoreGive(handle->mutex);
         return ESP_ERR_INVALID_STATE;
     }
     
-    handle->callback = callback;
-    handle->user_data = user_data;
-    handle->is_continuous = true;
+    VL53L0X_RangingMeasurementData_t data;
+    uint8_t data_ready = 0;
+    VL53L0X_Error status = read_data_ready(handle, &data_ready, &data, false);
+    int64_t now_us = esp_timer_get_time();
     
-    BaseType_t ret = xTaskCreate(continuous_task, "vl53l0x_cont", 4096, handle, 5, &handle->task_handle);
+    if (status == VL53L0X_ERROR_NONE && !data_ready) {
+        // Same deadline as the continuous task: one period late plus margin
+        int64_t period_us = (int64_t)handle->sample_period_ms * 1000;
+        if (now_us < handle->last_sample_us + 2 * period_us + WAIT_MARGIN_US) {
+            record_wait(handle, 1, status, false, false);
+            xSemaphoreGive(handle->mutex);
+            return ESP_OK;
+        }
+        status = VL53L0X_ERROR_TIME_OUT;
+    }
+    record_wait(handle, 1, status, true, false);
+    update_health(handle, status == VL53L0X_ERROR_NONE);
     
-    return (ret == pdPASS) ? ESP_OK : ESP_FAIL;
+    if (status == VL53L0X_ERROR_NONE) {
+        handle->last_sample_us = now_us;
+        fill_measurement(&data, now_us, measurement);
+        *ready = (handle->config.mode != VL53L0X_MODE_MULTI_SHOT) || add_shot(handle, measurement, measurement);
+        if (*ready) {
+            vl53l0x_ring_publish(&handle->ring, measurement);
+        }
+    } else {
+        // As in the continuous task: the sensor may have gone idle
+        ESP_LOGW(TAG, "Polled sample failed: %d", status);
+        stop_hw_continuous(handle);
+        start_hw_continuous(handle);
+    }
+    xSemaphoreGive(handle->mutex);
+    
+    if (status == VL53L0X_ERROR_NONE) {
+        return ESP_OK;
+    }
+    return (status == VL53L0X_ERROR_TIME_OUT) ? ESP_ERR_TIMEOUT : ESP_FAIL;
 }
 
-esp_err_t vl53l0x_stop_continuous(vl53l0x_handle_t handle) {
+esp_err_t vl53l0x_stop_ranging(vl53l0x_handle_t handle) {
     if (!handle) {
         return ESP_ERR_INVALID_ARG;
     }
     
+    xSemaphoreTake(handle->mutex, portMAX_DELAY);
+    if (!handle->polled) {
+        xSemaphoreGive(handle->mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    VL53L0X_Error status = stop_hw_continuous(handle);
     handle->is_continuous = false;
-    vTaskDelay(pdMS_TO_TICKS(100)); // Wait for task to finish
+    handle->polled = false;
+    xSemaphoreGive(handle->mutex);
     
-    return ESP_OK;
+    return (status == VL53L0X_ERROR_NONE) ? ESP_OK : ESP_FAIL;
 }
 
-esp_err_t vl53l0x_set_mode(vl53l0x_handle_t handle, vl53l0x_mode_t mode) {
+/**
+ * @brief Arm or disarm the threshold window, restarting ranging if GPIO1 changes role
+ * 
+ * Must be called with the handle mutex held.
+ */
+static esp_err_t rearm_thresholds(vl53l0x_handle_t handle, bool armed) {
+    bool restart = handle->is_continuous && handle->threshold_armed != armed;
+    VL53L0X_Error status = VL53L0X_ERROR_NONE;
+    
+    if (restart) {
+        status = stop_hw_continuous(handle);
+    }
+    handle->threshold_armed = armed;
+    if (restart && status == VL53L0X_ERROR_NONE) {
+        status = start_hw_continuous(handle);
+    }
+    return (status == VL53L0X_ERROR_NONE) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t vl53l0x_set_threshold_window(vl53l0x_handle_t handle, uint16_t low_mm, uint16_t high_mm) {
+    if (!handle || !handle->is_initialized || high_mm > VL53L0X_THRESHOLD_MAX_MM) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(handle->mutex, portMAX_DELAY);
+    
+    // Polled ranging reads every sample: nothing would wait for the crossings
+    if (handle->config.mode == VL53L0X_MODE_MULTI_SHOT || handle->polled) {
+        xSemaphoreGive(handle->mutex);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    
+    // The registers hold mm / 2: round low up and high down so nothing outside slips through
+    uint32_t low = (low_mm >= VL53L0X_THRESHOLD_MAX_MM) ? VL53L0X_THRESHOLD_MAX_MM : ((uint32_t)low_mm + 1) & ~1u;
+    vl53l0x_batch_begin(&handle->device);
+    VL53L0X_Error status = VL53L0X_SetInterruptThresholds(&handle->device, VL53L0X_DEVICEMODE_CONTINUOUS_RANGING,
+                                                          low << 16, (FixPoint1616_t)high_mm << 16);
+    VL53L0X_Error flush_status = vl53l0x_batch_end(&handle->device);
+    if (status == VL53L0X_ERROR_NONE) {
+        status = flush_status;
+    }
+    
+    esp_err_t ret = (status == VL53L0X_ERROR_NONE) ? rearm_thresholds(handle, true) : ESP_FAIL;
+    
+    xSemaphoreGive(handle->mutex);
+    
+    return ret;
+}
+
+esp_err_t vl53l0x_clear_threshold_window(vl53l0x_handle_t handle) {
     if (!handle || !handle->is_initialized) {
         return ESP_ERR_INVALID_ARG;
     }
     
     xSemaphoreTake(handle->mutex, portMAX_DELAY);
-    esp_err_t ret = configure_mode(handle, mode);
+    esp_err_t ret = rearm_thresholds(handle, false);
+    xSemaphoreGive(handle->mutex);
+    
+    return ret;
+}
+
+esp_err_t vl53l0x_set_mode(vl53l0x_handle_t handle, vl53l0x_mode_t mode) {
+    if (!handle || !handle->is_initialized || mode >= MODE_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(handle->mutex, portMAX_DELAY);
+    
+    if (handle->async_pending) {
+        xSemaphoreGive(handle->mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (handle->threshold_armed && mode == VL53L0X_MODE_MULTI_SHOT) {
+        xSemaphoreGive(handle->mutex);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (mode == VL53L0X_MODE_MULTI_SHOT && alloc_shots(handle) != ESP_OK) {
+        xSemaphoreGive(handle->mutex);
+        return ESP_ERR_NO_MEM;
+    }
+    if (handle->active_preset == preset_of(mode)) {
+        // Same timing (HIGH_SPEED and MULTI_SHOT): only the grouping of samples changes
+        handle->config.mode = mode;
+        handle->shot_count = 0;
+        xSemaphoreGive(handle->mutex);
+        return ESP_OK;
+    }
+    if (!handle->modes) {
+        xSemaphoreGive(handle->mutex);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    
+    int64_t start_us = esp_timer_get_time();
+    
+    // Timing registers can only change while the sensor is idle
+    if (handle->is_continuous) {
+        stop_hw_continuous(handle);
+    }
+    
+    uint32_t registers = 0;
+    esp_err_t ret = (apply_preset(handle, mode, &registers) == VL53L0X_ERROR_NONE) ? ESP_OK : ESP_FAIL;
     handle->config.mode = mode;
+    
+    if (handle->is_continuous && start_hw_continuous(handle) != VL53L0X_ERROR_NONE) {
+        ret = ESP_FAIL;
+    }
+    
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start_us);
+    vl53l0x_mode_stats_t* stats = &handle->modes->stats;
+    stats->switches++;
+    stats->last_registers = registers;
+    stats->last_us = elapsed_us;
+    stats->total_us += elapsed_us;
+    if (elapsed_us > stats->max_us) {
+        stats->max_us = elapsed_us;
+    }
+    
     xSemaphoreGive(handle->mutex);
     
     return ret;
 }
 
+esp_err_t vl53l0x_get_timing_budget(vl53l0x_handle_t handle, uint32_t* budget_us) {
+    if (!handle || !handle->is_initialized || !budget_us) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    VL53L0X_DEV dev = &handle->device;
+    xSemaphoreTake(handle->mutex, portMAX_DELAY);
+    VL53L0X_GETPARAMETERFIELD(dev, MeasurementTimingBudgetMicroSeconds, *budget_us);
+    xSemaphoreGive(handle->mutex);
+    
+    return ESP_OK;
+}
+
 esp_err_t vl53l0x_get_distance(vl53l0x_handle_t handle, uint16_t* distance_mm) {
     vl53l0x_measurement_t measurement;
     esp_err_t ret = vl53l0x_read_single(handle, &measurement);
@@ -332,15 +2190,140 @@ esp_err_t vl53l0x_deinit(vl53l0x_handle_t handle) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    if (handle->is_continuous) {
-        vl53l0x_stop_continuous(handle);
+    if (handle->polled) {
+        vl53l0x_stop_ranging(handle);
+    }
+    
+    // The task still uses the handle until it exits, even after an earlier stop timed out
+    if (handle->is_continuous || handle->task_handle) {
+        esp_err_t ret = vl53l0x_stop_continuous(handle);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Continuous task did not stop, handle kept: %s", esp_err_to_name(ret));
+            return ret;
+        }
+    }
+    
+    if (handle->config.gpio_int_pin != GPIO_NUM_NC) {
+        gpio_isr_handler_remove(handle->config.gpio_int_pin);
     }
     
+    release_transport(handle);
+    
     if (handle->mutex) {
         vSemaphoreDelete(handle->mutex);
     }
     
-    free(handle);
+    free_handle(handle);
+    
+    return ESP_OK;
+}
+
+esp_err_t vl53l0x_reader_init(vl53l0x_handle_t handle, vl53l0x_reader_t* reader) {
+    if (!handle || !reader) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    reader->next_seq = vl53l0x_ring_head(&handle->ring);
+    reader->dropped = 0;
+    
+    return ESP_OK;
+}
+
+size_t vl53l0x_read_samples(vl53l0x_handle_t handle, vl53l0x_reader_t* reader,
+                            vl53l0x_measurement_t* samples, size_t max_samples) {
+    if (!handle || !reader || !samples) {
+        return 0;
+    }
+    
+    return vl53l0x_ring_read(&handle->ring, reader, samples, max_samples);
+}
+
+esp_err_t vl53l0x_get_latest(vl53l0x_handle_t handle, vl53l0x_measurement_t* sample) {
+    if (!handle || !sample) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    return vl53l0x_ring_latest(&handle->ring, sample) ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t vl53l0x_get_wait_stats(vl53l0x_handle_t handle, vl53l0x_wait_stats_t* stats) {
+    if (!handle || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(handle->mutex, portMAX_DELAY);
+    bool counting = (handle->wait_stats != NULL);
+    if (counting) {
+        *stats = *handle->wait_stats;
+    }
+    xSemaphoreGive(handle->mutex);
+    
+    return counting ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t vl53l0x_reset_wait_stats(vl53l0x_handle_t handle) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(handle->mutex, portMAX_DELAY);
+    if (handle->wait_stats) {
+        memset(handle->wait_stats, 0, sizeof(vl53l0x_wait_stats_t));
+    } else {
+        handle->wait_stats = (vl53l0x_wait_stats_t*)calloc(1, sizeof(vl53l0x_wait_stats_t));
+    }
+    bool counting = (handle->wait_stats != NULL);
+    xSemaphoreGive(handle->mutex);
+    
+    return counting ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+esp_err_t vl53l0x_get_health(vl53l0x_handle_t handle, vl53l0x_health_t* health) {
+    if (!handle || !health) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(handle->mutex, portMAX_DELAY);
+    *health = handle->health;
+    xSemaphoreGive(handle->mutex);
+    
+    return ESP_OK;
+}
+
+esp_err_t vl53l0x_get_mode_stats(vl53l0x_handle_t handle, vl53l0x_mode_stats_t* stats) {
+    if (!handle || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(handle->mutex, portMAX_DELAY);
+    if (handle->modes) {
+        *stats = handle->modes->stats;
+    } else {
+        memset(stats, 0, sizeof(*stats));
+    }
+    xSemaphoreGive(handle->mutex);
+    
+    return ESP_OK;
+}
+
+esp_err_t vl53l0x_get_footprint(vl53l0x_handle_t handle, vl53l0x_footprint_t* footprint) {
+    if (!handle || !footprint) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    footprint->handle_bytes = sizeof(struct vl53l0x_handle_s);
+    footprint->device_bytes = sizeof(VL53L0X_Dev_t);
+    footprint->history_bytes = (handle->ring.mask + 1) * sizeof(vl53l0x_ring_slot_t);
+    footprint->multi_shot_bytes = handle->shots ? handle->config.multi_shot_count * sizeof(shot_t) : 0;
+    footprint->presets_bytes = handle->modes ? sizeof(mode_table_t) : 0;
+    footprint->async_bytes = handle->async ? sizeof(async_shot_t) : 0;
+    footprint->wait_stats_bytes = handle->wait_stats ? sizeof(vl53l0x_wait_stats_t) : 0;
+    footprint->lock_bytes = sizeof(StaticSemaphore_t);
+    footprint->task_stack_bytes = handle->task_handle ? CONTINUOUS_TASK_STACK : 0;
+    footprint->total_bytes = footprint->handle_bytes + footprint->history_bytes +
+                             footprint->multi_shot_bytes + footprint->presets_bytes +
+                             footprint->async_bytes + footprint->wait_stats_bytes +
+                             footprint->lock_bytes + footprint->task_stack_bytes;
     
     return ESP_OK;
 }
@@ -350,6 +2333,8 @@ const char* vl53l0x_get_mode_name(vl53l0x_mode_t mode) {
         case VL53L0X_MODE_HIGH_ACCURACY: return "High Accuracy";
         case VL53L0X_MODE_HIGH_SPEED: return "High Speed";
         case VL53L0X_MODE_LONG_RANGE: return "Long Range";
+        case VL53L0X_MODE_ULTRA_FAST: return "Ultra Fast";
+        case VL53L0X_MODE_MULTI_SHOT: return "Multi Shot";
         case VL53L0X_MODE_DEFAULT:
         default: return "Default";
     }
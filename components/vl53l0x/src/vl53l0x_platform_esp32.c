@@ -6,17 +6,613 @@
 
 #include "vl53l0x_platform.h"
 #include "vl53l0x_api.h"
+#include "vl53l0x_bus.h"
+#ifdef VL53L0X_SIMULATOR
+#include "vl53l0x_sim_io.h"
+#endif
+#include "vl53l0x_trace.h"
+#include "vl53l0x_driver.h"
 #include "driver/i2c_master.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include <string.h>
 #include <stdlib.h>
 
-#define I2C_MASTER_TIMEOUT_MS 1000
+// Plazo de cada transferencia: el doble del tiempo en el bus (margen para
+// clock stretching) más un margen fijo
+#define I2C_XFER_MARGIN_US 1000
 
-// External global handle set by driver
-extern i2c_master_dev_handle_t g_current_vl53l0x_dev_handle;
+// Tras un fallo que la recuperación no resuelve, las transferencias fallan
+// sin tocar el bus durante este tiempo: la API de ST ignora muchos errores
+// intermedios y seguiría pagando dos plazos por cada registro
+#define I2C_FAULT_HOLDOFF_US 5000
+
+// Espera de cada iteración de los bucles de sondeo de ST
+#define POLLING_DELAY_US 1000
+
+#define VL53L0X_REG_PAGE_SELECT      0xFF  // Selección de página de registros
+#define VL53L0X_REG_PRIVATE_ACCESS   0x80  // Acceso a registros privados
+
+// Asignaciones de heap hechas por la capa de plataforma
+static uint32_t alloc_count = 0;
+static portMUX_TYPE alloc_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Número de asignaciones de heap hechas por escrituras I2C
+ */
+uint32_t vl53l0x_get_platform_alloc_count(void)
+{
+    portENTER_CRITICAL(&alloc_lock);
+    uint32_t count = alloc_count;
+    portEXIT_CRITICAL(&alloc_lock);
+    return count;
+}
+
+#ifdef VL53L0X_I2C_TRACE
+
+/*
+ * Trazado de transferencias I2C (sólo con -DVL53L0X_I2C_TRACE)
+ *
+ * Las macros LOG_FUNCTION_START/END de la API de ST llaman a
+ * vl53l0x_trace_enter/exit, que mantienen por tarea una pila de las
+ * llamadas en curso; cada transferencia se anota en un anillo y se
+ * atribuye a la llamada más interna.
+ */
+
+#define TRACE_STACK_DEPTH 8
+
+static vl53l0x_trace_event_t trace_ring[VL53L0X_TRACE_RING_SIZE];
+static uint32_t trace_head = 0;                  // Eventos escritos desde el último reset
+static vl53l0x_trace_api_t trace_apis[VL53L0X_TRACE_MAX_APIS] = {
+    [VL53L0X_TRACE_API_DIRECT] = { .name = "(direct)" },
+};
+static size_t trace_api_count = 1;
+static uint32_t trace_hist[VL53L0X_TRACE_HIST_BUCKETS];
+static portMUX_TYPE trace_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Pila de llamadas de la API de ST en curso, por tarea
+static __thread uint8_t trace_stack[TRACE_STACK_DEPTH];
+static __thread int64_t trace_start_us[TRACE_STACK_DEPTH];
+static __thread uint8_t trace_depth;
+
+static inline uint32_t trace_bucket(uint32_t us)
+{
+    uint32_t bucket = (us < 2) ? 0 : 31 - __builtin_clz(us);
+    return (bucket < VL53L0X_TRACE_HIST_BUCKETS) ? bucket : VL53L0X_TRACE_HIST_BUCKETS - 1;
+}
+
+/**
+ * @brief Índice de una función en la tabla, añadiéndola si es nueva
+ *
+ * Los nombres son __func__, así que basta comparar punteros.
+ */
+static uint8_t trace_api_index(const char *function)
+{
+    uint8_t index = VL53L0X_TRACE_API_DIRECT;
+    
+    portENTER_CRITICAL(&trace_lock);
+    for (size_t i = 1; i < trace_api_count; i++) {
+        if (trace_apis[i].name == function) {
+            index = i;
+            break;
+        }
+    }
+    if (index == VL53L0X_TRACE_API_DIRECT && trace_api_count < VL53L0X_TRACE_MAX_APIS) {
+        index = trace_api_count++;
+        trace_apis[index].name = function;
+    }
+    portEXIT_CRITICAL(&trace_lock);
+    
+    return index;
+}
+
+void vl53l0x_trace_enter(const char *function)
+{
+    uint8_t depth = trace_depth++;
+    if (depth < TRACE_STACK_DEPTH) {
+        trace_stack[depth] = trace_api_index(function);
+        trace_start_us[depth] = esp_timer_get_time();
+    }
+}
+
+void vl53l0x_trace_exit(const char *function)
+{
+    if (trace_depth == 0) {
+        return;
+    }
+    if (trace_depth > TRACE_STACK_DEPTH) {
+        trace_depth--;
+        return;
+    }
+    
+    uint8_t index = trace_api_index(function);
+    
+    // Algunas funciones de ST retornan sin LOG_FUNCTION_END: desapilar
+    // hasta encontrar la llamada que termina
+    int depth = trace_depth - 1;
+    while (depth >= 0 && trace_stack[depth] != index) {
+        depth--;
+    }
+    if (depth < 0) {
+        return;
+    }
+    trace_depth = depth;
+    
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - trace_start_us[depth]);
+    vl53l0x_trace_api_t *api = &trace_apis[index];
+    
+    portENTER_CRITICAL(&trace_lock);
+    api->calls++;
+    api->total_us += elapsed_us;
+    if (elapsed_us > api->max_us) {
+        api->max_us = elapsed_us;
+    }
+    api->hist[trace_bucket(elapsed_us)]++;
+    portEXIT_CRITICAL(&trace_lock);
+}
+
+/**
+ * @brief Anota una transferencia en el anillo y en los agregados
+ */
+static void trace_transfer(VL53L0X_DEV Dev, uint8_t reg, uint32_t len, uint8_t flags, int64_t start_us)
+{
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start_us);
+    uint8_t depth = trace_depth;
+    uint8_t index = (depth == 0) ? VL53L0X_TRACE_API_DIRECT
+                  : trace_stack[(depth <= TRACE_STACK_DEPTH) ? depth - 1 : TRACE_STACK_DEPTH - 1];
+    
+    vl53l0x_trace_event_t event = {
+        .time_us = (uint32_t)start_us,
+        .duration_us = (elapsed_us > UINT16_MAX) ? UINT16_MAX : elapsed_us,
+        .address = Dev->I2cDevAddr,
+        .reg = reg,
+        .length = (len > UINT8_MAX) ? UINT8_MAX : len,
+        .flags = flags,
+        .api = index,
+    };
+    
+    portENTER_CRITICAL(&trace_lock);
+    trace_ring[trace_head % VL53L0X_TRACE_RING_SIZE] = event;
+    trace_head++;
+    trace_hist[trace_bucket(elapsed_us)]++;
+    trace_apis[index].transfers++;
+    trace_apis[index].bytes += len;
+    portEXIT_CRITICAL(&trace_lock);
+}
+
+#define TRACE_TRANSFER(Dev, reg, len, flags, start_us) trace_transfer(Dev, reg, len, flags, start_us)
+
+/**
+ * @brief Copia los eventos [first, first + max) que sigan en el anillo
+ */
+static size_t trace_copy_events(uint32_t first, vl53l0x_trace_event_t *events, size_t max_events)
+{
+    size_t count = 0;
+    
+    portENTER_CRITICAL(&trace_lock);
+    if (trace_head - first > VL53L0X_TRACE_RING_SIZE) {
+        first = trace_head - VL53L0X_TRACE_RING_SIZE;
+    }
+    while (count < max_events && first + count != trace_head) {
+        events[count] = trace_ring[(first + count) % VL53L0X_TRACE_RING_SIZE];
+        count++;
+    }
+    portEXIT_CRITICAL(&trace_lock);
+    
+    return count;
+}
+
+esp_err_t vl53l0x_trace_get_events(vl53l0x_trace_event_t *events, size_t max_events, size_t *count)
+{
+    if (events == NULL || count == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    uint32_t head = trace_head;
+    uint32_t first = (head > VL53L0X_TRACE_RING_SIZE) ? head - VL53L0X_TRACE_RING_SIZE : 0;
+    *count = trace_copy_events(first, events, max_events);
+    return ESP_OK;
+}
+
+esp_err_t vl53l0x_trace_get_apis(vl53l0x_trace_api_t *apis, size_t max_apis, size_t *count)
+{
+    if (apis == NULL || count == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    portENTER_CRITICAL(&trace_lock);
+    size_t n = (trace_api_count < max_apis) ? trace_api_count : max_apis;
+    memcpy(apis, trace_apis, n * sizeof(*apis));
+    portEXIT_CRITICAL(&trace_lock);
+    
+    *count = n;
+    return ESP_OK;
+}
+
+esp_err_t vl53l0x_trace_get_histogram(uint32_t hist[VL53L0X_TRACE_HIST_BUCKETS])
+{
+    if (hist == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    portENTER_CRITICAL(&trace_lock);
+    memcpy(hist, trace_hist, sizeof(trace_hist));
+    portEXIT_CRITICAL(&trace_lock);
+    return ESP_OK;
+}
+
+void vl53l0x_trace_reset(void)
+{
+    // Se conservan los nombres: las pilas en curso guardan índices
+    portENTER_CRITICAL(&trace_lock);
+    for (size_t i = 0; i < trace_api_count; i++) {
+        const char *name = trace_apis[i].name;
+        memset(&trace_apis[i], 0, sizeof(trace_apis[i]));
+        trace_apis[i].name = name;
+    }
+    memset(trace_hist, 0, sizeof(trace_hist));
+    trace_head = 0;
+    portEXIT_CRITICAL(&trace_lock);
+}
+
+/**
+ * @brief Copia una entrada de la tabla de funciones
+ */
+static bool trace_get_api(size_t index, vl53l0x_trace_api_t *api)
+{
+    bool found = false;
+    
+    portENTER_CRITICAL(&trace_lock);
+    if (index < trace_api_count) {
+        *api = trace_apis[index];
+        found = true;
+    }
+    portEXIT_CRITICAL(&trace_lock);
+    
+    return found;
+}
+
+esp_err_t vl53l0x_trace_dump(void)
+{
+    static const char *TAG = "VL53L0X_TRACE";
+    vl53l0x_trace_api_t api;
+    
+    ESP_LOGI(TAG, "%-44s %7s %7s %7s %10s %8s", "function", "calls", "xfers", "bytes", "total_us", "max_us");
+    for (size_t i = 0; trace_get_api(i, &api); i++) {
+        if (api.calls == 0 && api.transfers == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "%-44s %7lu %7lu %7lu %10llu %8lu", api.name,
+                 (unsigned long)api.calls, (unsigned long)api.transfers,
+                 (unsigned long)api.bytes, (unsigned long long)api.total_us,
+                 (unsigned long)api.max_us);
+    }
+    
+    uint32_t hist[VL53L0X_TRACE_HIST_BUCKETS];
+    vl53l0x_trace_get_histogram(hist);
+    for (size_t i = 0; i < VL53L0X_TRACE_HIST_BUCKETS; i++) {
+        if (hist[i] > 0) {
+            ESP_LOGI(TAG, "transfer >= %6lu us: %lu", (unsigned long)(i ? 1UL << i : 0), (unsigned long)hist[i]);
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t vl53l0x_trace_dump_binary(vl53l0x_trace_write_fn_t write, void *ctx)
+{
+    vl53l0x_trace_api_t api;
+    uint32_t hist[VL53L0X_TRACE_HIST_BUCKETS];
+    
+    if (write == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    vl53l0x_trace_get_histogram(hist);
+    
+    portENTER_CRITICAL(&trace_lock);
+    size_t api_count = trace_api_count;
+    uint32_t head = trace_head;
+    portEXIT_CRITICAL(&trace_lock);
+    uint32_t first = (head > VL53L0X_TRACE_RING_SIZE) ? head - VL53L0X_TRACE_RING_SIZE : 0;
+    
+    vl53l0x_trace_header_t header = {
+        .magic = { 'V', 'L', 'T', 'R' },
+        .version = 1,
+        .hist_buckets = VL53L0X_TRACE_HIST_BUCKETS,
+        .api_count = api_count,
+        .event_count = head - first,
+        .lost_events = first,
+    };
+    write(&header, sizeof(header), ctx);
+    write(hist, sizeof(hist), ctx);
+    
+    for (size_t i = 0; i < api_count && trace_get_api(i, &api); i++) {
+        const char *name = api.name ? api.name : "";
+        size_t name_len = strlen(name);
+        uint8_t len_byte = (name_len > UINT8_MAX) ? UINT8_MAX : name_len;
+        uint32_t fields[5] = {
+            api.calls, api.transfers, api.bytes, (uint32_t)api.total_us, api.max_us,
+        };
+        write(&len_byte, 1, ctx);
+        write(name, len_byte, ctx);
+        write(fields, sizeof(fields), ctx);
+        write(api.hist, sizeof(api.hist), ctx);
+    }
+    
+    // Por bloques, para no llamar al sumidero dentro de la sección crítica;
+    // si el anillo avanza mientras tanto se rellena con eventos vacíos
+    vl53l0x_trace_event_t chunk[16];
+    uint32_t remaining = header.event_count;
+    uint32_t next = first;
+    while (remaining > 0) {
+        size_t want = (remaining < 16) ? remaining : 16;
+        size_t got = trace_copy_events(next, chunk, want);
+        if (got < want) {
+            memset(&chunk[got], 0, (want - got) * sizeof(chunk[0]));
+        }
+        write(chunk, want * sizeof(chunk[0]), ctx);
+        next += want;
+        remaining -= want;
+    }
+    return ESP_OK;
+}
+
+#else
+
+#define TRACE_TRANSFER(Dev, reg, len, flags, start_us) ((void)0)
+
+esp_err_t vl53l0x_trace_get_events(vl53l0x_trace_event_t *events, size_t max_events, size_t *count)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t vl53l0x_trace_get_apis(vl53l0x_trace_api_t *apis, size_t max_apis, size_t *count)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t vl53l0x_trace_get_histogram(uint32_t hist[VL53L0X_TRACE_HIST_BUCKETS])
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void vl53l0x_trace_reset(void)
+{
+}
+
+esp_err_t vl53l0x_trace_dump(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t vl53l0x_trace_dump_binary(vl53l0x_trace_write_fn_t write, void *ctx)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // VL53L0X_I2C_TRACE
+
+/**
+ * @brief Plazo de una transferencia de wire_bytes bytes a la velocidad del bus
+ *
+ * El driver I2C espera en ticks y trunca los ms al convertirlos, y una
+ * espera de un tick puede vencer de inmediato: el plazo se redondea hacia
+ * arriba a ticks enteros, con un mínimo de dos, y se devuelve en ms sin
+ * que la conversión pierda ninguno. Con un tick de 1 ms son 2 ms; con uno
+ * de 10 ms, 20 ms.
+ */
+static int xfer_timeout_ms(VL53L0X_DEV Dev, uint32_t wire_bytes)
+{
+    uint32_t khz = Dev->comms_speed_khz ? Dev->comms_speed_khz : 100;
+    // 9 ciclos por byte más START y STOP
+    uint32_t wire_us = (wire_bytes * 9 + 2) * 1000 / khz;
+    uint64_t deadline_us = 2 * wire_us + I2C_XFER_MARGIN_US;
+    
+    uint64_t ticks = (deadline_us * configTICK_RATE_HZ + 999999) / 1000000;
+    if (ticks < 2) {
+        ticks = 2;
+    }
+    return (int)((ticks * 1000 + configTICK_RATE_HZ - 1) / configTICK_RATE_HZ);
+}
+
+/**
+ * @brief Tras un fallo, libera el bus (9 pulsos de SCL y STOP) si puede estar bloqueado
+ *
+ * Sólo un plazo vencido o un bus ocupado apuntan a un esclavo que retiene
+ * SDA. Un NACK deja el bus libre: resetearlo no ayuda y cortaría la
+ * transferencia de otro sensor del mismo bus.
+ */
+static void recover_bus(VL53L0X_DEV Dev, esp_err_t ret)
+{
+    // El estado del sensor es desconocido tras un fallo
+    Dev->i2c_page_valid = false;
+    
+    if (ret != ESP_ERR_TIMEOUT && ret != ESP_ERR_INVALID_STATE) {
+        return;
+    }
+#ifdef VL53L0X_SIMULATOR
+    if (Dev->sim) {
+        vl53l0x_sim_bus_reset(Dev->sim);
+    } else
+#endif
+    {
+        vl53l0x_bus_recover(Dev->i2c_bus);
+    }
+}
+
+/**
+ * @brief Indica si el dispositivo tiene handle I2C (o un sensor simulado)
+ */
+static bool device_attached(VL53L0X_DEV Dev)
+{
+#ifdef VL53L0X_SIMULATOR
+    if (Dev->sim) {
+        return true;
+    }
+#endif
+    return Dev->i2c_dev_handle != NULL;
+}
+
+/**
+ * @brief Indica si sigue abierta la ventana de fallo rápido
+ */
+static bool bus_faulted(VL53L0X_DEV Dev)
+{
+    return Dev->i2c_fault_until_us != 0 && esp_timer_get_time() < Dev->i2c_fault_until_us;
+}
+
+/**
+ * @brief Abre la ventana de fallo rápido si el reintento también falló
+ */
+static void note_unrecovered(VL53L0X_DEV Dev, esp_err_t ret)
+{
+    Dev->i2c_fault_until_us = (ret == ESP_OK) ? 0 : esp_timer_get_time() + I2C_FAULT_HOLDOFF_US;
+}
+
+/**
+ * @brief Un intento de escritura (índice + datos), contabilizado
+ */
+static esp_err_t write_once(VL53L0X_DEV Dev, const uint8_t *buf, uint32_t len)
+{
+    // Dirección + índice + datos
+    int timeout_ms = xfer_timeout_ms(Dev, len + 1);
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t ret;
+    
+#ifdef VL53L0X_SIMULATOR
+    if (Dev->sim) {
+        ret = vl53l0x_sim_write(Dev->sim, buf, len, timeout_ms);
+    } else
+#endif
+    {
+        ret = i2c_master_transmit(Dev->i2c_dev_handle, buf, len, timeout_ms);
+        vl53l0x_bus_account(Dev->i2c_bus, len, (uint32_t)(esp_timer_get_time() - start_us), ret == ESP_OK);
+    }
+    TRACE_TRANSFER(Dev, buf[0], len - 1, (ret == ESP_OK) ? 0 : VL53L0X_TRACE_FLAG_ERROR, start_us);
+    
+    return ret;
+}
+
+/**
+ * @brief Un intento de lectura desde un índice, contabilizado
+ */
+static esp_err_t read_once(VL53L0X_DEV Dev, uint8_t index, uint8_t *pdata, uint32_t count)
+{
+    // Dirección + índice, START repetido, dirección + datos
+    int timeout_ms = xfer_timeout_ms(Dev, count + 3);
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t ret;
+    
+#ifdef VL53L0X_SIMULATOR
+    if (Dev->sim) {
+        ret = vl53l0x_sim_read(Dev->sim, index, pdata, count, timeout_ms);
+    } else
+#endif
+    {
+        // Usar la nueva API i2c_master_transmit_receive
+        ret = i2c_master_transmit_receive(Dev->i2c_dev_handle, 
+                                          &index, 1,           // Escribir el índice del registro
+                                          pdata, count,        // Leer los datos
+                                          timeout_ms);
+        vl53l0x_bus_account(Dev->i2c_bus, count + 1, (uint32_t)(esp_timer_get_time() - start_us), ret == ESP_OK);
+    }
+    TRACE_TRANSFER(Dev, index, count,
+                   VL53L0X_TRACE_FLAG_READ | ((ret == ESP_OK) ? 0 : VL53L0X_TRACE_FLAG_ERROR), start_us);
+    
+    return ret;
+}
+
+/**
+ * @brief Envía un buffer (índice + datos) y contabiliza la transferencia
+ *
+ * Tras un fallo se reintenta una vez (las escrituras de registro son
+ * idempotentes), liberando antes el bus si puede estar bloqueado.
+ */
+static VL53L0X_Error transmit(VL53L0X_DEV Dev, const uint8_t *buf, uint32_t len)
+{
+    if (bus_faulted(Dev)) {
+        return VL53L0X_ERROR_CONTROL_INTERFACE;
+    }
+    
+    esp_err_t ret = write_once(Dev, buf, len);
+    
+    if (ret != ESP_OK) {
+        recover_bus(Dev, ret);
+        ret = write_once(Dev, buf, len);
+        note_unrecovered(Dev, ret);
+    }
+    
+    return (ret == ESP_OK) ? VL53L0X_ERROR_NONE : VL53L0X_ERROR_CONTROL_INTERFACE;
+}
+
+/**
+ * @brief Envía la ráfaga de escrituras pendiente, si existe
+ */
+static VL53L0X_Error batch_flush(VL53L0X_DEV Dev)
+{
+    if (Dev->i2c_batch_len == 0) {
+        return VL53L0X_ERROR_NONE;
+    }
+    
+    uint32_t len = Dev->i2c_batch_len;
+    Dev->i2c_batch_len = 0;
+    return transmit(Dev, Dev->i2c_batch, len);
+}
+
+/**
+ * @brief Intenta añadir una escritura a la ráfaga pendiente
+ *
+ * Sólo se fusionan escrituras a registros consecutivos (el sensor
+ * autoincrementa el índice) y nunca los registros de control de página.
+ */
+static bool batch_append(VL53L0X_DEV Dev, uint8_t index, const uint8_t *pdata, uint32_t count)
+{
+    if (index == VL53L0X_REG_PAGE_SELECT || index == VL53L0X_REG_PRIVATE_ACCESS) {
+        return false;
+    }
+    
+    uint32_t len = Dev->i2c_batch_len;
+    
+    if (len > 0) {
+        // Continúa la ráfaga sólo si el registro sigue al último escrito
+        uint32_t next_index = Dev->i2c_batch[0] + (len - 1);
+        if (index != next_index || len + count > sizeof(Dev->i2c_batch)) {
+            return false;
+        }
+    } else {
+        if (count + 1 > sizeof(Dev->i2c_batch)) {
+            return false;
+        }
+        Dev->i2c_batch[0] = index;
+        len = 1;
+    }
+    
+    memcpy(&Dev->i2c_batch[len], pdata, count);
+    Dev->i2c_batch_len = len + count;
+    return true;
+}
+
+VL53L0X_Error vl53l0x_batch_begin(VL53L0X_DEV Dev)
+{
+    Dev->i2c_batch_depth++;
+    return VL53L0X_ERROR_NONE;
+}
+
+VL53L0X_Error vl53l0x_batch_end(VL53L0X_DEV Dev)
+{
+    if (Dev->i2c_batch_depth > 0) {
+        Dev->i2c_batch_depth--;
+    }
+    return (Dev->i2c_batch_depth == 0) ? batch_flush(Dev) : VL53L0X_ERROR_NONE;
+}
+
+void vl53l0x_invalidate_page(VL53L0X_DEV Dev)
+{
+    Dev->i2c_page_valid = false;
+}
 
 /**
  * @brief Escribe múltiples bytes en un registro del VL53L0X
@@ -25,28 +621,62 @@ VL53L0X_Error VL53L0X_WriteMulti(VL53L0X_DEV Dev, uint8_t index, uint8_t *pdata,
 {
     VL53L0X_Error Status = VL53L0X_ERROR_NONE;
     
-    // Get I2C device handle from global variable
-    i2c_master_dev_handle_t dev_handle = g_current_vl53l0x_dev_handle;
-    if (!dev_handle) {
+    // Cada dispositivo lleva su propio handle I2C (o un sensor simulado)
+    if (!Dev || !device_attached(Dev) || count == 0) {
         return VL53L0X_ERROR_CONTROL_INTERFACE;
     }
     
-    // Crear buffer con el índice del registro seguido de los datos
-    uint8_t *write_buf = malloc(count + 1);
-    if (write_buf == NULL) {
-        return VL53L0X_ERROR_CONTROL_INTERFACE;
+    // Cambio de página redundante: el registro 0xFF ya tiene ese valor
+    if (index == VL53L0X_REG_PAGE_SELECT && count == 1) {
+        if (Dev->i2c_page_valid && Dev->i2c_page == pdata[0]) {
+            return VL53L0X_ERROR_NONE;
+        }
+    }
+    
+    // Dentro de una sección por lotes, fusionar con la ráfaga pendiente
+    if (Dev->i2c_batch_depth > 0) {
+        if (batch_append(Dev, index, pdata, count)) {
+            return VL53L0X_ERROR_NONE;
+        }
+        Status = batch_flush(Dev);
+        if (Status == VL53L0X_ERROR_NONE && batch_append(Dev, index, pdata, count)) {
+            return VL53L0X_ERROR_NONE;
+        }
+        if (Status != VL53L0X_ERROR_NONE) {
+            return Status;
+        }
+    }
+    
+    // Índice del registro seguido de los datos, en el buffer del dispositivo;
+    // sólo escrituras mayores que el buffer recurren al heap
+    uint8_t *write_buf = Dev->i2c_scratch;
+    if (count + 1 > sizeof(Dev->i2c_scratch)) {
+        write_buf = malloc(count + 1);
+        if (write_buf == NULL) {
+            return VL53L0X_ERROR_CONTROL_INTERFACE;
+        }
+        portENTER_CRITICAL(&alloc_lock);
+        alloc_count++;
+        portEXIT_CRITICAL(&alloc_lock);
     }
     
     write_buf[0] = index;
     memcpy(&write_buf[1], pdata, count);
     
-    // Usar la nueva API i2c_master_transmit
-    esp_err_t ret = i2c_master_transmit(dev_handle, write_buf, count + 1, I2C_MASTER_TIMEOUT_MS);
+    Status = transmit(Dev, write_buf, count + 1);
     
-    free(write_buf);
+    if (write_buf != Dev->i2c_scratch) {
+        free(write_buf);
+    }
     
-    if (ret != ESP_OK) {
-        Status = VL53L0X_ERROR_CONTROL_INTERFACE;
+    if (Status == VL53L0X_ERROR_NONE) {
+        if (index == VL53L0X_REG_PAGE_SELECT && count == 1) {
+            Dev->i2c_page = pdata[0];
+            Dev->i2c_page_valid = true;
+        } else if (index == VL53L0X_REG_SOFT_RESET_GO2_SOFT_RESET_N) {
+            // El reset devuelve el sensor a la página 0
+            Dev->i2c_page_valid = false;
+        }
     }
     
     return Status;
@@ -59,23 +689,30 @@ VL53L0X_Error VL53L0X_ReadMulti(VL53L0X_DEV Dev, uint8_t index, uint8_t *pdata,
 {
     VL53L0X_Error Status = VL53L0X_ERROR_NONE;
     
-    // Get I2C device handle from global variable
-    i2c_master_dev_handle_t dev_handle = g_current_vl53l0x_dev_handle;
-    if (!dev_handle) {
+    // Cada dispositivo lleva su propio handle I2C (o un sensor simulado)
+    if (!Dev || !device_attached(Dev)) {
+        return VL53L0X_ERROR_CONTROL_INTERFACE;
+    }
+    
+    // Las escrituras pendientes deben llegar antes que la lectura
+    Status = batch_flush(Dev);
+    if (Status != VL53L0X_ERROR_NONE) {
+        return Status;
+    }
+    
+    if (bus_faulted(Dev)) {
         return VL53L0X_ERROR_CONTROL_INTERFACE;
     }
     
-    // Usar la nueva API i2c_master_transmit_receive
-    esp_err_t ret = i2c_master_transmit_receive(dev_handle, 
-                                                 &index, 1,           // Escribir el índice del registro
-                                                 pdata, count,        // Leer los datos
-                                                 I2C_MASTER_TIMEOUT_MS);
+    esp_err_t ret = read_once(Dev, index, pdata, count);
     
     if (ret != ESP_OK) {
-        Status = VL53L0X_ERROR_CONTROL_INTERFACE;
+        recover_bus(Dev, ret);
+        ret = read_once(Dev, index, pdata, count);
+        note_unrecovered(Dev, ret);
     }
     
-    return Status;
+    return (ret == ESP_OK) ? VL53L0X_ERROR_NONE : VL53L0X_ERROR_CONTROL_INTERFACE;
 }
 
 /**
@@ -159,11 +796,22 @@ VL53L0X_Error VL53L0X_UpdateByte(VL53L0X_DEV Dev, uint8_t index, uint8_t AndData
 }
 
 /**
- * @brief Función de delay en milisegundos
+ * @brief Espera de 1 ms entre sondeos de la API de ST, con cualquier tick
  */
 VL53L0X_Error VL53L0X_PollingDelay(VL53L0X_DEV Dev)
 {
-    (void)Dev;
-    vTaskDelay(pdMS_TO_TICKS(1));
+    // Las escrituras pendientes deben llegar antes de esperar
+    batch_flush(Dev);
+    
+    // Los bucles de ST cuentan iteraciones (2000 como máximo), así que cada
+    // espera debe durar 1 ms. Con un tick de 1 ms se duerme y el bus queda
+    // libre; con ticks más largos (10 ms a los 100 Hz por defecto) un tick
+    // alargaría cada sondeo diez veces y pdMS_TO_TICKS(1) valdría 0, así
+    // que se espera activamente
+    if (portTICK_PERIOD_MS * 1000 <= POLLING_DELAY_US) {
+        vTaskDelay(1);
+    } else {
+        esp_rom_delay_us(POLLING_DELAY_US);
+    }
     return VL53L0X_ERROR_NONE;
 }
@@ -0,0 +1,104 @@
+/**
+ * @file vl53l0x_ring.c
+ * @brief Per-sensor sample ring with per-slot sequence counters
+ */
+
+#include "vl53l0x_ring.h"
+
+#define LATEST_RETRIES  4   // Attempts before giving up on a slot being rewritten
+
+uint32_t vl53l0x_ring_depth(uint32_t requested) {
+    if (requested == 0) {
+        return VL53L0X_RING_DEFAULT_DEPTH;
+    }
+    
+    uint32_t depth = 2;
+    while (depth < requested && depth < VL53L0X_RING_MAX_DEPTH) {
+        depth <<= 1;
+    }
+    return depth;
+}
+
+void vl53l0x_ring_init(vl53l0x_ring_t* ring, vl53l0x_ring_slot_t* slots, uint32_t depth) {
+    atomic_init(&ring->head, 0);
+    ring->mask = depth - 1;
+    ring->slots = slots;
+}
+
+void vl53l0x_ring_publish(vl53l0x_ring_t* ring, vl53l0x_measurement_t* sample) {
+    uint32_t seq = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    vl53l0x_ring_slot_t* slot = &ring->slots[seq & ring->mask];
+    uint32_t version = atomic_load_explicit(&slot->version, memory_order_relaxed);
+    
+    // Mark the slot busy before touching the payload
+    atomic_store_explicit(&slot->version, version + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    
+    sample->seq = seq;
+    slot->sample = *sample;
+    
+    atomic_store_explicit(&slot->version, version + 2, memory_order_release);
+    atomic_store_explicit(&ring->head, seq + 1, memory_order_release);
+}
+
+uint32_t vl53l0x_ring_head(const vl53l0x_ring_t* ring) {
+    return atomic_load_explicit(&ring->head, memory_order_acquire);
+}
+
+/**
+ * @brief Copy one slot, failing if the producer touched it meanwhile
+ */
+static bool read_slot(const vl53l0x_ring_t* ring, uint32_t seq, vl53l0x_measurement_t* out) {
+    const vl53l0x_ring_slot_t* slot = &ring->slots[seq & ring->mask];
+    
+    uint32_t before = atomic_load_explicit(&slot->version, memory_order_acquire);
+    if (before & 1) {
+        return false;
+    }
+    
+    *out = slot->sample;
+    
+    atomic_thread_fence(memory_order_acquire);
+    uint32_t after = atomic_load_explicit(&slot->version, memory_order_relaxed);
+    
+    return before == after && out->seq == seq;
+}
+
+size_t vl53l0x_ring_read(const vl53l0x_ring_t* ring, vl53l0x_reader_t* reader,
+                         vl53l0x_measurement_t* out, size_t max) {
+    uint32_t head = vl53l0x_ring_head(ring);
+    size_t count = 0;
+    
+    while (count < max && reader->next_seq != head) {
+        // Overrun: skip what the producer already overwrote
+        uint32_t behind = head - reader->next_seq;
+        if (behind > ring->mask + 1) {
+            reader->dropped += behind - (ring->mask + 1);
+            reader->next_seq = head - (ring->mask + 1);
+        }
+        
+        if (read_slot(ring, reader->next_seq, &out[count])) {
+            count++;
+        } else {
+            // Lapped while copying; never spin on a slot the producer owns
+            reader->dropped++;
+        }
+        reader->next_seq++;
+        head = vl53l0x_ring_head(ring);
+    }
+    
+    return count;
+}
+
+bool vl53l0x_ring_latest(const vl53l0x_ring_t* ring, vl53l0x_measurement_t* out) {
+    for (int i = 0; i < LATEST_RETRIES; i++) {
+        uint32_t head = vl53l0x_ring_head(ring);
+        if (head == 0) {
+            return false;
+        }
+        if (read_slot(ring, head - 1, out)) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file vl53l0x_ring.h
+ * @brief Internal per-sensor sample ring (single producer, lock-free readers)
+ */
+
+#ifndef VL53L0X_RING_H
+#define VL53L0X_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "vl53l0x_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VL53L0X_RING_DEFAULT_DEPTH  32      // Samples kept per sensor unless configured
+#define VL53L0X_RING_MAX_DEPTH      128
+
+/**
+ * @brief One ring slot, guarded by its own sequence counter
+ */
+typedef struct {
+    atomic_uint version;            // Odd while the producer is writing the slot
+    vl53l0x_measurement_t sample;
+} vl53l0x_ring_slot_t;
+
+/**
+ * @brief Sample ring
+ * 
+ * Only one producer may publish at a time (the driver serializes producers
+ * on the handle mutex). Readers never block the producer: a reader that
+ * falls more than the ring depth behind loses the oldest ones.
+ */
+typedef struct {
+    atomic_uint head;               // Sequence number of the next sample
+    uint32_t mask;                  // Depth - 1, the depth being a power of two
+    vl53l0x_ring_slot_t* slots;     // Storage owned by the caller
+} vl53l0x_ring_t;
+
+/**
+ * @brief Depth a requested history length gets: a power of two, 2 to VL53L0X_RING_MAX_DEPTH
+ * 
+ * @param requested Samples asked for, 0 for VL53L0X_RING_DEFAULT_DEPTH
+ */
+uint32_t vl53l0x_ring_depth(uint32_t requested);
+
+/**
+ * @brief Set up an empty ring over depth zeroed slots
+ */
+void vl53l0x_ring_init(vl53l0x_ring_t* ring, vl53l0x_ring_slot_t* slots, uint32_t depth);
+
+/**
+ * @brief Publish a sample, assigning its sequence number
+ */
+void vl53l0x_ring_publish(vl53l0x_ring_t* ring, vl53l0x_measurement_t* sample);
+
+/**
+ * @brief Sequence number the next published sample will get
+ */
+uint32_t vl53l0x_ring_head(const vl53l0x_ring_t* ring);
+
+/**
+ * @brief Copy up to max samples following reader->next_seq
+ * 
+ * @return Number of samples copied
+ */
+size_t vl53l0x_ring_read(const vl53l0x_ring_t* ring, vl53l0x_reader_t* reader,
+                         vl53l0x_measurement_t* out, size_t max);
+
+/**
+ * @brief Copy the most recent sample
+ * 
+ * @return false if nothing was published yet
+ */
+bool vl53l0x_ring_latest(const vl53l0x_ring_t* ring, vl53l0x_measurement_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VL53L0X_RING_H
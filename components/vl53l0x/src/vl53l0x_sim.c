@@ -0,0 +1,537 @@
+/**
+ * @file vl53l0x_sim.c
+ * @brief Register-level VL53L0X model: paged register file, NVM strobe,
+ *        single/back-to-back/timed ranging, stop completion and interrupt status
+ */
+
+#include "vl53l0x_sim_io.h"
+#include "vl53l0x_api.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIM_PAGES           16      // Page register values used by the ST API: 0x00, 0x01, 0x04, 0x06, 0x07, 0x0E
+#define SIM_NVM_PAGE        7       // Page on which the NVM read strobe (0x83) is active
+#define SIM_REF_SIGNAL_RATE 0x0A00  // Reference rate (9.7) matching the SPAD management target
+#define SIM_EFFECTIVE_SPADS 0x0800  // Return SPAD count (8.8)
+#define SIM_RANGE_VALID     11      // Device range status for a good sample
+#define SIM_RANGE_SIGNAL    4       // Device range status for a signal failure
+#define SIM_OUT_OF_RANGE_MM 8190
+#define SIM_NOISE_BUDGET_US 33000   // Timing budget at which config.noise_mm applies
+#define SIM_REG_STOP_STATUS 0x04    // Page 1: non-zero while a stopped sequencer finishes its sample
+
+// SYSTEM_SEQUENCE_CONFIG step enables
+#define SIM_STEP_TCC        0x10
+#define SIM_STEP_DSS        0x08
+#define SIM_STEP_MSRC       0x04
+#define SIM_STEP_PRE_RANGE  0x40
+#define SIM_STEP_FINAL_RANGE 0x80
+
+// Fixed per-step sequencer overheads
+#define SIM_START_OVERHEAD_US       1910
+#define SIM_END_OVERHEAD_US         960
+#define SIM_TCC_OVERHEAD_US         590
+#define SIM_DSS_OVERHEAD_US         690
+#define SIM_MSRC_OVERHEAD_US        660
+#define SIM_PRE_RANGE_OVERHEAD_US   660
+#define SIM_FINAL_RANGE_OVERHEAD_US 550
+
+/**
+ * @brief Simulated sensor state
+ */
+struct vl53l0x_sim_s {
+    vl53l0x_sim_config_t config;
+    VL53L0X_DEV dev;                 // Device the simulator answers for
+    uint8_t regs[SIM_PAGES][256];    // Register file, one bank per page value
+    uint8_t page;                    // Current 0xFF value
+    bool measuring;                  // A measurement is running
+    bool continuous;                 // Re-arm after each sample
+    bool timed;                      // Honour the inter-measurement period
+    bool stalled;                    // Current measurement never completes
+    int64_t next_done_us;            // Completion time of the running measurement
+    uint32_t rng;                    // Noise generator state
+    uint32_t transfers;              // For error_every_n
+    uint32_t bus_errors;             // Pending injected bus errors
+    uint32_t stalls;                 // Pending injected stalled measurements
+    uint32_t stuck_resets;           // Bus resets still needed to release SDA
+    vl53l0x_sim_stats_t stats;
+};
+
+/**
+ * @brief xorshift32 noise source (deterministic per seed)
+ */
+static uint32_t sim_rand(vl53l0x_sim_handle_t sim) {
+    uint32_t x = sim->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sim->rng = x;
+    return x;
+}
+
+static void put_u16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static uint16_t get_u16(const uint8_t* p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static void put_u32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+/**
+ * @brief NVM contents returned through the 0x94/0x83/0x90 strobe sequence
+ */
+static uint32_t nvm_read(vl53l0x_sim_handle_t sim, uint8_t addr) {
+    switch (addr) {
+        case 0x02: return 0x01000000;                  // Module ID
+        case 0x6B: return 3 << 8;                      // 3 non-aperture reference SPADs
+        case 0x24:
+        case 0x25: return 0xFFFFFFFF;                  // Good SPAD map: all good
+        case 0x7B: return sim->config.uid_upper;
+        case 0x7C: return sim->config.uid_lower;
+        default:   return 0;
+    }
+}
+
+/**
+ * @brief Power-on register values the ST API reads before writing them
+ */
+static void reset_registers(vl53l0x_sim_handle_t sim) {
+    memset(sim->regs, 0, sizeof(sim->regs));
+    sim->page = 0;
+    sim->measuring = false;
+
+    uint8_t* p0 = sim->regs[0];
+    p0[VL53L0X_REG_IDENTIFICATION_MODEL_ID] = 0xEE;
+    p0[VL53L0X_REG_IDENTIFICATION_REVISION_ID] = 0x10;
+    p0[VL53L0X_REG_SYSTEM_SEQUENCE_CONFIG] = 0xFF;
+    p0[VL53L0X_REG_SYSTEM_INTERRUPT_CONFIG_GPIO] = VL53L0X_REG_SYSTEM_INTERRUPT_GPIO_NEW_SAMPLE_READY;
+
+    // Oscillator calibration of 1: the inter-measurement register holds milliseconds
+    put_u16(&p0[VL53L0X_REG_OSC_CALIBRATE_VAL], 1);
+
+    // Reset timing: 14/10 PCLK VCSEL periods and ~30 ms of final range
+    p0[VL53L0X_REG_PRE_RANGE_CONFIG_VCSEL_PERIOD] = 6;
+    p0[VL53L0X_REG_FINAL_RANGE_CONFIG_VCSEL_PERIOD] = 4;
+    p0[VL53L0X_REG_MSRC_CONFIG_TIMEOUT_MACROP] = 0x1F;
+    put_u16(&p0[VL53L0X_REG_PRE_RANGE_CONFIG_TIMEOUT_MACROP_HI], 0x0155);
+    put_u16(&p0[VL53L0X_REG_FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI], 0x0A9D);
+
+    put_u16(&sim->regs[1][VL53L0X_REG_RESULT_PEAK_SIGNAL_RATE_REF], SIM_REF_SIGNAL_RATE);
+}
+
+/**
+ * @brief Length of one timeout step, from its macro period count and VCSEL period register
+ *
+ * Macro period: 2304 VCSEL periods of 1.655 ns PLL clocks per VCSEL PCLK.
+ */
+static uint32_t step_us(uint32_t mclks, uint8_t vcsel_reg) {
+    uint32_t pclks = ((uint32_t)vcsel_reg + 1) << 1;
+    uint32_t macro_ns = (2304 * pclks * 1655 + 500) / 1000;
+    return (mclks * macro_ns + 500) / 1000;
+}
+
+/**
+ * @brief Timeout register format: (LSByte << MSByte) + 1 macro periods
+ */
+static uint32_t decode_mclks(uint16_t encoded) {
+    return ((uint32_t)(encoded & 0xFF) << (encoded >> 8)) + 1;
+}
+
+/**
+ * @brief Measurement time programmed in the sequencer registers
+ *
+ * Sums the enabled sequence steps and their fixed overheads the way the
+ * sensor runs them, so a wrong timing register write changes the sample
+ * rate instead of going unnoticed.
+ */
+static uint32_t programmed_budget_us(vl53l0x_sim_handle_t sim) {
+    const uint8_t* p0 = sim->regs[0];
+    uint8_t steps = p0[VL53L0X_REG_SYSTEM_SEQUENCE_CONFIG];
+    uint8_t pre_vcsel = p0[VL53L0X_REG_PRE_RANGE_CONFIG_VCSEL_PERIOD];
+    uint32_t budget_us = SIM_START_OVERHEAD_US + SIM_END_OVERHEAD_US;
+
+    if (steps & (SIM_STEP_TCC | SIM_STEP_DSS | SIM_STEP_MSRC)) {
+        uint32_t msrc_us = step_us(decode_mclks(p0[VL53L0X_REG_MSRC_CONFIG_TIMEOUT_MACROP]), pre_vcsel);
+        if (steps & SIM_STEP_TCC) {
+            budget_us += msrc_us + SIM_TCC_OVERHEAD_US;
+        }
+        if (steps & SIM_STEP_DSS) {
+            budget_us += 2 * (msrc_us + SIM_DSS_OVERHEAD_US);
+        } else if (steps & SIM_STEP_MSRC) {
+            budget_us += msrc_us + SIM_MSRC_OVERHEAD_US;
+        }
+    }
+
+    uint16_t pre_mclks = 0;
+    if (steps & SIM_STEP_PRE_RANGE) {
+        pre_mclks = (uint16_t)decode_mclks(get_u16(&p0[VL53L0X_REG_PRE_RANGE_CONFIG_TIMEOUT_MACROP_HI]));
+        budget_us += step_us(pre_mclks, pre_vcsel) + SIM_PRE_RANGE_OVERHEAD_US;
+    }
+    if (steps & SIM_STEP_FINAL_RANGE) {
+        // The final range timeout register includes the pre-range macro periods
+        uint16_t final_mclks = (uint16_t)decode_mclks(get_u16(&p0[VL53L0X_REG_FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI]));
+        final_mclks -= pre_mclks;
+        budget_us += step_us(final_mclks, p0[VL53L0X_REG_FINAL_RANGE_CONFIG_VCSEL_PERIOD]) +
+                     SIM_FINAL_RANGE_OVERHEAD_US;
+    }
+    return budget_us;
+}
+
+/**
+ * @brief Time between samples in the current mode
+ */
+static int64_t sample_interval_us(vl53l0x_sim_handle_t sim) {
+    int64_t interval_us = programmed_budget_us(sim);
+
+    if (sim->timed) {
+        const uint8_t* p = &sim->regs[0][VL53L0X_REG_SYSTEM_INTERMEASUREMENT_PERIOD];
+        uint32_t period_ms = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+        if ((int64_t)period_ms * 1000 > interval_us) {
+            interval_us = (int64_t)period_ms * 1000;
+        }
+    }
+    return interval_us;
+}
+
+/**
+ * @brief Whether a finished sample raises the interrupt, per the GPIO configuration
+ */
+static bool interrupt_condition(vl53l0x_sim_handle_t sim, uint16_t range_mm) {
+    const uint8_t* p0 = sim->regs[0];
+    uint32_t low_mm = (((uint32_t)p0[VL53L0X_REG_SYSTEM_THRESH_LOW] << 8) | p0[VL53L0X_REG_SYSTEM_THRESH_LOW + 1]) * 2;
+    uint32_t high_mm = (((uint32_t)p0[VL53L0X_REG_SYSTEM_THRESH_HIGH] << 8) | p0[VL53L0X_REG_SYSTEM_THRESH_HIGH + 1]) * 2;
+
+    switch (p0[VL53L0X_REG_SYSTEM_INTERRUPT_CONFIG_GPIO] & 0x07) {
+        case VL53L0X_REG_SYSTEM_INTERRUPT_GPIO_LEVEL_LOW:       return range_mm < low_mm;
+        case VL53L0X_REG_SYSTEM_INTERRUPT_GPIO_LEVEL_HIGH:      return range_mm > high_mm;
+        case VL53L0X_REG_SYSTEM_INTERRUPT_GPIO_OUT_OF_WINDOW:   return range_mm < low_mm || range_mm > high_mm;
+        case VL53L0X_REG_SYSTEM_INTERRUPT_GPIO_NEW_SAMPLE_READY: return true;
+        default:                                                return false;
+    }
+}
+
+/**
+ * @brief Fill the result block for a finished measurement
+ */
+static void complete_sample(vl53l0x_sim_handle_t sim, int64_t done_us) {
+    const vl53l0x_sim_config_t* cfg = &sim->config;
+    int32_t range = cfg->range_fn ? cfg->range_fn(done_us, cfg->range_user_data) : cfg->distance_mm;
+    uint8_t status = SIM_RANGE_VALID;
+
+    uint32_t noise_mm = cfg->noise_mm;
+    uint32_t budget_us = programmed_budget_us(sim);
+    if (noise_mm) {
+        // Shot noise: the spread grows with 1/sqrt(integration time)
+        noise_mm = (uint32_t)(noise_mm * sqrtf((float)SIM_NOISE_BUDGET_US / (float)budget_us) + 0.5f);
+    }
+    if (noise_mm) {
+        range += (int32_t)(sim_rand(sim) % (noise_mm + 1u)) - (int32_t)(noise_mm / 2);
+    }
+    float signal_rate = cfg->signal_rate_mcps;
+    if (cfg->outlier_per_mille && sim_rand(sim) % 1000 < cfg->outlier_per_mille) {
+        // Spurious return (multipath, ambient): anywhere in range, weak
+        range = (int32_t)(sim_rand(sim) % (cfg->max_range_mm + 1u));
+        signal_rate /= 4.0f;
+    }
+    if (range < 0) {
+        range = 0;
+    }
+    if (range > cfg->max_range_mm) {
+        range = SIM_OUT_OF_RANGE_MM;
+        status = SIM_RANGE_SIGNAL;
+    }
+
+    uint8_t* r = &sim->regs[0][VL53L0X_REG_RESULT_RANGE_STATUS];
+    memset(r, 0, 12);
+    r[0] = (uint8_t)((status << 3) | 0x01);
+    put_u16(&r[2], SIM_EFFECTIVE_SPADS);
+    put_u16(&r[6], (uint16_t)(signal_rate * 128.0f));
+    put_u16(&r[8], (uint16_t)(cfg->ambient_rate_mcps * 128.0f));
+    put_u16(&r[10], (uint16_t)range);
+
+    if (interrupt_condition(sim, (uint16_t)range)) {
+        sim->regs[0][VL53L0X_REG_RESULT_INTERRUPT_STATUS] =
+            sim->regs[0][VL53L0X_REG_SYSTEM_INTERRUPT_CONFIG_GPIO] & 0x07;
+    }
+    sim->stats.samples++;
+}
+
+/**
+ * @brief Advance the measurement state machine to the current time
+ */
+static void update(vl53l0x_sim_handle_t sim) {
+    if (!sim->measuring || sim->stalled) {
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+    if (now < sim->next_done_us) {
+        return;
+    }
+
+    if (!sim->continuous) {
+        sim->measuring = false;
+        complete_sample(sim, sim->next_done_us);
+        return;
+    }
+
+    // Samples the host was too slow to read are overwritten, as on the sensor
+    int64_t interval_us = sample_interval_us(sim);
+    if (interval_us <= 0) {
+        interval_us = 1;
+    }
+    while (sim->next_done_us + interval_us <= now) {
+        sim->next_done_us += interval_us;
+    }
+    complete_sample(sim, sim->next_done_us);
+    sim->next_done_us += interval_us;
+}
+
+/**
+ * @brief SYSRANGE_START write: start or stop ranging
+ */
+static void sysrange_start(vl53l0x_sim_handle_t sim, uint8_t value) {
+    if ((value & VL53L0X_REG_SYSRANGE_MODE_MASK) == VL53L0X_REG_SYSRANGE_MODE_SINGLESHOT) {
+        // Stop: the sample in progress still completes, only idle time is cut short
+        uint32_t budget_us = programmed_budget_us(sim);
+        if (sim->stalled || esp_timer_get_time() < sim->next_done_us - budget_us) {
+            sim->measuring = false;
+        }
+        sim->continuous = false;
+        return;
+    }
+
+    sim->continuous = (value & (VL53L0X_REG_SYSRANGE_MODE_BACKTOBACK | VL53L0X_REG_SYSRANGE_MODE_TIMED)) != 0;
+    sim->timed = (value & VL53L0X_REG_SYSRANGE_MODE_TIMED) != 0;
+    sim->measuring = true;
+    sim->stalled = false;
+    if (sim->stalls > 0) {
+        sim->stalls--;
+        sim->stalled = true;
+    }
+    sim->stats.measurement_us = programmed_budget_us(sim);
+    sim->next_done_us = esp_timer_get_time() + sample_interval_us(sim);
+
+    // Start bit self-clears once the sequencer has taken the command
+    sim->regs[0][VL53L0X_REG_SYSRANGE_START] = value & ~VL53L0X_REG_SYSRANGE_MODE_START_STOP;
+}
+
+/**
+ * @brief Apply the side effects of one register write
+ */
+static void write_register(vl53l0x_sim_handle_t sim, uint8_t index, uint8_t value) {
+    if (index == 0xFF) {
+        sim->page = value % SIM_PAGES;
+        return;
+    }
+
+    sim->regs[sim->page][index] = value;
+
+    if (sim->page == SIM_NVM_PAGE && index == 0x83 && value == 0x00) {
+        // NVM read strobe: data for the address in 0x94 appears at 0x90
+        put_u32(&sim->regs[SIM_NVM_PAGE][0x90], nvm_read(sim, sim->regs[SIM_NVM_PAGE][0x94]));
+        sim->regs[SIM_NVM_PAGE][0x83] = 0x01;
+        return;
+    }
+
+    if (sim->page != 0) {
+        return;
+    }
+
+    switch (index) {
+        case VL53L0X_REG_SYSRANGE_START:
+            sysrange_start(sim, value);
+            break;
+        case VL53L0X_REG_SYSTEM_INTERRUPT_CLEAR:
+            if (value & 0x03) {
+                sim->regs[0][VL53L0X_REG_RESULT_INTERRUPT_STATUS] = 0;
+                sim->regs[0][VL53L0X_REG_RESULT_RANGE_STATUS] &= ~0x01;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Count a transfer and decide whether it fails
+ */
+static esp_err_t account(vl53l0x_sim_handle_t sim, uint32_t wire_bytes, bool read, int timeout_ms) {
+    uint32_t khz = (sim->dev && sim->dev->comms_speed_khz) ? sim->dev->comms_speed_khz : 400;
+
+    if (read) {
+        sim->stats.reads++;
+    } else {
+        sim->stats.writes++;
+    }
+    sim->stats.bytes += wire_bytes;
+    // 9 clocks per byte plus start and stop conditions
+    sim->stats.bus_us += ((uint64_t)wire_bytes * 9 + 2) * 1000 / khz;
+
+    if (sim->stuck_resets > 0) {
+        // Nothing moves on the bus: the transfer only ends at the host's deadline
+        esp_rom_delay_us((uint32_t)timeout_ms * 1000);
+        sim->stats.faults++;
+        return ESP_ERR_TIMEOUT;
+    }
+
+    sim->transfers++;
+    if (sim->bus_errors > 0 ||
+        (sim->config.error_every_n && sim->transfers % sim->config.error_every_n == 0)) {
+        if (sim->bus_errors > 0) {
+            sim->bus_errors--;
+        }
+        sim->stats.faults++;
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t vl53l0x_sim_write(vl53l0x_sim_handle_t sim, const uint8_t* buf, uint32_t len, int timeout_ms) {
+    if (!sim || !buf || len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Address byte + index + payload
+    esp_err_t ret = account(sim, len + 1, false, timeout_ms);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    update(sim);
+
+    // The index auto-increments across the payload
+    uint8_t index = buf[0];
+    for (uint32_t i = 1; i < len; i++) {
+        write_register(sim, index++, buf[i]);
+    }
+    return ESP_OK;
+}
+
+esp_err_t vl53l0x_sim_read(vl53l0x_sim_handle_t sim, uint8_t index, uint8_t* data, uint32_t len,
+                           int timeout_ms) {
+    if (!sim || !data) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Address + index, repeated start, address + data
+    esp_err_t ret = account(sim, len + 3, true, timeout_ms);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    update(sim);
+    sim->regs[1][SIM_REG_STOP_STATUS] = sim->measuring ? 0x01 : 0x00;
+
+    for (uint32_t i = 0; i < len; i++) {
+        data[i] = sim->regs[sim->page][(uint8_t)(index + i)];
+    }
+    return ESP_OK;
+}
+
+void vl53l0x_sim_bus_reset(vl53l0x_sim_handle_t sim) {
+    if (!sim) {
+        return;
+    }
+
+    sim->stats.bus_resets++;
+    if (sim->stuck_resets > 0) {
+        sim->stuck_resets--;
+    }
+}
+
+esp_err_t vl53l0x_sim_attach(vl53l0x_sim_handle_t sim, VL53L0X_DEV dev) {
+    if (!sim || !dev) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (sim->dev) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    sim->dev = dev;
+    reset_registers(sim);
+    return ESP_OK;
+}
+
+void vl53l0x_sim_detach(vl53l0x_sim_handle_t sim) {
+    if (sim) {
+        sim->dev = NULL;
+    }
+}
+
+esp_err_t vl53l0x_sim_create(const vl53l0x_sim_config_t* config, vl53l0x_sim_handle_t* sim) {
+    if (!config || !sim) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *sim = (vl53l0x_sim_handle_t)calloc(1, sizeof(struct vl53l0x_sim_s));
+    if (!*sim) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    (*sim)->config = *config;
+    (*sim)->rng = config->seed ? config->seed : 1;
+    reset_registers(*sim);
+
+    return ESP_OK;
+}
+
+void vl53l0x_sim_set_distance(vl53l0x_sim_handle_t sim, uint16_t distance_mm) {
+    if (sim) {
+        sim->config.distance_mm = distance_mm;
+    }
+}
+
+void vl53l0x_sim_inject_fault(vl53l0x_sim_handle_t sim, vl53l0x_sim_fault_t fault, uint32_t count) {
+    if (!sim) {
+        return;
+    }
+
+    switch (fault) {
+        case VL53L0X_SIM_FAULT_BUS_ERROR:
+            sim->bus_errors = count;
+            break;
+        case VL53L0X_SIM_FAULT_NO_COMPLETION:
+            sim->stalls = count;
+            break;
+        case VL53L0X_SIM_FAULT_BUS_STUCK:
+            sim->stuck_resets = count;
+            break;
+        case VL53L0X_SIM_FAULT_NONE:
+        default:
+            sim->bus_errors = 0;
+            sim->stalls = 0;
+            sim->stuck_resets = 0;
+            sim->stalled = false;
+            break;
+    }
+}
+
+esp_err_t vl53l0x_sim_get_stats(vl53l0x_sim_handle_t sim, vl53l0x_sim_stats_t* stats) {
+    if (!sim || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *stats = sim->stats;
+    return ESP_OK;
+}
+
+void vl53l0x_sim_reset_stats(vl53l0x_sim_handle_t sim) {
+    if (sim) {
+        memset(&sim->stats, 0, sizeof(sim->stats));
+    }
+}
+
+void vl53l0x_sim_delete(vl53l0x_sim_handle_t sim) {
+    free(sim);
+}
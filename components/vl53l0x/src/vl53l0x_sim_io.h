@@ -0,0 +1,54 @@
+/**
+ * @file vl53l0x_sim_io.h
+ * @brief Internal hooks between the platform layer and the simulator
+ */
+
+#ifndef VL53L0X_SIM_IO_H
+#define VL53L0X_SIM_IO_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "vl53l0x_sim.h"
+#include "vl53l0x_platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Bind a simulator to the ST device it answers for
+ *
+ * The device supplies the I2C speed used for the bus time model; the
+ * measurement timing comes from the registers the driver programs.
+ */
+esp_err_t vl53l0x_sim_attach(vl53l0x_sim_handle_t sim, VL53L0X_DEV dev);
+
+/**
+ * @brief Release a simulator from its device
+ */
+void vl53l0x_sim_detach(vl53l0x_sim_handle_t sim);
+
+/**
+ * @brief Write transfer: register index followed by the payload
+ *
+ * A stuck bus blocks for timeout_ms and returns ESP_ERR_TIMEOUT, like the
+ * I2C driver.
+ */
+esp_err_t vl53l0x_sim_write(vl53l0x_sim_handle_t sim, const uint8_t* buf, uint32_t len, int timeout_ms);
+
+/**
+ * @brief Read transfer starting at a register index
+ */
+esp_err_t vl53l0x_sim_read(vl53l0x_sim_handle_t sim, uint8_t index, uint8_t* data, uint32_t len,
+                           int timeout_ms);
+
+/**
+ * @brief Bus recovery (SCL toggling) as seen by the simulated sensor
+ */
+void vl53l0x_sim_bus_reset(vl53l0x_sim_handle_t sim);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VL53L0X_SIM_IO_H
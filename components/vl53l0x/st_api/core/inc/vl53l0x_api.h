@@ -99,6 +99,7 @@ VL53L0X_API VL53L0X_Error VL53L0X_GetPalSpecVersion(
 VL53L0X_API VL53L0X_Error VL53L0X_GetProductRevision(VL53L0X_DEV Dev,
 	uint8_t *pProductRevisionMajor, uint8_t *pProductRevisionMinor);
 
+#ifndef VL53L0X_LEAN
 /**
  * @brief Reads the Device information for given Device
  *
@@ -112,6 +113,7 @@ VL53L0X_API VL53L0X_Error VL53L0X_GetProductRevision(VL53L0X_DEV Dev,
  */
 VL53L0X_API VL53L0X_Error VL53L0X_GetDeviceInfo(VL53L0X_DEV Dev,
 	VL53L0X_DeviceInfo_t *pVL53L0X_DeviceInfo);
+#endif /* VL53L0X_LEAN */
 
 /**
  * @brief Read current status of the error register for the selected device
@@ -126,6 +128,7 @@ VL53L0X_API VL53L0X_Error VL53L0X_GetDeviceInfo(VL53L0X_DEV Dev,
 VL53L0X_API VL53L0X_Error VL53L0X_GetDeviceErrorStatus(VL53L0X_DEV Dev,
 	VL53L0X_DeviceError * pDeviceErrorStatus);
 
+#ifndef VL53L0X_LEAN
 /**
  * @brief Human readable Range Status string for a given RangeStatus
  *
@@ -180,6 +183,7 @@ VL53L0X_API VL53L0X_Error VL53L0X_GetPalErrorString(VL53L0X_Error PalErrorCode,
  */
 VL53L0X_API VL53L0X_Error VL53L0X_GetPalStateString(VL53L0X_State PalStateCode,
 	char *pPalStateString);
+#endif /* VL53L0X_LEAN */
 
 /**
  * @brief Reads the internal state of the PAL for a given Device
@@ -611,6 +615,7 @@ VL53L0X_API VL53L0X_Error VL53L0X_SetRangeFractionEnable(VL53L0X_DEV Dev,
 VL53L0X_API VL53L0X_Error VL53L0X_GetFractionEnable(VL53L0X_DEV Dev,
 	uint8_t *pEnable);
 
+#ifndef VL53L0X_LEAN
 /**
  * @brief  Set a new Histogram mode
  * @par Function Description
@@ -655,6 +660,7 @@ VL53L0X_API VL53L0X_Error VL53L0X_SetHistogramMode(VL53L0X_DEV Dev,
  */
 VL53L0X_API VL53L0X_Error VL53L0X_GetHistogramMode(VL53L0X_DEV Dev,
 	VL53L0X_HistogramModes * pHistogramMode);
+#endif /* VL53L0X_LEAN */
 
 /**
  * @brief Set Ranging Timing Budget in microseconds
@@ -852,6 +858,7 @@ VL53L0X_API VL53L0X_Error VL53L0X_GetSequenceStepTimeout(VL53L0X_DEV Dev,
 VL53L0X_API VL53L0X_Error VL53L0X_GetNumberOfSequenceSteps(VL53L0X_DEV Dev,
 	uint8_t *pNumberOfSequenceSteps);
 
+#ifndef VL53L0X_LEAN
 /**
  * @brief Gets the name of a given sequence step.
  *
@@ -869,6 +876,7 @@ VL53L0X_API VL53L0X_Error VL53L0X_GetNumberOfSequenceSteps(VL53L0X_DEV Dev,
  */
 VL53L0X_API VL53L0X_Error VL53L0X_GetSequenceStepsInfo(
 	VL53L0X_SequenceStepId SequenceStepId, char *pSequenceStepsString);
+#endif /* VL53L0X_LEAN */
 
 /**
  * Program continuous mode Inter-Measurement period in milliseconds
@@ -1018,6 +1026,7 @@ VL53L0X_API VL53L0X_Error VL53L0X_GetRefCalibration(VL53L0X_DEV Dev,
 VL53L0X_API VL53L0X_Error VL53L0X_GetNumberOfLimitCheck(
 	uint16_t *pNumberOfLimitCheck);
 
+#ifndef VL53L0X_LEAN
 /**
  * @brief  Return a description string for a given limit check number
  *
@@ -1039,6 +1048,7 @@ VL53L0X_API VL53L0X_Error VL53L0X_GetNumberOfLimitCheck(
  */
 VL53L0X_API VL53L0X_Error VL53L0X_GetLimitCheckInfo(VL53L0X_DEV Dev,
 	uint16_t LimitCheckId, char *pLimitCheckString);
+#endif /* VL53L0X_LEAN */
 
 /**
  * @brief  Return a the Status of the specified check limit
@@ -1475,6 +1485,29 @@ VL53L0X_API VL53L0X_Error VL53L0X_GetMeasurementRefSignal(VL53L0X_DEV Dev,
 VL53L0X_API VL53L0X_Error VL53L0X_GetRangingMeasurementData(VL53L0X_DEV Dev,
 	VL53L0X_RangingMeasurementData_t *pRangingMeasurementData);
 
+/**
+ * @brief Check for and retrieve a ranging measurement in one transfer
+ *
+ * @par Function Description
+ * Steady-state ranging path. Reads the interrupt status together with
+ * the result block, and when a sample is ready decodes it like
+ * @a VL53L0X_GetRangingMeasurementData() and clears the interrupt
+ * without the read back done by @a VL53L0X_ClearInterruptMask().
+ * Sigma and limit checks are only evaluated when enabled.
+ *
+ * @note This function Access to the device
+ *
+ * @param   Dev                      Device Handle
+ * @param   pMeasurementDataReady    Set to 1 when a sample was retrieved.
+ * @param   pRangingMeasurementData  Pointer to the data structure to fill up.
+ * @return  VL53L0X_ERROR_NONE        Success
+ * @return  "Other error code"       See ::VL53L0X_Error
+ */
+VL53L0X_API VL53L0X_Error VL53L0X_GetRangingMeasurementDataFast(VL53L0X_DEV Dev,
+	uint8_t *pMeasurementDataReady,
+	VL53L0X_RangingMeasurementData_t *pRangingMeasurementData);
+
+#ifndef VL53L0X_LEAN
 /**
  * @brief Retrieve the measurements from device for a given setup
  *
@@ -1493,6 +1526,7 @@ VL53L0X_API VL53L0X_Error VL53L0X_GetRangingMeasurementData(VL53L0X_DEV Dev,
  */
 VL53L0X_API VL53L0X_Error VL53L0X_GetHistogramMeasurementData(VL53L0X_DEV Dev,
 	VL53L0X_HistogramMeasurementData_t *pHistogramMeasurementData);
+#endif /* VL53L0X_LEAN */
 
 /**
  * @brief Performs a single ranging measurement and retrieve the ranging
@@ -1520,6 +1554,7 @@ VL53L0X_API VL53L0X_Error VL53L0X_PerformSingleRangingMeasurement(
 	VL53L0X_DEV Dev,
 	VL53L0X_RangingMeasurementData_t *pRangingMeasurementData);
 
+#ifndef VL53L0X_LEAN
 /**
  * @brief Performs a single histogram measurement and retrieve the histogram
  * measurement data
@@ -1593,6 +1628,7 @@ VL53L0X_API VL53L0X_Error VL53L0X_GetNumberOfROIZones(VL53L0X_DEV Dev,
  */
 VL53L0X_API VL53L0X_Error VL53L0X_GetMaxNumberOfROIZones(VL53L0X_DEV Dev,
 	uint8_t *pMaxNumberOfROIZones);
+#endif /* VL53L0X_LEAN */
 
 /** @} VL53L0X_measurement_group */
 
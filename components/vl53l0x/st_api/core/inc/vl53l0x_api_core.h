@@ -52,6 +52,10 @@ uint32_t VL53L0X_quadrature_sum(uint32_t a, uint32_t b);
 
 VL53L0X_Error VL53L0X_get_info_from_device(VL53L0X_DEV Dev, uint8_t option);
 
+#ifndef VL53L0X_LEAN
+VL53L0X_Error VL53L0X_get_product_id(VL53L0X_DEV Dev, char *pProductId);
+#endif /* VL53L0X_LEAN */
+
 VL53L0X_Error VL53L0X_set_vcsel_pulse_period(VL53L0X_DEV Dev,
 	VL53L0X_VcselPeriod VcselPeriodType, uint8_t VCSELPulsePeriodPCLK);
 
@@ -438,8 +438,6 @@ typedef struct {
 	uint8_t ReadDataFromDeviceDone;
 	uint8_t ModuleId; /* Module ID */
 	uint8_t Revision; /* test Revision */
-	char ProductId[VL53L0X_MAX_STRING_LENGTH];
-		/* Product Identifier String  */
 	uint8_t ReferenceSpadCount; /* used for ref spad management */
 	uint8_t ReferenceSpadType;	/* used for ref spad management */
 	uint8_t RefSpadsInitialised; /* reports if ref spads are initialised. */
@@ -467,8 +465,6 @@ typedef struct {
 	/*!< Current Device Parameter */
 	VL53L0X_RangingMeasurementData_t LastRangeMeasure;
 	/*!< Ranging Data */
-	VL53L0X_HistogramMeasurementData_t LastHistogramMeasure;
-	/*!< Histogram Data */
 	VL53L0X_DeviceSpecificParameters_t DeviceSpecificParameters;
 	/*!< Parameters specific to the device */
 	VL53L0X_SpadData_t SpadData;
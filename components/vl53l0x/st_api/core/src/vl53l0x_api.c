@@ -31,7 +31,9 @@
 #include "vl53l0x_interrupt_threshold_settings.h"
 #include "vl53l0x_api_core.h"
 #include "vl53l0x_api_calibration.h"
+#ifndef VL53L0X_LEAN
 #include "vl53l0x_api_strings.h"
+#endif /* VL53L0X_LEAN */
 
 #ifndef __KERNEL__
 #include <stdlib.h>
@@ -100,6 +102,7 @@ VL53L0X_Error VL53L0X_GetProductRevision(VL53L0X_DEV Dev,
 
 }
 
+#ifndef VL53L0X_LEAN
 VL53L0X_Error VL53L0X_GetDeviceInfo(VL53L0X_DEV Dev,
 	VL53L0X_DeviceInfo_t *pVL53L0X_DeviceInfo)
 {
@@ -112,6 +115,7 @@ VL53L0X_Error VL53L0X_GetDeviceInfo(VL53L0X_DEV Dev,
 	LOG_FUNCTION_END(Status);
 	return Status;
 }
+#endif /* VL53L0X_LEAN */
 
 VL53L0X_Error VL53L0X_GetDeviceErrorStatus(VL53L0X_DEV Dev,
 	VL53L0X_DeviceError *pDeviceErrorStatus)
@@ -131,6 +135,7 @@ VL53L0X_Error VL53L0X_GetDeviceErrorStatus(VL53L0X_DEV Dev,
 }
 
 
+#ifndef VL53L0X_LEAN
 VL53L0X_Error VL53L0X_GetDeviceErrorString(VL53L0X_DeviceError ErrorCode,
 	char *pDeviceErrorString)
 {
@@ -183,6 +188,7 @@ VL53L0X_Error VL53L0X_GetPalStateString(VL53L0X_State PalStateCode,
 	LOG_FUNCTION_END(Status);
 	return Status;
 }
+#endif /* VL53L0X_LEAN */
 
 VL53L0X_Error VL53L0X_GetPalState(VL53L0X_DEV Dev, VL53L0X_State *pPalState)
 {
@@ -1027,6 +1033,7 @@ VL53L0X_Error VL53L0X_GetFractionEnable(VL53L0X_DEV Dev, uint8_t *pEnabled)
 	return Status;
 }
 
+#ifndef VL53L0X_LEAN
 VL53L0X_Error VL53L0X_SetHistogramMode(VL53L0X_DEV Dev,
 	VL53L0X_HistogramModes HistogramMode)
 {
@@ -1052,6 +1059,7 @@ VL53L0X_Error VL53L0X_GetHistogramMode(VL53L0X_DEV Dev,
 	LOG_FUNCTION_END(Status);
 	return Status;
 }
+#endif /* VL53L0X_LEAN */
 
 VL53L0X_Error VL53L0X_SetMeasurementTimingBudgetMicroSeconds(VL53L0X_DEV Dev,
 	uint32_t MeasurementTimingBudgetMicroSeconds)
@@ -1306,6 +1314,7 @@ VL53L0X_Error VL53L0X_GetNumberOfSequenceSteps(VL53L0X_DEV Dev,
 	return Status;
 }
 
+#ifndef VL53L0X_LEAN
 VL53L0X_Error VL53L0X_GetSequenceStepsInfo(
 	VL53L0X_SequenceStepId SequenceStepId,
 	char *pSequenceStepsString)
@@ -1322,6 +1331,7 @@ VL53L0X_Error VL53L0X_GetSequenceStepsInfo(
 
 	return Status;
 }
+#endif /* VL53L0X_LEAN */
 
 VL53L0X_Error VL53L0X_SetSequenceStepTimeout(VL53L0X_DEV Dev,
 	VL53L0X_SequenceStepId SequenceStepId, FixPoint1616_t TimeOutMilliSecs)
@@ -1633,6 +1643,7 @@ VL53L0X_Error VL53L0X_GetNumberOfLimitCheck(uint16_t *pNumberOfLimitCheck)
 	return Status;
 }
 
+#ifndef VL53L0X_LEAN
 VL53L0X_Error VL53L0X_GetLimitCheckInfo(VL53L0X_DEV Dev, uint16_t LimitCheckId,
 	char *pLimitCheckString)
 {
@@ -1646,6 +1657,7 @@ VL53L0X_Error VL53L0X_GetLimitCheckInfo(VL53L0X_DEV Dev, uint16_t LimitCheckId,
 	LOG_FUNCTION_END(Status);
 	return Status;
 }
+#endif /* VL53L0X_LEAN */
 
 VL53L0X_Error VL53L0X_GetLimitCheckStatus(VL53L0X_DEV Dev,
 	uint16_t LimitCheckId,
@@ -2133,6 +2145,7 @@ VL53L0X_Error VL53L0X_PerformSingleMeasurement(VL53L0X_DEV Dev)
 	return Status;
 }
 
+#ifndef VL53L0X_LEAN
 VL53L0X_Error VL53L0X_PerformSingleHistogramMeasurement(VL53L0X_DEV Dev,
 	VL53L0X_HistogramMeasurementData_t *pHistogramMeasurementData)
 {
@@ -2145,6 +2158,7 @@ VL53L0X_Error VL53L0X_PerformSingleHistogramMeasurement(VL53L0X_DEV Dev,
 	LOG_FUNCTION_END(Status);
 	return Status;
 }
+#endif /* VL53L0X_LEAN */
 
 VL53L0X_Error VL53L0X_PerformRefCalibration(VL53L0X_DEV Dev,
 	uint8_t *pVhvSettings,
@@ -2442,7 +2456,8 @@ VL53L0X_Error VL53L0X_WaitDeviceReadyForNewMeasurement(VL53L0X_DEV Dev,
 }
 
 
-VL53L0X_Error VL53L0X_GetRangingMeasurementData(VL53L0X_DEV Dev,
+static VL53L0X_Error decode_ranging_measurement(VL53L0X_DEV Dev,
+	const uint8_t *localBuffer,
 	VL53L0X_RangingMeasurementData_t *pRangingMeasurementData)
 {
 	VL53L0X_Error Status = VL53L0X_ERROR_NONE;
@@ -2457,19 +2472,11 @@ VL53L0X_Error VL53L0X_GetRangingMeasurementData(VL53L0X_DEV Dev,
 	uint16_t tmpuint16;
 	uint16_t XtalkRangeMilliMeter;
 	uint16_t LinearityCorrectiveGain;
-	uint8_t localBuffer[12];
 	VL53L0X_RangingMeasurementData_t LastRangeDataBuffer;
 
 	LOG_FUNCTION_START("");
 
-	/*
-	 * use multi read even if some registers are not useful, result will
-	 * be more efficient
-	 * start reading at 0x14 dec20
-	 * end reading at 0x21 dec33 total 14 bytes to read
-	 */
-	Status = VL53L0X_ReadMulti(Dev, 0x14, localBuffer, 12);
-
+	/* localBuffer holds the 12 result registers starting at 0x14 */
 	if (Status == VL53L0X_ERROR_NONE) {
 
 		pRangingMeasurementData->ZoneId = 0; /* Only one zone */
@@ -2600,6 +2607,86 @@ VL53L0X_Error VL53L0X_GetRangingMeasurementData(VL53L0X_DEV Dev,
 	return Status;
 }
 
+VL53L0X_Error VL53L0X_GetRangingMeasurementData(VL53L0X_DEV Dev,
+	VL53L0X_RangingMeasurementData_t *pRangingMeasurementData)
+{
+	VL53L0X_Error Status = VL53L0X_ERROR_NONE;
+	uint8_t localBuffer[12];
+
+	LOG_FUNCTION_START("");
+
+	/*
+	 * use multi read even if some registers are not useful, result will
+	 * be more efficient
+	 * start reading at 0x14 dec20
+	 * end reading at 0x21 dec33 total 14 bytes to read
+	 */
+	Status = VL53L0X_ReadMulti(Dev, 0x14, localBuffer, 12);
+
+	if (Status == VL53L0X_ERROR_NONE)
+		Status = decode_ranging_measurement(Dev, localBuffer,
+			pRangingMeasurementData);
+
+	LOG_FUNCTION_END(Status);
+	return Status;
+}
+
+VL53L0X_Error VL53L0X_GetRangingMeasurementDataFast(VL53L0X_DEV Dev,
+	uint8_t *pMeasurementDataReady,
+	VL53L0X_RangingMeasurementData_t *pRangingMeasurementData)
+{
+	VL53L0X_Error Status = VL53L0X_ERROR_NONE;
+	uint8_t InterruptConfig;
+	uint8_t localBuffer[13];
+
+	LOG_FUNCTION_START("");
+
+	/*
+	 * Interrupt status (0x13) directly precedes the result block, so a
+	 * single read answers "data ready" and fetches the sample.
+	 */
+	Status = VL53L0X_ReadMulti(Dev, VL53L0X_REG_RESULT_INTERRUPT_STATUS,
+		localBuffer, 13);
+
+	if (Status == VL53L0X_ERROR_NONE) {
+		InterruptConfig = VL53L0X_GETDEVICESPECIFICPARAMETER(Dev,
+			Pin0GpioFunctionality);
+
+		/*
+		 * The interrupt error bits (0x18) are not checked: failing
+		 * here would leave the interrupt set and the sample unread.
+		 * Range status in the result block still reports the error.
+		 */
+		if (InterruptConfig ==
+			VL53L0X_REG_SYSTEM_INTERRUPT_GPIO_NEW_SAMPLE_READY) {
+			*pMeasurementDataReady = ((localBuffer[0] & 0x07) ==
+			VL53L0X_REG_SYSTEM_INTERRUPT_GPIO_NEW_SAMPLE_READY);
+		} else {
+			*pMeasurementDataReady = localBuffer[1] & 0x01;
+		}
+	}
+
+	if ((Status == VL53L0X_ERROR_NONE) && *pMeasurementDataReady) {
+		Status = decode_ranging_measurement(Dev, &localBuffer[1],
+			pRangingMeasurementData);
+
+		/*
+		 * Clear without the read back done by
+		 * VL53L0X_ClearInterruptMask(): an interrupt that failed to
+		 * clear is seen by the next call as an early ready flag.
+		 */
+		if (Status == VL53L0X_ERROR_NONE)
+			Status = VL53L0X_WrByte(Dev,
+				VL53L0X_REG_SYSTEM_INTERRUPT_CLEAR, 0x01);
+		if (Status == VL53L0X_ERROR_NONE)
+			Status = VL53L0X_WrByte(Dev,
+				VL53L0X_REG_SYSTEM_INTERRUPT_CLEAR, 0x00);
+	}
+
+	LOG_FUNCTION_END(Status);
+	return Status;
+}
+
 VL53L0X_Error VL53L0X_GetMeasurementRefSignal(VL53L0X_DEV Dev,
 	FixPoint1616_t *pMeasurementRefSignal)
 {
@@ -2621,6 +2708,7 @@ VL53L0X_Error VL53L0X_GetMeasurementRefSignal(VL53L0X_DEV Dev,
 	return Status;
 }
 
+#ifndef VL53L0X_LEAN
 VL53L0X_Error VL53L0X_GetHistogramMeasurementData(VL53L0X_DEV Dev,
 	VL53L0X_HistogramMeasurementData_t *pHistogramMeasurementData)
 {
@@ -2631,6 +2719,7 @@ VL53L0X_Error VL53L0X_GetHistogramMeasurementData(VL53L0X_DEV Dev,
 	LOG_FUNCTION_END(Status);
 	return Status;
 }
+#endif /* VL53L0X_LEAN */
 
 VL53L0X_Error VL53L0X_PerformSingleRangingMeasurement(VL53L0X_DEV Dev,
 	VL53L0X_RangingMeasurementData_t *pRangingMeasurementData)
@@ -2661,6 +2750,7 @@ VL53L0X_Error VL53L0X_PerformSingleRangingMeasurement(VL53L0X_DEV Dev,
 	return Status;
 }
 
+#ifndef VL53L0X_LEAN
 VL53L0X_Error VL53L0X_SetNumberOfROIZones(VL53L0X_DEV Dev,
 	uint8_t NumberOfROIZones)
 {
@@ -2701,6 +2791,7 @@ VL53L0X_Error VL53L0X_GetMaxNumberOfROIZones(VL53L0X_DEV Dev,
 	LOG_FUNCTION_END(Status);
 	return Status;
 }
+#endif /* VL53L0X_LEAN */
 
 /* End Group PAL Measurement Functions */
 
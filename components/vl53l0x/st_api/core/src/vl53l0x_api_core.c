@@ -120,34 +120,59 @@ uint8_t VL53L0X_encode_vcsel_period(uint8_t vcsel_period_pclks)
 }
 
 
+/*
+ * sqrt((i + 64.5) << 24) >> 8 (capped at 255): the top byte of the square
+ * root of a value normalised to [2^30, 2^32), indexed by its top byte - 64.
+ */
+static const uint8_t isqrt_seed[192] = {
+	128, 129, 130, 131, 132, 133, 134, 135, 136, 137, 138, 139,
+	139, 140, 141, 142, 143, 144, 145, 146, 147, 147, 148, 149,
+	150, 151, 152, 153, 153, 154, 155, 156, 157, 157, 158, 159,
+	160, 161, 161, 162, 163, 164, 165, 165, 166, 167, 168, 168,
+	169, 170, 171, 171, 172, 173, 174, 174, 175, 176, 177, 177,
+	178, 179, 179, 180, 181, 182, 182, 183, 184, 184, 185, 186,
+	186, 187, 188, 188, 189, 190, 190, 191, 192, 192, 193, 194,
+	194, 195, 196, 196, 197, 198, 198, 199, 200, 200, 201, 202,
+	202, 203, 203, 204, 205, 205, 206, 207, 207, 208, 208, 209,
+	210, 210, 211, 211, 212, 213, 213, 214, 214, 215, 216, 216,
+	217, 217, 218, 219, 219, 220, 220, 221, 221, 222, 223, 223,
+	224, 224, 225, 225, 226, 227, 227, 228, 228, 229, 229, 230,
+	231, 231, 232, 232, 233, 233, 234, 234, 235, 235, 236, 237,
+	237, 238, 238, 239, 239, 240, 240, 241, 241, 242, 242, 243,
+	243, 244, 245, 245, 246, 246, 247, 247, 248, 248, 249, 249,
+	250, 250, 251, 251, 252, 252, 253, 253, 254, 254, 255, 255,
+};
+
 uint32_t VL53L0X_isqrt(uint32_t num)
 {
 	/*
-	 * Implements an integer square root
+	 * Implements an integer square root: floor(sqrt(num))
 	 *
-	 * From: http://en.wikipedia.org/wiki/Methods_of_computing_square_roots
+	 * The argument is normalised by an even shift so that the seed table
+	 * gives about 8 correct bits, a single Newton step then brings the
+	 * estimate to within a couple of units above the root and the last
+	 * loop walks it down. This replaces a 16-round bit-by-bit loop on
+	 * every ranging sample and returns exactly the same values.
 	 */
 
-	uint32_t  res = 0;
-	uint32_t  bit = 1 << 30;
-	/* The second-to-top bit is set:
-	 *	1 << 14 for 16-bits, 1 << 30 for 32 bits
-	 */
+	uint32_t  res;
+	uint32_t  shift;
 
-	 /* "bit" starts at the highest power of four <= the argument. */
-	while (bit > num)
-		bit >>= 2;
+	if (num == 0)
+		return 0;
 
+	/* Even shift moving the top set bit to position 30 or 31 */
+	shift = (uint32_t)__builtin_clz(num) & ~1u;
 
-	while (bit != 0) {
-		if (num >= res + bit) {
-			num -= res + bit;
-			res = (res >> 1) + bit;
-		} else
-			res >>= 1;
+	res = (uint32_t)isqrt_seed[((num << shift) >> 24) - 64] << 8;
+	res >>= shift >> 1;
 
-		bit >>= 2;
-	}
+	/* Never 0 as the seed is at least 128 and shift at most 30 */
+	res = (res + num / res) >> 1;
+
+	/* Newton's step never lands below the root */
+	while ((uint64_t)res * res > num)
+		res--;
 
 	return res;
 }
@@ -211,6 +236,47 @@ VL53L0X_Error VL53L0X_device_read_strobe(VL53L0X_DEV Dev)
 
 }
 
+/* Open and close the NVM readout window used by the functions below */
+static VL53L0X_Error nvm_read_enter(VL53L0X_DEV Dev)
+{
+	VL53L0X_Error Status = VL53L0X_ERROR_NONE;
+	uint8_t byte;
+
+	Status |= VL53L0X_WrByte(Dev, 0x80, 0x01);
+	Status |= VL53L0X_WrByte(Dev, 0xFF, 0x01);
+	Status |= VL53L0X_WrByte(Dev, 0x00, 0x00);
+
+	Status |= VL53L0X_WrByte(Dev, 0xFF, 0x06);
+	Status |= VL53L0X_RdByte(Dev, 0x83, &byte);
+	Status |= VL53L0X_WrByte(Dev, 0x83, byte|4);
+	Status |= VL53L0X_WrByte(Dev, 0xFF, 0x07);
+	Status |= VL53L0X_WrByte(Dev, 0x81, 0x01);
+
+	Status |= VL53L0X_PollingDelay(Dev);
+
+	Status |= VL53L0X_WrByte(Dev, 0x80, 0x01);
+
+	return Status;
+}
+
+static VL53L0X_Error nvm_read_leave(VL53L0X_DEV Dev)
+{
+	VL53L0X_Error Status = VL53L0X_ERROR_NONE;
+	uint8_t byte;
+
+	Status |= VL53L0X_WrByte(Dev, 0x81, 0x00);
+	Status |= VL53L0X_WrByte(Dev, 0xFF, 0x06);
+	Status |= VL53L0X_RdByte(Dev, 0x83, &byte);
+	Status |= VL53L0X_WrByte(Dev, 0x83, byte&0xfb);
+	Status |= VL53L0X_WrByte(Dev, 0xFF, 0x01);
+	Status |= VL53L0X_WrByte(Dev, 0x00, 0x01);
+
+	Status |= VL53L0X_WrByte(Dev, 0xFF, 0x00);
+	Status |= VL53L0X_WrByte(Dev, 0x80, 0x00);
+
+	return Status;
+}
+
 VL53L0X_Error VL53L0X_get_info_from_device(VL53L0X_DEV Dev, uint8_t option)
 {
 
@@ -228,8 +294,6 @@ VL53L0X_Error VL53L0X_get_info_from_device(VL53L0X_DEV Dev, uint8_t option)
 	uint32_t DistMeasTgtFixed1104_mm = 400 << 4;
 	uint32_t DistMeasFixed1104_400_mm = 0;
 	uint32_t SignalRateMeasFixed1104_400_mm = 0;
-	char ProductId[19];
-	char *ProductId_tmp;
 	uint8_t ReadDataFromDeviceDone;
 	FixPoint1616_t SignalRateMeasFixed400mmFix = 0;
 	uint8_t NvmRefGoodSpadMap[VL53L0X_REF_SPAD_BUFFER_SIZE];
@@ -246,19 +310,7 @@ VL53L0X_Error VL53L0X_get_info_from_device(VL53L0X_DEV Dev, uint8_t option)
 	 */
 	if (ReadDataFromDeviceDone != 7) {
 
-		Status |= VL53L0X_WrByte(Dev, 0x80, 0x01);
-		Status |= VL53L0X_WrByte(Dev, 0xFF, 0x01);
-		Status |= VL53L0X_WrByte(Dev, 0x00, 0x00);
-
-		Status |= VL53L0X_WrByte(Dev, 0xFF, 0x06);
-		Status |= VL53L0X_RdByte(Dev, 0x83, &byte);
-		Status |= VL53L0X_WrByte(Dev, 0x83, byte|4);
-		Status |= VL53L0X_WrByte(Dev, 0xFF, 0x07);
-		Status |= VL53L0X_WrByte(Dev, 0x81, 0x01);
-
-		Status |= VL53L0X_PollingDelay(Dev);
-
-		Status |= VL53L0X_WrByte(Dev, 0x80, 0x01);
+		Status |= nvm_read_enter(Dev);
 
 		if (((option & 1) == 1) &&
 			((ReadDataFromDeviceDone & 1) == 0)) {
@@ -303,58 +355,6 @@ VL53L0X_Error VL53L0X_get_info_from_device(VL53L0X_DEV Dev, uint8_t option)
 			Status |= VL53L0X_device_read_strobe(Dev);
 			Status |= VL53L0X_RdByte(Dev, 0x90, &Revision);
 
-			Status |= VL53L0X_WrByte(Dev, 0x94, 0x77);
-			Status |= VL53L0X_device_read_strobe(Dev);
-			Status |= VL53L0X_RdDWord(Dev, 0x90, &TmpDWord);
-
-			ProductId[0] = (char)((TmpDWord >> 25) & 0x07f);
-			ProductId[1] = (char)((TmpDWord >> 18) & 0x07f);
-			ProductId[2] = (char)((TmpDWord >> 11) & 0x07f);
-			ProductId[3] = (char)((TmpDWord >> 4) & 0x07f);
-
-			byte = (uint8_t)((TmpDWord & 0x00f) << 3);
-
-			Status |= VL53L0X_WrByte(Dev, 0x94, 0x78);
-			Status |= VL53L0X_device_read_strobe(Dev);
-			Status |= VL53L0X_RdDWord(Dev, 0x90, &TmpDWord);
-
-			ProductId[4] = (char)(byte +
-					((TmpDWord >> 29) & 0x07f));
-			ProductId[5] = (char)((TmpDWord >> 22) & 0x07f);
-			ProductId[6] = (char)((TmpDWord >> 15) & 0x07f);
-			ProductId[7] = (char)((TmpDWord >> 8) & 0x07f);
-			ProductId[8] = (char)((TmpDWord >> 1) & 0x07f);
-
-			byte = (uint8_t)((TmpDWord & 0x001) << 6);
-
-			Status |= VL53L0X_WrByte(Dev, 0x94, 0x79);
-
-			Status |= VL53L0X_device_read_strobe(Dev);
-
-			Status |= VL53L0X_RdDWord(Dev, 0x90, &TmpDWord);
-
-			ProductId[9] = (char)(byte +
-					((TmpDWord >> 26) & 0x07f));
-			ProductId[10] = (char)((TmpDWord >> 19) & 0x07f);
-			ProductId[11] = (char)((TmpDWord >> 12) & 0x07f);
-			ProductId[12] = (char)((TmpDWord >> 5) & 0x07f);
-
-			byte = (uint8_t)((TmpDWord & 0x01f) << 2);
-
-			Status |= VL53L0X_WrByte(Dev, 0x94, 0x7A);
-
-			Status |= VL53L0X_device_read_strobe(Dev);
-
-			Status |= VL53L0X_RdDWord(Dev, 0x90, &TmpDWord);
-
-			ProductId[13] = (char)(byte +
-					((TmpDWord >> 30) & 0x07f));
-			ProductId[14] = (char)((TmpDWord >> 23) & 0x07f);
-			ProductId[15] = (char)((TmpDWord >> 16) & 0x07f);
-			ProductId[16] = (char)((TmpDWord >> 9) & 0x07f);
-			ProductId[17] = (char)((TmpDWord >> 2) & 0x07f);
-			ProductId[18] = '\0';
-
 		}
 
 		if (((option & 4) == 4) &&
@@ -397,15 +397,7 @@ VL53L0X_Error VL53L0X_get_info_from_device(VL53L0X_DEV Dev, uint8_t option)
 							>> 24);
 		}
 
-		Status |= VL53L0X_WrByte(Dev, 0x81, 0x00);
-		Status |= VL53L0X_WrByte(Dev, 0xFF, 0x06);
-		Status |= VL53L0X_RdByte(Dev, 0x83, &byte);
-		Status |= VL53L0X_WrByte(Dev, 0x83, byte&0xfb);
-		Status |= VL53L0X_WrByte(Dev, 0xFF, 0x01);
-		Status |= VL53L0X_WrByte(Dev, 0x00, 0x01);
-
-		Status |= VL53L0X_WrByte(Dev, 0xFF, 0x00);
-		Status |= VL53L0X_WrByte(Dev, 0x80, 0x00);
+		Status |= nvm_read_leave(Dev);
 	}
 
 	if ((Status == VL53L0X_ERROR_NONE) &&
@@ -433,10 +425,6 @@ VL53L0X_Error VL53L0X_get_info_from_device(VL53L0X_DEV Dev, uint8_t option)
 			VL53L0X_SETDEVICESPECIFICPARAMETER(Dev,
 					Revision, Revision);
 
-			ProductId_tmp = VL53L0X_GETDEVICESPECIFICPARAMETER(Dev,
-					ProductId);
-			VL53L0X_COPYSTRING(ProductId_tmp, ProductId);
-
 		}
 
 		if (((option & 4) == 4) &&
@@ -479,6 +467,81 @@ VL53L0X_Error VL53L0X_get_info_from_device(VL53L0X_DEV Dev, uint8_t option)
 }
 
 
+#ifndef VL53L0X_LEAN
+/* The product identifier is only wanted by VL53L0X_GetDeviceInfo(), so it
+ * is read from the NVM on each call instead of being kept in every device
+ * structure.
+ */
+VL53L0X_Error VL53L0X_get_product_id(VL53L0X_DEV Dev, char *pProductId)
+{
+	VL53L0X_Error Status = VL53L0X_ERROR_NONE;
+	uint8_t byte;
+	uint32_t TmpDWord;
+
+	LOG_FUNCTION_START("");
+
+	Status |= nvm_read_enter(Dev);
+
+	Status |= VL53L0X_WrByte(Dev, 0x94, 0x77);
+	Status |= VL53L0X_device_read_strobe(Dev);
+	Status |= VL53L0X_RdDWord(Dev, 0x90, &TmpDWord);
+
+	pProductId[0] = (char)((TmpDWord >> 25) & 0x07f);
+	pProductId[1] = (char)((TmpDWord >> 18) & 0x07f);
+	pProductId[2] = (char)((TmpDWord >> 11) & 0x07f);
+	pProductId[3] = (char)((TmpDWord >> 4) & 0x07f);
+
+	byte = (uint8_t)((TmpDWord & 0x00f) << 3);
+
+	Status |= VL53L0X_WrByte(Dev, 0x94, 0x78);
+	Status |= VL53L0X_device_read_strobe(Dev);
+	Status |= VL53L0X_RdDWord(Dev, 0x90, &TmpDWord);
+
+	pProductId[4] = (char)(byte +
+			((TmpDWord >> 29) & 0x07f));
+	pProductId[5] = (char)((TmpDWord >> 22) & 0x07f);
+	pProductId[6] = (char)((TmpDWord >> 15) & 0x07f);
+	pProductId[7] = (char)((TmpDWord >> 8) & 0x07f);
+	pProductId[8] = (char)((TmpDWord >> 1) & 0x07f);
+
+	byte = (uint8_t)((TmpDWord & 0x001) << 6);
+
+	Status |= VL53L0X_WrByte(Dev, 0x94, 0x79);
+
+	Status |= VL53L0X_device_read_strobe(Dev);
+
+	Status |= VL53L0X_RdDWord(Dev, 0x90, &TmpDWord);
+
+	pProductId[9] = (char)(byte +
+			((TmpDWord >> 26) & 0x07f));
+	pProductId[10] = (char)((TmpDWord >> 19) & 0x07f);
+	pProductId[11] = (char)((TmpDWord >> 12) & 0x07f);
+	pProductId[12] = (char)((TmpDWord >> 5) & 0x07f);
+
+	byte = (uint8_t)((TmpDWord & 0x01f) << 2);
+
+	Status |= VL53L0X_WrByte(Dev, 0x94, 0x7A);
+
+	Status |= VL53L0X_device_read_strobe(Dev);
+
+	Status |= VL53L0X_RdDWord(Dev, 0x90, &TmpDWord);
+
+	pProductId[13] = (char)(byte +
+			((TmpDWord >> 30) & 0x07f));
+	pProductId[14] = (char)((TmpDWord >> 23) & 0x07f);
+	pProductId[15] = (char)((TmpDWord >> 16) & 0x07f);
+	pProductId[16] = (char)((TmpDWord >> 9) & 0x07f);
+	pProductId[17] = (char)((TmpDWord >> 2) & 0x07f);
+	pProductId[18] = '\0';
+
+	Status |= nvm_read_leave(Dev);
+
+	LOG_FUNCTION_END(Status);
+	return Status;
+}
+#endif /* VL53L0X_LEAN */
+
+
 uint32_t VL53L0X_calc_macro_period_ps(VL53L0X_DEV Dev,
 				      uint8_t vcsel_period_pclks)
 {
@@ -1529,7 +1592,7 @@ VL53L0X_Error get_dmax_lut_points(VL53L0X_DMaxLUT_t data, uint32_t lut_size,
 VL53L0X_Error VL53L0X_calc_dmax(
 	VL53L0X_DEV Dev, FixPoint1616_t ambRateMeas, uint32_t *pdmax_mm){
 	VL53L0X_Error Status = VL53L0X_ERROR_NONE;
-	VL53L0X_DeviceParameters_t CurrentParameters;
+	VL53L0X_DMaxLUT_t *pDmaxLut;
 	int32_t index0 = 0;
 	int32_t index1 = 0;
 	FixPoint1616_t amb0, amb1, dmax0, dmax1;
@@ -1538,27 +1601,31 @@ VL53L0X_Error VL53L0X_calc_dmax(
 
 	LOG_FUNCTION_START("");
 
-	Status = VL53L0X_GetDeviceParameters(Dev, &CurrentParameters);
+	/*
+	 * Only the LUT is needed: read it from the device data rather than
+	 * through VL53L0X_GetDeviceParameters(), which re-reads the sequence
+	 * and timing registers over I2C on every sample. Same LUT, but a
+	 * failed read no longer fails the sample, and the limit and budget
+	 * shadows are no longer refreshed from the registers here.
+	 */
+	pDmaxLut = &PALDevDataGet(Dev, CurrentParameters).dmax_lut;
 
-	if (ambRateMeas <= CurrentParameters.dmax_lut.ambRate_mcps[0]) {
-		dmax_mm = CurrentParameters.dmax_lut.dmax_mm[0];
+	if (ambRateMeas <= pDmaxLut->ambRate_mcps[0]) {
+		dmax_mm = pDmaxLut->dmax_mm[0];
 	} else if (ambRateMeas >=
-		   CurrentParameters.dmax_lut.
-		   ambRate_mcps[VL53L0X_DMAX_LUT_SIZE - 1]) {
-		dmax_mm =
-		    CurrentParameters.dmax_lut.dmax_mm[VL53L0X_DMAX_LUT_SIZE -
-						       1];
+		   pDmaxLut->ambRate_mcps[VL53L0X_DMAX_LUT_SIZE - 1]) {
+		dmax_mm = pDmaxLut->dmax_mm[VL53L0X_DMAX_LUT_SIZE - 1];
 	} else{
-		get_dmax_lut_points(CurrentParameters.dmax_lut,
+		get_dmax_lut_points(*pDmaxLut,
 			VL53L0X_DMAX_LUT_SIZE, ambRateMeas, &index0, &index1);
 
 		if (index0 == index1) {
-			dmax_mm = CurrentParameters.dmax_lut.dmax_mm[index0];
+			dmax_mm = pDmaxLut->dmax_mm[index0];
 		} else {
-			amb0 = CurrentParameters.dmax_lut.ambRate_mcps[index0];
-			amb1 = CurrentParameters.dmax_lut.ambRate_mcps[index1];
-			dmax0 = CurrentParameters.dmax_lut.dmax_mm[index0];
-			dmax1 = CurrentParameters.dmax_lut.dmax_mm[index1];
+			amb0 = pDmaxLut->ambRate_mcps[index0];
+			amb1 = pDmaxLut->ambRate_mcps[index1];
+			dmax0 = pDmaxLut->dmax_mm[index0];
+			dmax1 = pDmaxLut->dmax_mm[index1];
 			if ((amb1 - amb0) != 0) {
 				/* Fix16:16/Fix16:8 => Fix16:8 */
 				linearSlope = (dmax0-dmax1)/((amb1-amb0) >> 8);
@@ -1759,18 +1826,29 @@ VL53L0X_Error VL53L0X_calc_sigma_estimate(VL53L0X_DEV Dev,
 		/* vcselRate + xtalkCompRate */
 		diff2_mcps = ((peakSignalRate_kcps << 16) + 500)/1000;
 
-		/* Shift by 8 bits to increase resolution prior to the
-		 * division
+		/*
+		 * Without cross-talk compensation both rates are equal and the
+		 * ratio is exactly 1.0 whenever the shift below cannot
+		 * overflow; the multiplier then reduces to 1.0 as well.
 		 */
-		diff1_mcps <<= 8;
+		if (xTalkCompRate_kcps == 0 && diff2_mcps != 0 &&
+				diff2_mcps < (1 << 24)) {
+			xTalkCorrection = 1 << 16;
+		} else {
+			/* Shift by 8 bits to increase resolution prior to the
+			 * division
+			 */
+			diff1_mcps <<= 8;
 
-		/* FixPoint0824/FixPoint1616 = FixPoint2408 */
-		xTalkCorrection	 = abs(diff1_mcps/diff2_mcps);
+			/* FixPoint0824/FixPoint1616 = FixPoint2408 */
+			xTalkCorrection	 = abs(diff1_mcps/diff2_mcps);
 
-		/* FixPoint2408 << 8 = FixPoint1616 */
-		xTalkCorrection <<= 8;
+			/* FixPoint2408 << 8 = FixPoint1616 */
+			xTalkCorrection <<= 8;
+		}
 
-		if (pRangingMeasurementData->RangeStatus != 0) {
+		if (pRangingMeasurementData->RangeStatus != 0 ||
+				xTalkCorrection == (1 << 16)) {
 			pwMult = 1 << 16;
 		} else {
 			/* FixPoint1616/uint32 = FixPoint1616 */
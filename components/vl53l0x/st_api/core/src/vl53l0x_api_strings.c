@@ -48,7 +48,6 @@ VL53L0X_Error VL53L0X_check_part_used(VL53L0X_DEV Dev,
 {
 	VL53L0X_Error Status = VL53L0X_ERROR_NONE;
 	uint8_t ModuleIdInt;
-	char *ProductId_tmp;
 
 	LOG_FUNCTION_START("");
 
@@ -62,10 +61,8 @@ VL53L0X_Error VL53L0X_check_part_used(VL53L0X_DEV Dev,
 		VL53L0X_COPYSTRING(pVL53L0X_DeviceInfo->ProductId, "");
 	} else {
 		*Revision = VL53L0X_GETDEVICESPECIFICPARAMETER(Dev, Revision);
-		ProductId_tmp = VL53L0X_GETDEVICESPECIFICPARAMETER(Dev,
-			ProductId);
-		VL53L0X_COPYSTRING(pVL53L0X_DeviceInfo->ProductId,
-				   ProductId_tmp);
+		Status = VL53L0X_get_product_id(Dev,
+			pVL53L0X_DeviceInfo->ProductId);
 	}
 	}
 
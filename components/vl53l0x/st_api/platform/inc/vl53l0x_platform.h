@@ -33,6 +33,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "vl53l0x_def.h"
 #include "vl53l0x_platform_log.h"
 #include "vl53l0x_i2c_platform.h"
+#include "driver/i2c_master.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -50,6 +51,14 @@ extern "C" {
  *  @{
  */
 
+/**
+ * @def VL53L0X_I2C_SCRATCH_SIZE
+ * @brief Size of the per-device write buffer (register index + payload)
+ *
+ * The largest write issued by the ST API is the 6-byte reference SPAD map.
+ */
+#define VL53L0X_I2C_SCRATCH_SIZE 16
+
 /**
  * @struct  VL53L0X_Dev_t
  * @brief    Generic PAL device type that does link between API and platform abstraction layer
@@ -62,6 +71,18 @@ typedef struct {
     uint8_t   I2cDevAddr;                /*!< i2c device address user specific field */
     uint8_t   comms_type;                /*!< Type of comms : VL53L0X_COMMS_I2C or VL53L0X_COMMS_SPI */
     uint16_t  comms_speed_khz;           /*!< Comms speed [kHz] : typically 400kHz for I2C           */
+    i2c_master_dev_handle_t i2c_dev_handle; /*!< ESP-IDF I2C device handle used by the platform layer */
+    struct vl53l0x_i2c_bus_s *i2c_bus;    /*!< Bus registry entry this device is attached to */
+    uint8_t   i2c_scratch[VL53L0X_I2C_SCRATCH_SIZE]; /*!< Write buffer, avoids heap use per transfer */
+    uint8_t   i2c_batch[VL53L0X_I2C_SCRATCH_SIZE];   /*!< Pending coalesced write: index + payload */
+    uint8_t   i2c_batch_len;             /*!< Bytes in i2c_batch, 0 when nothing is pending */
+    uint8_t   i2c_batch_depth;           /*!< Nesting of batch sections, 0 sends writes immediately */
+    uint8_t   i2c_page;                  /*!< Last value written to the 0xFF page register */
+    uint8_t   i2c_page_valid;            /*!< Non-zero when i2c_page matches the sensor */
+#ifdef VL53L0X_SIMULATOR
+    struct vl53l0x_sim_s *sim;           /*!< Simulated sensor answering instead of the bus, NULL for real I2C */
+#endif
+    int64_t   i2c_fault_until_us;        /*!< Transfers fail fast until this time after an unrecovered bus fault */
 
 } VL53L0X_Dev_t;
 
@@ -99,6 +99,16 @@ void trace_print_module_function(uint32_t module, uint32_t level, uint32_t funct
 // __func__ is gcc only
 //#define VL53L0X_ErrLog( fmt, ...)  fprintf(stderr, "VL53L0X_ErrLog %s" fmt "\n", __func__, ##__VA_ARGS__)
 
+#elif defined(VL53L0X_I2C_TRACE) /* I2C tracer: attribute transfers to API calls */
+
+void vl53l0x_trace_enter(const char *function);
+void vl53l0x_trace_exit(const char *function);
+
+    #define VL53L0X_ErrLog(...) (void)0
+    #define _LOG_FUNCTION_START(module, fmt, ... ) vl53l0x_trace_enter(__FUNCTION__)
+    #define _LOG_FUNCTION_END(module, status, ... ) vl53l0x_trace_exit(__FUNCTION__)
+    #define _LOG_FUNCTION_END_FMT(module, status, fmt, ... ) vl53l0x_trace_exit(__FUNCTION__)
+
 #else /* VL53L0X_LOG_ENABLE no logging */
     #define VL53L0X_ErrLog(...) (void)0
     #define _LOG_FUNCTION_START(module, fmt, ... ) (void)0
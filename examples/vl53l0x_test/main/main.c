@@ -22,7 +22,8 @@ void app_main(void) {
         .sda_pin = GPIO_NUM_6,
         .i2c_freq_hz = 400000,
         .mode = VL53L0X_MODE_HIGH_ACCURACY,
-        .i2c_address = 0x29
+        .i2c_address = 0x29,
+        .gpio_int_pin = GPIO_NUM_NC  // Set to the sensor GPIO1 pin to avoid I2C polling
     };
     
     // Initialize sensor
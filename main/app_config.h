@@ -13,17 +13,23 @@
 // HARDWARE CONFIGURATION
 // ============================================================================
 
+// Each distinct SCL/SDA pair takes one I2C controller and the ESP32 has only
+// two, so the sensors use two pairs: the front sensor gets a bus of its own
+// and the side sensors share the other. Check vl53l0x_get_bus_stats() to see
+// the load on each bus.
+
 // Front sensor (high accuracy for precise navigation)
 #define GPIO_SCL_FRONT    GPIO_NUM_5
 #define GPIO_SDA_FRONT    GPIO_NUM_6
 
-// Left sensor (for wall following)
-#define GPIO_SCL_LEFT     GPIO_NUM_7
-#define GPIO_SDA_LEFT     GPIO_NUM_8
+// Left and right sensors (for wall following), on one bus
+#define GPIO_SCL_SIDES    GPIO_NUM_7
+#define GPIO_SDA_SIDES    GPIO_NUM_8
 
-// Right sensor (for wall following)
-#define GPIO_SCL_RIGHT    GPIO_NUM_9
-#define GPIO_SDA_RIGHT    GPIO_NUM_10
+// Sensors on a shared bus boot at the same address: XSHUT holds one in reset
+// while the other is moved to its own address
+#define GPIO_XSHUT_LEFT   GPIO_NUM_9
+#define GPIO_XSHUT_RIGHT  GPIO_NUM_10
 
 // ============================================================================
 // NAVIGATION PARAMETERS
@@ -0,0 +1,159 @@
+/**
+ * @file bench_adaptive.c
+ * @brief Detection latency and parked precision, fixed modes vs the adaptive policy
+ *
+ * Approach: the target sits at 1500 mm, then closes at 1000 mm/s with the
+ * same commanded speed; the latency is from the moment it crosses 200 mm
+ * to the first sample at or below 200 mm. Parked: the target stays at
+ * 150 mm with the vehicle stopped, and the spread is taken over the last
+ * two of three seconds.
+ */
+
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include "host_test.h"
+#include "vl53l0x_driver.h"
+#include "vl53l0x_adaptive.h"
+#include "vl53l0x_sim.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define SEEDS           3
+#define APPROACH_MM_S   1000
+#define DETECT_MM       200
+
+typedef struct {
+    vl53l0x_handle_t handle;
+    bool adaptive;
+    vl53l0x_adaptive_t policy;
+    int16_t speed_mm_s;          // Commanded speed fed to the policy
+    double start_mm;             // Target distance until move_us
+    double speed_target_mm_s;    // Closing speed from move_us on
+    int64_t move_us;
+    uint16_t detect_mm;          // 0: no detection
+    int64_t detected_us;
+    int64_t window_us;           // Spread samples from here on
+    int count;
+    double sum;
+    double sum2;
+    int switches;
+} run_t;
+
+static run_t run;
+
+static uint16_t target_mm(int64_t time_us, void* user_data) {
+    (void)user_data;
+    double d = run.start_mm;
+    if (time_us > run.move_us) {
+        d -= run.speed_target_mm_s * (double)(time_us - run.move_us) / 1e6;
+    }
+    return (d < 0) ? 0 : (uint16_t)d;
+}
+
+static void on_sample(const vl53l0x_measurement_t* m, void* user_data) {
+    (void)user_data;
+    if (run.adaptive) {
+        vl53l0x_mode_t previous = run.policy.mode;
+        vl53l0x_mode_t mode = vl53l0x_adaptive_update(&run.policy, m, run.speed_mm_s > 0 ? run.speed_mm_s : 0);
+        if (mode != previous) {
+            if (vl53l0x_set_mode(run.handle, mode) == ESP_OK) {
+                run.switches++;
+            } else {
+                run.policy.mode = previous;
+            }
+        }
+    }
+    if (!m->is_valid) {
+        return;
+    }
+    if (run.detect_mm && !run.detected_us && m->timestamp_us > run.move_us && m->distance_mm <= run.detect_mm) {
+        run.detected_us = m->timestamp_us;
+    }
+    if (run.window_us && m->timestamp_us >= run.window_us) {
+        run.count++;
+        run.sum += m->distance_mm;
+        run.sum2 += (double)m->distance_mm * m->distance_mm;
+    }
+}
+
+static vl53l0x_sim_handle_t setup(vl53l0x_mode_t mode, bool adaptive, uint32_t seed) {
+    vl53l0x_sim_config_t sim_config = VL53L0X_SIM_DEFAULT_CONFIG();
+    vl53l0x_adaptive_config_t policy_config = VL53L0X_ADAPTIVE_DEFAULT_CONFIG();
+    vl53l0x_sim_handle_t sim;
+
+    sim_config.noise_mm = 20;
+    sim_config.seed = seed;
+    sim_config.range_fn = target_mm;
+    CHECK_OK(vl53l0x_sim_create(&sim_config, &sim));
+    vl53l0x_config_t config = VL53L0X_DEFAULT_CONFIG();
+    config.simulator = sim;
+    config.mode = mode;
+    CHECK_OK(vl53l0x_init(&config, &run.handle));
+    run.adaptive = adaptive;
+    vl53l0x_adaptive_init(&run.policy, &policy_config, mode);
+    return sim;
+}
+
+static void teardown(vl53l0x_sim_handle_t sim) {
+    CHECK_OK(vl53l0x_stop_continuous(run.handle));
+    CHECK_OK(vl53l0x_deinit(run.handle));
+    vl53l0x_sim_delete(sim);
+}
+
+static void approach(const char* title, vl53l0x_mode_t mode, bool adaptive) {
+    double sum_ms = 0;
+    double worst_ms = 0;
+
+    for (uint32_t seed = 1; seed <= SEEDS; seed++) {
+        run = (run_t){ .start_mm = 1500, .move_us = INT64_MAX, .detect_mm = DETECT_MM };
+        vl53l0x_sim_handle_t sim = setup(mode, adaptive, seed * 7919);
+        run.speed_mm_s = APPROACH_MM_S;
+        CHECK_OK(vl53l0x_start_continuous(run.handle, on_sample, NULL));
+        vTaskDelay(pdMS_TO_TICKS(300));
+
+        run.speed_target_mm_s = APPROACH_MM_S;
+        run.move_us = esp_timer_get_time();
+        int64_t cross_us = run.move_us + (int64_t)((run.start_mm - DETECT_MM) * 1e6 / APPROACH_MM_S);
+        while (!run.detected_us && esp_timer_get_time() < cross_us + 1000000) {
+            vTaskDelay(1);
+        }
+        teardown(sim);
+        CHECK(run.detected_us);
+
+        double latency_ms = (double)(run.detected_us - cross_us) / 1000.0;
+        sum_ms += latency_ms;
+        worst_ms = (latency_ms > worst_ms) ? latency_ms : worst_ms;
+    }
+    printf("  %-14s latency mean %6.1f ms, worst %6.1f ms (%3.0f mm travelled)\n", title, sum_ms / SEEDS,
+           worst_ms, worst_ms * APPROACH_MM_S / 1000.0);
+}
+
+static void parked(const char* title, vl53l0x_mode_t mode, bool adaptive) {
+    run = (run_t){ .start_mm = 150, .move_us = INT64_MAX };
+    vl53l0x_sim_handle_t sim = setup(mode, adaptive, 4242);
+    run.window_us = esp_timer_get_time() + 1000000;
+    CHECK_OK(vl53l0x_start_continuous(run.handle, on_sample, NULL));
+    vTaskDelay(pdMS_TO_TICKS(3000));
+    vl53l0x_mode_t final_mode = adaptive ? run.policy.mode : mode;
+    teardown(sim);
+    CHECK(run.count > 1);
+
+    double mean = run.sum / run.count;
+    printf("  %-14s sd %5.2f mm over %3d samples, ends in %s after %d switches\n", title,
+           sqrt(run.sum2 / run.count - mean * mean), run.count, vl53l0x_get_mode_name(final_mode), run.switches);
+}
+
+int main(void) {
+    printf("approach from 1500 mm at %d mm/s, detection at %d mm, %d runs\n", APPROACH_MM_S, DETECT_MM, SEEDS);
+    approach("High Accuracy", VL53L0X_MODE_HIGH_ACCURACY, false);
+    approach("High Speed", VL53L0X_MODE_HIGH_SPEED, false);
+    approach("Adaptive", VL53L0X_MODE_HIGH_ACCURACY, true);
+
+    printf("parked at 150 mm, vehicle stopped\n");
+    parked("High Accuracy", VL53L0X_MODE_HIGH_ACCURACY, false);
+    parked("High Speed", VL53L0X_MODE_HIGH_SPEED, false);
+    parked("Adaptive", VL53L0X_MODE_HIGH_ACCURACY, true);
+    return 0;
+}
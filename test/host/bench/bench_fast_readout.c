@@ -0,0 +1,84 @@
+/**
+ * @file bench_fast_readout.c
+ * @brief Readout of one continuous-mode sample: ST sequence vs the single-read path
+ *
+ * The ST sequence is GetMeasurementDataReady, GetRangingMeasurementData and
+ * ClearInterruptMask; the continuous task uses
+ * VL53L0X_GetRangingMeasurementDataFast(). Each readout starts once the
+ * sample is ready, so polls for samples still in flight are not counted.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "host_test.h"
+#include "vl53l0x_api.h"
+#include "vl53l0x_sim.h"
+#include "vl53l0x_sim_io.h"
+#include "vl53l0x_platform.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define SAMPLES     20
+
+static void read_st(VL53L0X_DEV dev, VL53L0X_RangingMeasurementData_t* data) {
+    uint8_t ready = 0;
+    CHECK(VL53L0X_GetMeasurementDataReady(dev, &ready) == VL53L0X_ERROR_NONE);
+    CHECK(ready);
+    CHECK(VL53L0X_GetRangingMeasurementData(dev, data) == VL53L0X_ERROR_NONE);
+    CHECK(VL53L0X_ClearInterruptMask(dev, 0) == VL53L0X_ERROR_NONE);
+}
+
+static void read_fast(VL53L0X_DEV dev, VL53L0X_RangingMeasurementData_t* data) {
+    uint8_t ready = 0;
+    CHECK(VL53L0X_GetRangingMeasurementDataFast(dev, &ready, data) == VL53L0X_ERROR_NONE);
+    CHECK(ready);
+}
+
+static void run(const char* title, void (*readout)(VL53L0X_DEV, VL53L0X_RangingMeasurementData_t*)) {
+    vl53l0x_sim_config_t sim_config = VL53L0X_SIM_DEFAULT_CONFIG();
+    vl53l0x_sim_handle_t sim;
+    vl53l0x_sim_stats_t st;
+    VL53L0X_Dev_t dev;
+    VL53L0X_RangingMeasurementData_t data;
+    uint32_t budget_us;
+    uint32_t transfers = 0;
+    uint64_t bytes = 0;
+    uint64_t bus_us = 0;
+
+    memset(&dev, 0, sizeof(dev));
+    dev.I2cDevAddr = 0x29;
+    dev.comms_speed_khz = 400;
+    CHECK_OK(vl53l0x_sim_create(&sim_config, &sim));
+    dev.sim = sim;
+    CHECK_OK(vl53l0x_sim_attach(sim, &dev));
+    CHECK(VL53L0X_DataInit(&dev) == VL53L0X_ERROR_NONE);
+    CHECK(VL53L0X_StaticInit(&dev) == VL53L0X_ERROR_NONE);
+    CHECK(VL53L0X_GetMeasurementTimingBudgetMicroSeconds(&dev, &budget_us) == VL53L0X_ERROR_NONE);
+    CHECK(VL53L0X_SetDeviceMode(&dev, VL53L0X_DEVICEMODE_CONTINUOUS_RANGING) == VL53L0X_ERROR_NONE);
+    CHECK(VL53L0X_StartMeasurement(&dev) == VL53L0X_ERROR_NONE);
+
+    for (int i = 0; i < SAMPLES; i++) {
+        vTaskDelay(pdMS_TO_TICKS(budget_us / 1000 + 5));
+        vl53l0x_sim_reset_stats(sim);
+        readout(&dev, &data);
+        CHECK_OK(vl53l0x_sim_get_stats(sim, &st));
+        CHECK(data.RangeStatus == 0);
+        transfers += st.reads + st.writes;
+        bytes += st.bytes;
+        bus_us += st.bus_us;
+    }
+
+    printf("%-38s %4.1f transfers, %4.0f bytes, %4.0f us bus per sample\n", title,
+           (double)transfers / SAMPLES, (double)bytes / SAMPLES, (double)bus_us / SAMPLES);
+
+    VL53L0X_StopMeasurement(&dev);
+    vl53l0x_sim_detach(sim);
+    vl53l0x_sim_delete(sim);
+}
+
+int main(void) {
+    printf("continuous ranging, default limit checks, 400 kHz\n");
+    run("ST: ready, read, clear interrupt", read_st);
+    run("VL53L0X_GetRangingMeasurementDataFast", read_fast);
+    return 0;
+}
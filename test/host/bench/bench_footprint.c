@@ -0,0 +1,83 @@
+/**
+ * @file bench_footprint.c
+ * @brief RAM held per sensor, from vl53l0x_get_footprint()
+ *
+ * Built twice: bench_footprint with the full ST API and
+ * bench_footprint_lean with VL53L0X_LEAN. Both include the simulator
+ * pointer in the ST device structure, which firmware builds leave out.
+ * For comparison, the handle of the baseline driver (commit 22127ab) was
+ * 472 bytes in this build, 400 of them ST state, next to the same lock.
+ */
+
+#include <stdio.h>
+#include "host_test.h"
+#include "vl53l0x_driver.h"
+#include "vl53l0x_sim.h"
+#include "vl53l0x_platform.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static void print_footprint(const char* title, vl53l0x_handle_t handle) {
+    vl53l0x_footprint_t fp;
+    CHECK_OK(vl53l0x_get_footprint(handle, &fp));
+    printf("  %-33s handle %3lu (ST %3lu)  history %4lu  presets %3lu  multi-shot %3lu  async %2lu  waits %2lu"
+           "  lock %2lu  stack %4lu  total %4lu\n",
+           title, (unsigned long)fp.handle_bytes, (unsigned long)fp.device_bytes, (unsigned long)fp.history_bytes,
+           (unsigned long)fp.presets_bytes, (unsigned long)fp.multi_shot_bytes, (unsigned long)fp.async_bytes,
+           (unsigned long)fp.wait_stats_bytes, (unsigned long)fp.lock_bytes, (unsigned long)fp.task_stack_bytes,
+           (unsigned long)fp.total_bytes);
+}
+
+static void on_sample(const vl53l0x_measurement_t* measurement, void* user_data) {
+    (void)measurement;
+    (void)user_data;
+}
+
+static void measure(uint16_t history_depth, bool fixed_mode) {
+    vl53l0x_sim_config_t sim_config = VL53L0X_SIM_DEFAULT_CONFIG();
+    vl53l0x_sim_handle_t sim;
+    vl53l0x_handle_t handle;
+    vl53l0x_measurement_t m;
+    char title[64];
+    const char* label = fixed_mode ? "fixed" : "history";
+
+    CHECK_OK(vl53l0x_sim_create(&sim_config, &sim));
+    vl53l0x_config_t config = VL53L0X_DEFAULT_CONFIG();
+    config.simulator = sim;
+    config.mode = VL53L0X_MODE_HIGH_SPEED;
+    config.fixed_mode = fixed_mode;
+    config.history_depth = history_depth;
+    CHECK_OK(vl53l0x_init(&config, &handle));
+
+    snprintf(title, sizeof(title), "%s %u, idle", label, history_depth);
+    print_footprint(title, handle);
+    CHECK_OK(vl53l0x_start_continuous(handle, on_sample, NULL));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    snprintf(title, sizeof(title), "%s %u, continuous", label, history_depth);
+    print_footprint(title, handle);
+    CHECK_OK(vl53l0x_stop_continuous(handle));
+    CHECK_OK(vl53l0x_set_mode(handle, VL53L0X_MODE_MULTI_SHOT));
+    snprintf(title, sizeof(title), "%s %u, after MULTI_SHOT", label, history_depth);
+    print_footprint(title, handle);
+    CHECK_OK(vl53l0x_reset_wait_stats(handle));
+    CHECK_OK(vl53l0x_trigger_single(handle));
+    CHECK_OK(vl53l0x_wait_single(handle, 100));
+    CHECK_OK(vl53l0x_fetch_single(handle, &m));
+    snprintf(title, sizeof(title), "%s %u, after async and stats", label, history_depth);
+    print_footprint(title, handle);
+
+    CHECK_OK(vl53l0x_deinit(handle));
+    vl53l0x_sim_delete(sim);
+}
+
+int main(void) {
+#ifdef VL53L0X_LEAN
+    printf("lean ST API, sizeof(VL53L0X_Dev_t) %zu\n", sizeof(VL53L0X_Dev_t));
+#else
+    printf("full ST API, sizeof(VL53L0X_Dev_t) %zu\n", sizeof(VL53L0X_Dev_t));
+#endif
+    measure(32, false);
+    measure(2, false);
+    measure(2, true);
+    return 0;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file bench_init_multi.c
+ * @brief Time to ready for 1 to 6 sensors: vl53l0x_init() one after another vs vl53l0x_init_multi()
+ *
+ * Simulated sensors behind XSHUT pins, HIGH_ACCURACY, full calibration
+ * (no NVS cache). Each simulated sensor has its own bus, so the parallel
+ * figure is bounded by calibration time; on one shared bus it is bounded
+ * by the init bus time, printed per sensor.
+ */
+
+#include <stdio.h>
+#include "host_test.h"
+#include "vl53l0x_driver.h"
+#include "vl53l0x_sim.h"
+#include "esp_timer.h"
+
+#define MAX_SENSORS 6
+
+static double init_ms(size_t count, bool parallel, double* bus_ms) {
+    vl53l0x_sim_handle_t sims[MAX_SENSORS];
+    vl53l0x_config_t configs[MAX_SENSORS];
+    vl53l0x_handle_t handles[MAX_SENSORS];
+    vl53l0x_sim_stats_t st;
+
+    for (size_t i = 0; i < count; i++) {
+        vl53l0x_sim_config_t sim_config = VL53L0X_SIM_DEFAULT_CONFIG();
+        sim_config.seed = 11 + i;
+        sim_config.uid_lower = i + 1;
+        CHECK_OK(vl53l0x_sim_create(&sim_config, &sims[i]));
+        vl53l0x_config_t config = VL53L0X_DEFAULT_CONFIG();
+        config.simulator = sims[i];
+        config.mode = VL53L0X_MODE_HIGH_ACCURACY;
+        config.i2c_address = 0x29 + i;
+        config.xshut_pin = (gpio_num_t)(GPIO_NUM_10 + i);
+        configs[i] = config;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    if (parallel) {
+        CHECK_OK(vl53l0x_init_multi(configs, count, handles));
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            CHECK_OK(vl53l0x_init(&configs[i], &handles[i]));
+        }
+    }
+    double elapsed_ms = (double)(esp_timer_get_time() - start_us) / 1000.0;
+
+    CHECK_OK(vl53l0x_sim_get_stats(sims[0], &st));
+    *bus_ms = (double)st.bus_us / 1000.0;
+    for (size_t i = 0; i < count; i++) {
+        vl53l0x_measurement_t m;
+        CHECK_OK(vl53l0x_read_single(handles[i], &m));
+        CHECK(m.is_valid);
+        CHECK_OK(vl53l0x_deinit(handles[i]));
+        vl53l0x_sim_delete(sims[i]);
+    }
+    return elapsed_ms;
+}
+
+int main(void) {
+    static const size_t counts[] = { 1, 2, 4, 6 };
+    double bus_ms = 0;
+
+    printf("time to ready, HIGH_ACCURACY, full calibration\n");
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        double sequential_ms = init_ms(counts[i], false, &bus_ms);
+        double parallel_ms = init_ms(counts[i], true, &bus_ms);
+        printf("  %zu sensors: one after another %7.1f ms, vl53l0x_init_multi() %7.1f ms\n", counts[i],
+               sequential_ms, parallel_ms);
+    }
+    printf("init bus time per sensor at 400 kHz: %.1f ms\n", bus_ms);
+    return 0;
+}
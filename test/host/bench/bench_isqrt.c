@@ -0,0 +1,82 @@
+/**
+ * @file bench_isqrt.c
+ * @brief VL53L0X_isqrt() against ST's original bit-by-bit square root
+ *
+ * Checks every input below 2^24 and a stride over the full 32-bit range,
+ * then times both on the same pseudo-random inputs. Absolute times depend
+ * on the host; the ratio is what carries over.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "host_test.h"
+#include "vl53l0x_api_core.h"
+
+#define TIMED_CALLS     20000000u
+#define FULL_STRIDE     97u
+
+/**
+ * @brief The square root ST shipped: one result bit per iteration
+ */
+static uint32_t reference_isqrt(uint32_t num) {
+    uint32_t res = 0;
+    uint32_t bit = 1u << 30;
+
+    while (bit > num) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (num >= res + bit) {
+            num -= res + bit;
+            res = (res >> 1) + bit;
+        } else {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+    return res;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static double time_ns(uint32_t (*fn)(uint32_t), uint32_t* checksum) {
+    uint32_t x = 2463534242u;
+    uint32_t sum = 0;
+    double start = now_ns();
+    for (uint32_t i = 0; i < TIMED_CALLS; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        sum += fn(x);
+    }
+    *checksum = sum;
+    return (now_ns() - start) / TIMED_CALLS;
+}
+
+int main(void) {
+    uint64_t checked = 0;
+    uint64_t mismatches = 0;
+
+    for (uint32_t n = 0; n < (1u << 24); n++, checked++) {
+        mismatches += VL53L0X_isqrt(n) != reference_isqrt(n);
+    }
+    for (uint64_t n = 1u << 24; n <= UINT32_MAX; n += FULL_STRIDE, checked++) {
+        mismatches += VL53L0X_isqrt((uint32_t)n) != reference_isqrt((uint32_t)n);
+    }
+    mismatches += VL53L0X_isqrt(UINT32_MAX) != reference_isqrt(UINT32_MAX);
+    printf("%llu inputs checked, %llu mismatches\n", (unsigned long long)checked + 1,
+           (unsigned long long)mismatches);
+    CHECK(mismatches == 0);
+
+    uint32_t reference_sum;
+    uint32_t sum;
+    double reference_ns = time_ns(reference_isqrt, &reference_sum);
+    double ns = time_ns(VL53L0X_isqrt, &sum);
+    CHECK(sum == reference_sum);
+    printf("bit by bit %5.1f ns/call, VL53L0X_isqrt %5.1f ns/call\n", reference_ns, ns);
+    return 0;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file bench_mode_rates.c
+ * @brief Continuous sample rate and spread of each ranging mode
+ *
+ * One simulated sensor, target at 500 mm, 20 mm peak-to-peak noise at a
+ * 33 ms budget (the simulator scales it by sqrt(33 ms / budget)). Each
+ * mode ranges continuously for two seconds.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include "host_test.h"
+#include "vl53l0x_driver.h"
+#include "vl53l0x_sim.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define RUN_MS      2000
+
+typedef struct {
+    int count;
+    double sum;
+    double sum2;
+    int64_t first_us;
+    int64_t last_us;
+} spread_t;
+
+static void on_sample(const vl53l0x_measurement_t* measurement, void* user_data) {
+    spread_t* spread = (spread_t*)user_data;
+    if (!measurement->is_valid) {
+        return;
+    }
+    if (spread->count == 0) {
+        spread->first_us = measurement->timestamp_us;
+    }
+    spread->last_us = measurement->timestamp_us;
+    spread->sum += measurement->distance_mm;
+    spread->sum2 += (double)measurement->distance_mm * measurement->distance_mm;
+    spread->count++;
+}
+
+int main(void) {
+    static const vl53l0x_mode_t modes[] = {
+        VL53L0X_MODE_HIGH_ACCURACY, VL53L0X_MODE_DEFAULT, VL53L0X_MODE_LONG_RANGE,
+        VL53L0X_MODE_HIGH_SPEED, VL53L0X_MODE_ULTRA_FAST,
+    };
+    vl53l0x_sim_config_t sim_config = VL53L0X_SIM_DEFAULT_CONFIG();
+    vl53l0x_sim_handle_t sim;
+    vl53l0x_handle_t handle;
+    uint32_t budget_us;
+
+    sim_config.noise_mm = 20;
+    CHECK_OK(vl53l0x_sim_create(&sim_config, &sim));
+    vl53l0x_config_t config = VL53L0X_DEFAULT_CONFIG();
+    config.simulator = sim;
+    CHECK_OK(vl53l0x_init(&config, &handle));
+
+    printf("continuous ranging, %d ms per mode, 500 mm target\n", RUN_MS);
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        spread_t spread = { 0 };
+        CHECK_OK(vl53l0x_set_mode(handle, modes[i]));
+        CHECK_OK(vl53l0x_get_timing_budget(handle, &budget_us));
+        CHECK_OK(vl53l0x_start_continuous(handle, on_sample, &spread));
+        vTaskDelay(pdMS_TO_TICKS(RUN_MS));
+        CHECK_OK(vl53l0x_stop_continuous(handle));
+        CHECK(spread.count > 1);
+
+        double mean = spread.sum / spread.count;
+        printf("%-14s budget %6.1f ms  %6.1f Hz  mean %5.1f mm  sd %5.1f mm\n", vl53l0x_get_mode_name(modes[i]),
+               budget_us / 1000.0, (spread.count - 1) * 1e6 / (double)(spread.last_us - spread.first_us), mean,
+               sqrt(spread.sum2 / spread.count - mean * mean));
+    }
+
+    CHECK_OK(vl53l0x_deinit(handle));
+    vl53l0x_sim_delete(sim);
+    return 0;
+}
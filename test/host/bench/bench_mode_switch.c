@@ -0,0 +1,68 @@
+/**
+ * @file bench_mode_switch.c
+ * @brief Cost of vl53l0x_set_mode() for every pair of modes
+ *
+ * Registers as counted by vl53l0x_get_mode_stats(), and the transfers and
+ * bus time the simulated sensor saw, for each switch from a mode to
+ * another one while the sensor is idle.
+ */
+
+#include <stdio.h>
+#include "host_test.h"
+#include "vl53l0x_driver.h"
+#include "vl53l0x_sim.h"
+
+static const vl53l0x_mode_t modes[] = {
+    VL53L0X_MODE_DEFAULT, VL53L0X_MODE_HIGH_ACCURACY, VL53L0X_MODE_HIGH_SPEED,
+    VL53L0X_MODE_LONG_RANGE, VL53L0X_MODE_ULTRA_FAST,
+};
+
+#define NUM_MODES   (sizeof(modes) / sizeof(modes[0]))
+
+int main(void) {
+    vl53l0x_sim_config_t sim_config = VL53L0X_SIM_DEFAULT_CONFIG();
+    vl53l0x_sim_handle_t sim;
+    vl53l0x_handle_t handle;
+    vl53l0x_mode_stats_t mode_stats;
+    vl53l0x_sim_stats_t st;
+    uint32_t min_registers = UINT32_MAX;
+    uint32_t max_registers = 0;
+
+    CHECK_OK(vl53l0x_sim_create(&sim_config, &sim));
+    vl53l0x_config_t config = VL53L0X_DEFAULT_CONFIG();
+    config.simulator = sim;
+    CHECK_OK(vl53l0x_init(&config, &handle));
+
+    printf("registers / transfers / us of bus at 400 kHz, rows: from, columns: to\n%-14s", "");
+    for (size_t to = 0; to < NUM_MODES; to++) {
+        printf(" %15s", vl53l0x_get_mode_name(modes[to]));
+    }
+    printf("\n");
+
+    for (size_t from = 0; from < NUM_MODES; from++) {
+        printf("%-14s", vl53l0x_get_mode_name(modes[from]));
+        for (size_t to = 0; to < NUM_MODES; to++) {
+            if (from == to) {
+                printf(" %15s", "-");
+                continue;
+            }
+            CHECK_OK(vl53l0x_set_mode(handle, modes[from]));
+            vl53l0x_sim_reset_stats(sim);
+            CHECK_OK(vl53l0x_set_mode(handle, modes[to]));
+            CHECK_OK(vl53l0x_get_mode_stats(handle, &mode_stats));
+            CHECK_OK(vl53l0x_sim_get_stats(sim, &st));
+            CHECK(st.reads == 0);
+
+            printf("   %3lu / %2lu / %4llu", (unsigned long)mode_stats.last_registers,
+                   (unsigned long)st.writes, (unsigned long long)st.bus_us);
+            min_registers = (mode_stats.last_registers < min_registers) ? mode_stats.last_registers : min_registers;
+            max_registers = (mode_stats.last_registers > max_registers) ? mode_stats.last_registers : max_registers;
+        }
+        printf("\n");
+    }
+    printf("registers per switch: %lu to %lu\n", (unsigned long)min_registers, (unsigned long)max_registers);
+
+    CHECK_OK(vl53l0x_deinit(handle));
+    vl53l0x_sim_delete(sim);
+    return 0;
+}
@@ -0,0 +1,409 @@
+/**
+ * @file bench_sigma.c
+ * @brief Sigma, quadrature sum and DMax against the ST code they replaced
+ *
+ * VL53L0X_quadrature_sum() and VL53L0X_calc_sigma_estimate() must match
+ * ST's originals bit for bit: random input pairs, and random samples on
+ * random timing configurations with cross-talk compensation on and off.
+ * VL53L0X_calc_dmax() is compared on a simulated sensor, where the
+ * original re-read the device parameters over I2C on every call: same
+ * values on a healthy bus, and no failure when the bus fails. Then both
+ * sigma versions are timed. Absolute times depend on the host.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "host_test.h"
+#include "vl53l0x_api.h"
+#include "vl53l0x_api_core.h"
+#include "vl53l0x_sim.h"
+#include "vl53l0x_sim_io.h"
+
+#define QUADRATURE_PAIRS    20000000u
+#define SIGMA_SAMPLES       20000000u
+#define SAMPLES_PER_CONFIG  64
+#define TIMED_CALLS         4000000u
+#define DMAX_STEPS          4096u
+
+// Not in the ST headers, but not static either
+VL53L0X_Error get_dmax_lut_points(VL53L0X_DMaxLUT_t data, uint32_t lut_size,
+                                  FixPoint1616_t input, int32_t* index0, int32_t* index1);
+
+static uint64_t rng_state = 88172645463325252ull;
+
+static uint32_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)rng_state;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * @brief ST's bit-by-bit square root, which the originals below call
+ */
+static uint32_t reference_isqrt(uint32_t num) {
+    uint32_t res = 0;
+    uint32_t bit = 1u << 30;
+
+    while (bit > num) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (num >= res + bit) {
+            num -= res + bit;
+            res = (res >> 1) + bit;
+        } else {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+    return res;
+}
+
+static uint32_t reference_quadrature_sum(uint32_t a, uint32_t b) {
+    if (a > 65535 || b > 65535) {
+        return 65535;
+    }
+    return reference_isqrt(a * a + b * b);
+}
+
+/**
+ * @brief VL53L0X_calc_sigma_estimate() as ST shipped it, comments trimmed
+ */
+static VL53L0X_Error reference_calc_sigma_estimate(VL53L0X_DEV Dev, VL53L0X_RangingMeasurementData_t* data,
+                                                   FixPoint1616_t* pSigmaEstimate) {
+    const uint32_t cPulseEffectiveWidth_centi_ns = 800;
+    const uint32_t cAmbientEffectiveWidth_centi_ns = 600;
+    const FixPoint1616_t cDfltFinalRangeIntegrationTimeMilliSecs = 0x00190000;
+    const uint32_t cVcselPulseWidth_ps = 4700;
+    const FixPoint1616_t cSigmaEstMax = 0x028F87AE;
+    const FixPoint1616_t cSigmaEstRtnMax = 0xF000;
+    const FixPoint1616_t cAmbToSignalRatioMax = 0xF0000000 / cAmbientEffectiveWidth_centi_ns;
+    const FixPoint1616_t cTOF_per_mm_ps = 0x0006999A;
+    const uint32_t c16BitRoundingParam = 0x00008000;
+    const FixPoint1616_t cMaxXTalk_kcps = 0x00320000;
+    const uint32_t cPllPeriod_ps = 1655;
+
+    uint32_t vcselTotalEventsRtn = 0;
+    uint32_t finalRangeTimeoutMicroSecs = 0;
+    uint32_t preRangeTimeoutMicroSecs = 0;
+    FixPoint1616_t xTalkCompRate_mcps;
+    FixPoint1616_t totalSignalRate_mcps;
+    VL53L0X_Error Status;
+
+    VL53L0X_GETPARAMETERFIELD(Dev, XTalkCompensationRateMegaCps, xTalkCompRate_mcps);
+    FixPoint1616_t ambientRate_kcps = (data->AmbientRateRtnMegaCps * 1000) >> 16;
+    Status = VL53L0X_get_total_signal_rate(Dev, data, &totalSignalRate_mcps);
+    Status = VL53L0X_get_total_xtalk_rate(Dev, data, &xTalkCompRate_mcps);
+
+    FixPoint1616_t peakSignalRate_kcps = totalSignalRate_mcps * 1000;
+    peakSignalRate_kcps = (peakSignalRate_kcps + 0x8000) >> 16;
+    uint32_t xTalkCompRate_kcps = xTalkCompRate_mcps * 1000;
+    if (xTalkCompRate_kcps > cMaxXTalk_kcps) {
+        xTalkCompRate_kcps = cMaxXTalk_kcps;
+    }
+
+    if (Status == VL53L0X_ERROR_NONE) {
+        finalRangeTimeoutMicroSecs = VL53L0X_GETDEVICESPECIFICPARAMETER(Dev, FinalRangeTimeoutMicroSecs);
+        uint8_t finalRangeVcselPCLKS = VL53L0X_GETDEVICESPECIFICPARAMETER(Dev, FinalRangeVcselPulsePeriod);
+        uint32_t finalRangeMacroPCLKS = VL53L0X_calc_timeout_mclks(Dev, finalRangeTimeoutMicroSecs,
+                                                                   finalRangeVcselPCLKS);
+        preRangeTimeoutMicroSecs = VL53L0X_GETDEVICESPECIFICPARAMETER(Dev, PreRangeTimeoutMicroSecs);
+        uint8_t preRangeVcselPCLKS = VL53L0X_GETDEVICESPECIFICPARAMETER(Dev, PreRangeVcselPulsePeriod);
+        uint32_t preRangeMacroPCLKS = VL53L0X_calc_timeout_mclks(Dev, preRangeTimeoutMicroSecs,
+                                                                 preRangeVcselPCLKS);
+        uint32_t vcselWidth = (finalRangeVcselPCLKS == 8) ? 2 : 3;
+
+        uint32_t peakVcselDuration_us = vcselWidth * 2048 * (preRangeMacroPCLKS + finalRangeMacroPCLKS);
+        peakVcselDuration_us = (peakVcselDuration_us + 500) / 1000;
+        peakVcselDuration_us *= cPllPeriod_ps;
+        peakVcselDuration_us = (peakVcselDuration_us + 500) / 1000;
+
+        totalSignalRate_mcps = (totalSignalRate_mcps + 0x80) >> 8;
+        vcselTotalEventsRtn = totalSignalRate_mcps * peakVcselDuration_us;
+        vcselTotalEventsRtn = (vcselTotalEventsRtn + 0x80) >> 8;
+        totalSignalRate_mcps <<= 8;
+    }
+
+    if (Status != VL53L0X_ERROR_NONE) {
+        return Status;
+    }
+
+    if (peakSignalRate_kcps == 0) {
+        *pSigmaEstimate = cSigmaEstMax;
+        PALDevDataSet(Dev, SigmaEstimate, cSigmaEstMax);
+        return Status;
+    }
+
+    if (vcselTotalEventsRtn < 1) {
+        vcselTotalEventsRtn = 1;
+    }
+    FixPoint1616_t sigmaEstimateP1 = cPulseEffectiveWidth_centi_ns;
+    FixPoint1616_t sigmaEstimateP2 = (ambientRate_kcps << 16) / peakSignalRate_kcps;
+    if (sigmaEstimateP2 > cAmbToSignalRatioMax) {
+        sigmaEstimateP2 = cAmbToSignalRatioMax;
+    }
+    sigmaEstimateP2 *= cAmbientEffectiveWidth_centi_ns;
+    FixPoint1616_t sigmaEstimateP3 = 2 * reference_isqrt(vcselTotalEventsRtn * 12);
+    FixPoint1616_t deltaT_ps = data->RangeMilliMeter * cTOF_per_mm_ps;
+
+    FixPoint1616_t diff1_mcps = (((peakSignalRate_kcps << 16) - 2 * xTalkCompRate_kcps) + 500) / 1000;
+    FixPoint1616_t diff2_mcps = ((peakSignalRate_kcps << 16) + 500) / 1000;
+    diff1_mcps <<= 8;
+    FixPoint1616_t xTalkCorrection = abs((int)(diff1_mcps / diff2_mcps));
+    xTalkCorrection <<= 8;
+
+    FixPoint1616_t pwMult;
+    if (data->RangeStatus != 0) {
+        pwMult = 1 << 16;
+    } else {
+        pwMult = deltaT_ps / cVcselPulseWidth_ps;
+        pwMult *= ((1 << 16) - xTalkCorrection);
+        pwMult = (pwMult + c16BitRoundingParam) >> 16;
+        pwMult += (1 << 16);
+        pwMult >>= 1;
+        pwMult = pwMult * pwMult;
+        pwMult >>= 14;
+    }
+
+    FixPoint1616_t sqr1 = pwMult * sigmaEstimateP1;
+    sqr1 = (sqr1 + 0x8000) >> 16;
+    sqr1 *= sqr1;
+    FixPoint1616_t sqr2 = sigmaEstimateP2;
+    sqr2 = (sqr2 + 0x8000) >> 16;
+    sqr2 *= sqr2;
+    FixPoint1616_t sqrtResult_centi_ns = reference_isqrt(sqr1 + sqr2);
+    sqrtResult_centi_ns <<= 16;
+
+    FixPoint1616_t sigmaEstRtn = ((sqrtResult_centi_ns + 50) / 100) / sigmaEstimateP3;
+    sigmaEstRtn *= VL53L0X_SPEED_OF_LIGHT_IN_AIR;
+    sigmaEstRtn += 5000;
+    sigmaEstRtn /= 10000;
+    if (sigmaEstRtn > cSigmaEstRtnMax) {
+        sigmaEstRtn = cSigmaEstRtnMax;
+    }
+    uint32_t finalRangeIntegrationTimeMilliSecs =
+        (finalRangeTimeoutMicroSecs + preRangeTimeoutMicroSecs + 500) / 1000;
+
+    FixPoint1616_t sigmaEstRef = reference_isqrt((cDfltFinalRangeIntegrationTimeMilliSecs +
+                                                  finalRangeIntegrationTimeMilliSecs / 2) /
+                                                 finalRangeIntegrationTimeMilliSecs);
+    sigmaEstRef <<= 8;
+    sigmaEstRef = (sigmaEstRef + 500) / 1000;
+
+    sqr1 = sigmaEstRtn * sigmaEstRtn;
+    sqr2 = sigmaEstRef * sigmaEstRef;
+    FixPoint1616_t sigmaEstimate = 1000 * reference_isqrt(sqr1 + sqr2);
+    if (peakSignalRate_kcps < 1 || vcselTotalEventsRtn < 1 || sigmaEstimate > cSigmaEstMax) {
+        sigmaEstimate = cSigmaEstMax;
+    }
+
+    *pSigmaEstimate = sigmaEstimate;
+    PALDevDataSet(Dev, SigmaEstimate, *pSigmaEstimate);
+    return Status;
+}
+
+/**
+ * @brief VL53L0X_calc_dmax() as ST shipped it: the LUT comes through
+ * VL53L0X_GetDeviceParameters(), which reads the device first
+ */
+static VL53L0X_Error reference_calc_dmax(VL53L0X_DEV Dev, FixPoint1616_t ambRateMeas, uint32_t* pdmax_mm) {
+    VL53L0X_DeviceParameters_t CurrentParameters;
+    int32_t index0 = 0;
+    int32_t index1 = 0;
+    FixPoint1616_t dmax_mm;
+
+    VL53L0X_Error Status = VL53L0X_GetDeviceParameters(Dev, &CurrentParameters);
+    const VL53L0X_DMaxLUT_t* lut = &CurrentParameters.dmax_lut;
+
+    if (ambRateMeas <= lut->ambRate_mcps[0]) {
+        dmax_mm = lut->dmax_mm[0];
+    } else if (ambRateMeas >= lut->ambRate_mcps[VL53L0X_DMAX_LUT_SIZE - 1]) {
+        dmax_mm = lut->dmax_mm[VL53L0X_DMAX_LUT_SIZE - 1];
+    } else {
+        get_dmax_lut_points(*lut, VL53L0X_DMAX_LUT_SIZE, ambRateMeas, &index0, &index1);
+        if (index0 == index1) {
+            dmax_mm = lut->dmax_mm[index0];
+        } else {
+            FixPoint1616_t amb0 = lut->ambRate_mcps[index0];
+            FixPoint1616_t amb1 = lut->ambRate_mcps[index1];
+            FixPoint1616_t dmax0 = lut->dmax_mm[index0];
+            FixPoint1616_t dmax1 = lut->dmax_mm[index1];
+            if ((amb1 - amb0) != 0) {
+                FixPoint1616_t linearSlope = (dmax0 - dmax1) / ((amb1 - amb0) >> 8);
+                dmax_mm = (((amb1 - ambRateMeas) >> 8) * linearSlope) + dmax1;
+            } else {
+                dmax_mm = dmax0;
+            }
+        }
+    }
+    *pdmax_mm = (uint32_t)(dmax_mm >> 16);
+    return Status;
+}
+
+static void random_sample(VL53L0X_RangingMeasurementData_t* data) {
+    memset(data, 0, sizeof(*data));
+    data->AmbientRateRtnMegaCps = next_random() % ((next_random() & 1) ? 0x40000 : 0x2000000);
+    data->SignalRateRtnMegaCps = next_random() % ((next_random() & 1) ? 0x400000 : 0x4000000);
+    data->RangeMilliMeter = next_random() % 8192;
+    data->RangeStatus = (next_random() % 4 == 0) ? 4 : 0;
+    data->EffectiveSpadRtnCount = next_random() % 0x8000;
+}
+
+/**
+ * @brief Timing configuration of one of the driver modes, with some jitter
+ */
+static void random_config(VL53L0X_DEV dev) {
+    static const uint32_t timeouts_us[] = { 2000, 12000, 22000, 26000, 180000, 300000 };
+
+    VL53L0X_SETDEVICESPECIFICPARAMETER(dev, FinalRangeTimeoutMicroSecs,
+                                       timeouts_us[next_random() % 6] + next_random() % 100);
+    VL53L0X_SETDEVICESPECIFICPARAMETER(dev, PreRangeTimeoutMicroSecs,
+                                       timeouts_us[next_random() % 3] + next_random() % 100);
+    VL53L0X_SETDEVICESPECIFICPARAMETER(dev, FinalRangeVcselPulsePeriod, (next_random() & 1) ? 10 : 14);
+    VL53L0X_SETDEVICESPECIFICPARAMETER(dev, PreRangeVcselPulsePeriod, (next_random() & 1) ? 14 : 18);
+    VL53L0X_SETPARAMETERFIELD(dev, XTalkCompensationEnable, next_random() & 1);
+    VL53L0X_SETPARAMETERFIELD(dev, XTalkCompensationRateMegaCps,
+                              (next_random() & 1) ? 0 : next_random() % 0x200);
+}
+
+static void check_quadrature_sum(void) {
+    uint32_t mismatches = 0;
+
+    for (uint32_t i = 0; i < QUADRATURE_PAIRS; i++) {
+        uint32_t a = next_random() % 70000;
+        uint32_t b = next_random() % 70000;
+        mismatches += VL53L0X_quadrature_sum(a, b) != reference_quadrature_sum(a, b);
+    }
+    printf("quadrature_sum: %u random pairs, %u mismatches\n", QUADRATURE_PAIRS, mismatches);
+    CHECK(mismatches == 0);
+}
+
+static void check_sigma(VL53L0X_DEV dev) {
+    VL53L0X_RangingMeasurementData_t data;
+    uint32_t mismatches = 0;
+
+    for (uint32_t i = 0; i < SIGMA_SAMPLES; i++) {
+        if (i % SAMPLES_PER_CONFIG == 0) {
+            random_config(dev);
+        }
+        random_sample(&data);
+        FixPoint1616_t reference = 0;
+        FixPoint1616_t sigma = 0;
+        VL53L0X_Error reference_status = reference_calc_sigma_estimate(dev, &data, &reference);
+        VL53L0X_Error status = VL53L0X_calc_sigma_estimate(dev, &data, &sigma);
+        mismatches += (status != reference_status || sigma != reference);
+    }
+    printf("calc_sigma_estimate: %u random samples, %u mismatches\n", SIGMA_SAMPLES, mismatches);
+    CHECK(mismatches == 0);
+}
+
+static void check_dmax(void) {
+    vl53l0x_sim_config_t sim_config = VL53L0X_SIM_DEFAULT_CONFIG();
+    vl53l0x_sim_handle_t sim;
+    vl53l0x_sim_stats_t st;
+    VL53L0X_Dev_t dev;
+    uint32_t mismatches = 0;
+    uint32_t reference_reads = 0;
+    uint32_t reads = 0;
+
+    memset(&dev, 0, sizeof(dev));
+    dev.comms_speed_khz = 400;
+    CHECK_OK(vl53l0x_sim_create(&sim_config, &sim));
+    dev.sim = sim;
+    CHECK_OK(vl53l0x_sim_attach(sim, &dev));
+    CHECK(VL53L0X_DataInit(&dev) == VL53L0X_ERROR_NONE);
+
+    // Past the last LUT point (15 Mcps) too
+    for (uint32_t i = 0; i < DMAX_STEPS; i++) {
+        FixPoint1616_t ambient = i * (0x00140000 / DMAX_STEPS);
+        uint32_t reference = 0;
+        uint32_t dmax = 0;
+
+        vl53l0x_sim_reset_stats(sim);
+        CHECK(reference_calc_dmax(&dev, ambient, &reference) == VL53L0X_ERROR_NONE);
+        CHECK_OK(vl53l0x_sim_get_stats(sim, &st));
+        reference_reads += st.reads;
+
+        vl53l0x_sim_reset_stats(sim);
+        CHECK(VL53L0X_calc_dmax(&dev, ambient, &dmax) == VL53L0X_ERROR_NONE);
+        CHECK_OK(vl53l0x_sim_get_stats(sim, &st));
+        reads += st.reads;
+        mismatches += dmax != reference;
+    }
+    printf("calc_dmax: %u ambient rates, %u mismatches, %.1f -> %.1f I2C reads per call\n", DMAX_STEPS,
+           mismatches, (double)reference_reads / DMAX_STEPS, (double)reads / DMAX_STEPS);
+    CHECK(mismatches == 0);
+
+    // A failed read used to fail the call, and with it the whole sample
+    uint32_t healthy = 0;
+    uint32_t reference = 0;
+    uint32_t dmax = 0;
+    CHECK(VL53L0X_calc_dmax(&dev, 0x00030000, &healthy) == VL53L0X_ERROR_NONE);
+    vl53l0x_sim_inject_fault(sim, VL53L0X_SIM_FAULT_BUS_ERROR, 1000000);
+    VL53L0X_Error reference_status = reference_calc_dmax(&dev, 0x00030000, &reference);
+    VL53L0X_Error status = VL53L0X_calc_dmax(&dev, 0x00030000, &dmax);
+    vl53l0x_sim_inject_fault(sim, VL53L0X_SIM_FAULT_NONE, 0);
+    printf("calc_dmax on a failing bus: ST status %d, now status %d and %lu mm\n", reference_status, status,
+           (unsigned long)dmax);
+    CHECK(reference_status != VL53L0X_ERROR_NONE);
+    CHECK(status == VL53L0X_ERROR_NONE && dmax == healthy);
+
+    vl53l0x_sim_detach(sim);
+    vl53l0x_sim_delete(sim);
+}
+
+static double time_sigma(VL53L0X_Error (*fn)(VL53L0X_DEV, VL53L0X_RangingMeasurementData_t*, FixPoint1616_t*),
+                         VL53L0X_DEV dev, VL53L0X_RangingMeasurementData_t* samples, uint32_t count,
+                         uint32_t* checksum) {
+    FixPoint1616_t sigma;
+    uint32_t sum = 0;
+    double start = now_ns();
+
+    for (uint32_t i = 0; i < TIMED_CALLS; i++) {
+        fn(dev, &samples[i % count], &sigma);
+        sum += sigma;
+    }
+    *checksum = sum;
+    return (now_ns() - start) / TIMED_CALLS;
+}
+
+int main(void) {
+    static VL53L0X_RangingMeasurementData_t samples[4096];
+    VL53L0X_Dev_t device;
+    VL53L0X_DEV dev = &device;
+
+    memset(&device, 0, sizeof(device));
+    check_quadrature_sum();
+    check_sigma(dev);
+    check_dmax();
+
+    for (uint32_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+        random_sample(&samples[i]);
+        samples[i].RangeStatus = 0;
+    }
+    for (int xtalk = 0; xtalk < 2; xtalk++) {
+        uint32_t reference_sum;
+        uint32_t sum;
+
+        random_config(dev);
+        VL53L0X_SETDEVICESPECIFICPARAMETER(dev, FinalRangeTimeoutMicroSecs, 22000);
+        VL53L0X_SETDEVICESPECIFICPARAMETER(dev, PreRangeTimeoutMicroSecs, 2000);
+        VL53L0X_SETPARAMETERFIELD(dev, XTalkCompensationEnable, xtalk);
+        VL53L0X_SETPARAMETERFIELD(dev, XTalkCompensationRateMegaCps, xtalk ? 0x40 : 0);
+        double reference_ns = time_sigma(reference_calc_sigma_estimate, dev, samples, 4096, &reference_sum);
+        double ns = time_sigma(VL53L0X_calc_sigma_estimate, dev, samples, 4096, &sum);
+        CHECK(sum == reference_sum);
+        printf("calc_sigma_estimate, cross-talk %s: ST %5.1f ns/call, now %5.1f ns/call\n",
+               xtalk ? "on " : "off", reference_ns, ns);
+    }
+    return 0;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file bench_single_shot.c
+ * @brief Bus cost of one single-shot sample, and the share spent polling
+ *
+ * The polls are the data-ready reads that GPIO1 (config.gpio_int_pin)
+ * replaces with an edge; the simulator does not drive the GPIO1 line, so
+ * the interrupt path itself is not timed here.
+ */
+
+#include <stdio.h>
+#include "host_test.h"
+#include "vl53l0x_driver.h"
+#include "vl53l0x_sim.h"
+
+#define SAMPLES     20
+
+static void run(vl53l0x_mode_t mode) {
+    vl53l0x_sim_config_t sim_config = VL53L0X_SIM_DEFAULT_CONFIG();
+    vl53l0x_sim_handle_t sim;
+    vl53l0x_handle_t handle;
+    vl53l0x_measurement_t m;
+    vl53l0x_wait_stats_t wait;
+    vl53l0x_sim_stats_t st;
+
+    CHECK_OK(vl53l0x_sim_create(&sim_config, &sim));
+    vl53l0x_config_t config = VL53L0X_DEFAULT_CONFIG();
+    config.simulator = sim;
+    config.mode = mode;
+    CHECK_OK(vl53l0x_init(&config, &handle));
+    CHECK_OK(vl53l0x_read_single(handle, &m));
+
+    vl53l0x_sim_reset_stats(sim);
+    CHECK_OK(vl53l0x_reset_wait_stats(handle));
+    for (int i = 0; i < SAMPLES; i++) {
+        CHECK_OK(vl53l0x_read_single(handle, &m));
+        CHECK(m.is_valid);
+    }
+    CHECK_OK(vl53l0x_sim_get_stats(sim, &st));
+    CHECK_OK(vl53l0x_get_wait_stats(handle, &wait));
+
+    printf("%-14s %5.1f transfers (%4.1f reads, %4.1f data-ready polls), %5.0f bytes, %6.0f us bus per sample\n",
+           vl53l0x_get_mode_name(mode), (double)(st.reads + st.writes) / SAMPLES, (double)st.reads / SAMPLES,
+           (double)wait.data_ready_polls / SAMPLES, (double)st.bytes / SAMPLES, (double)st.bus_us / SAMPLES);
+
+    CHECK_OK(vl53l0x_deinit(handle));
+    vl53l0x_sim_delete(sim);
+}
+
+int main(void) {
+    printf("vl53l0x_read_single(), %d samples, 400 kHz\n", SAMPLES);
+    run(VL53L0X_MODE_DEFAULT);
+    run(VL53L0X_MODE_HIGH_SPEED);
+    run(VL53L0X_MODE_HIGH_ACCURACY);
+    return 0;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file bench_snapshot.c
+ * @brief Cost of obstacle_detection_get_snapshot() over six zones
+ *
+ * Six simulated zones, read once with the scheduler stopped (no writer,
+ * every read succeeds first time) and once while it ranges every zone as
+ * fast as HIGH_SPEED allows, when a read can hit a publish and retry.
+ * Absolute times depend on the host.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "host_test.h"
+#include "obstacle_detection.h"
+#include "vl53l0x_sim.h"
+
+#define NUM_ZONES   6
+#define READS       1000000u
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void on_event(obstacle_zone_t zone, uint16_t distance_mm, obstacle_event_t event, void* user_data) {
+    (void)zone;
+    (void)distance_mm;
+    (void)event;
+    (void)user_data;
+}
+
+static void measure(const char* title) {
+    obstacle_snapshot_t snapshot;
+    uint32_t timeouts = 0;
+    double start = now_ns();
+
+    for (uint32_t i = 0; i < READS; i++) {
+        timeouts += obstacle_detection_get_snapshot(&snapshot) == ESP_ERR_TIMEOUT;
+    }
+    printf("  %-22s %5.1f ns per snapshot (%lu timeouts)\n", title, (now_ns() - start) / READS,
+           (unsigned long)timeouts);
+}
+
+int main(void) {
+    obstacle_zone_config_t zones[NUM_ZONES];
+    vl53l0x_sim_handle_t sims[NUM_ZONES];
+
+    memset(zones, 0, sizeof(zones));
+    for (int i = 0; i < NUM_ZONES; i++) {
+        vl53l0x_sim_config_t sim_config = VL53L0X_SIM_DEFAULT_CONFIG();
+        sim_config.seed = 5 + i;
+        sim_config.uid_lower = i + 1;
+        sim_config.distance_mm = 600 + 100 * i;
+        CHECK_OK(vl53l0x_sim_create(&sim_config, &sims[i]));
+
+        zones[i].zone = (obstacle_zone_t)i;
+        zones[i].scl_pin = GPIO_NUM_5;
+        zones[i].sda_pin = GPIO_NUM_6;
+        zones[i].xshut_pin = (gpio_num_t)(GPIO_NUM_10 + i);
+        zones[i].gpio_int_pin = GPIO_NUM_NC;
+        zones[i].warning_distance_mm = 300;
+        zones[i].critical_distance_mm = 150;
+        zones[i].mode = VL53L0X_MODE_HIGH_SPEED;
+        zones[i].enabled = true;
+        zones[i].simulator = sims[i];
+    }
+    CHECK_OK(obstacle_detection_init(zones, NUM_ZONES));
+
+    printf("%d zones, %u reads\n", NUM_ZONES, READS);
+    measure("scheduler stopped");
+    CHECK_OK(obstacle_detection_start(on_event, NULL));
+    measure("scheduler ranging");
+    CHECK_OK(obstacle_detection_deinit());
+
+    for (int i = 0; i < NUM_ZONES; i++) {
+        vl53l0x_sim_delete(sims[i]);
+    }
+    return 0;
+}
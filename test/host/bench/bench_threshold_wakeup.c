@@ -0,0 +1,140 @@
+/**
+ * @file bench_threshold_wakeup.c
+ * @brief Bus load of continuous ranging, every sample read vs on-sensor thresholds
+ *
+ * HIGH_SPEED, target idle at 1000 mm for 2 s, then closing to 30 mm at
+ * 400 mm/s, 0.5 s there and back out at the same speed. The callback sorts
+ * samples into clear / warning (<= 100 mm) / critical (<= 50 mm) bands and,
+ * in threshold mode, keeps the window on the current band like
+ * obstacle_detection does. The simulator does not drive GPIO1, so only the
+ * polled threshold path is measured.
+ */
+
+#include <stdio.h>
+#include "host_test.h"
+#include "vl53l0x_driver.h"
+#include "vl53l0x_sim.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define IDLE_S      2.0
+#define SPEED_MM_S  400.0
+#define FAR_MM      1000.0
+#define NEAR_MM     30.0
+#define HOLD_S      0.5
+#define WARNING_MM  100
+#define CRITICAL_MM 50
+#define MAX_EVENTS  16
+
+typedef enum { BAND_CLEAR, BAND_WARNING, BAND_CRITICAL, BAND_INVALID } band_t;
+
+static const char* const band_names[] = { "clear", "warning", "critical", "invalid" };
+
+static struct {
+    vl53l0x_handle_t handle;
+    bool threshold;
+    int64_t start_us;
+    band_t band;
+    band_t window;
+    int callbacks;
+    int events;
+    band_t event_band[MAX_EVENTS];
+    int64_t event_ms[MAX_EVENTS];
+} run;
+
+static uint16_t target_mm(int64_t time_us, void* user_data) {
+    (void)user_data;
+    double travel_s = (FAR_MM - NEAR_MM) / SPEED_MM_S;
+    double s = (double)(time_us - run.start_us) / 1e6;
+    if (s < IDLE_S) {
+        return (uint16_t)FAR_MM;
+    }
+    s -= IDLE_S;
+    if (s < travel_s) {
+        return (uint16_t)(FAR_MM - SPEED_MM_S * s);
+    }
+    s -= travel_s;
+    if (s < HOLD_S) {
+        return (uint16_t)NEAR_MM;
+    }
+    s -= HOLD_S;
+    return (uint16_t)((s < travel_s) ? NEAR_MM + SPEED_MM_S * s : FAR_MM);
+}
+
+static void on_sample(const vl53l0x_measurement_t* m, void* user_data) {
+    (void)user_data;
+    band_t band = !m->is_valid ? BAND_INVALID :
+                  (m->distance_mm <= CRITICAL_MM) ? BAND_CRITICAL :
+                  (m->distance_mm <= WARNING_MM) ? BAND_WARNING : BAND_CLEAR;
+    run.callbacks++;
+
+    if (run.threshold && band != BAND_INVALID && band != run.window) {
+        uint16_t low = (band == BAND_CRITICAL) ? 0 : (band == BAND_WARNING) ? CRITICAL_MM + 1 : WARNING_MM + 1;
+        uint16_t high = (band == BAND_CRITICAL) ? CRITICAL_MM :
+                        (band == BAND_WARNING) ? WARNING_MM : VL53L0X_THRESHOLD_MAX_MM;
+        if (vl53l0x_set_threshold_window(run.handle, low, high) == ESP_OK) {
+            run.window = band;
+        }
+    }
+    if (band != run.band) {
+        if (run.events < MAX_EVENTS) {
+            run.event_band[run.events] = band;
+            run.event_ms[run.events] = (m->timestamp_us - run.start_us) / 1000;
+        }
+        run.events++;
+        run.band = band;
+    }
+}
+
+static void measure(const char* title, bool threshold) {
+    vl53l0x_sim_config_t sim_config = VL53L0X_SIM_DEFAULT_CONFIG();
+    vl53l0x_sim_handle_t sim;
+    vl53l0x_sim_stats_t idle;
+    vl53l0x_sim_stats_t all;
+    double travel_s = (FAR_MM - NEAR_MM) / SPEED_MM_S;
+    int run_ms = (int)((2 * travel_s + HOLD_S + 0.5) * 1000);
+
+    sim_config.noise_mm = 4;
+    sim_config.range_fn = target_mm;
+    CHECK_OK(vl53l0x_sim_create(&sim_config, &sim));
+    vl53l0x_config_t config = VL53L0X_DEFAULT_CONFIG();
+    config.simulator = sim;
+    config.mode = VL53L0X_MODE_HIGH_SPEED;
+    CHECK_OK(vl53l0x_init(&config, &run.handle));
+
+    run.threshold = threshold;
+    run.band = run.window = (band_t)-1;
+    run.callbacks = 0;
+    run.events = 0;
+    run.start_us = esp_timer_get_time() + 200000;
+    if (threshold) {
+        CHECK_OK(vl53l0x_set_threshold_window(run.handle, 0, 0));
+    }
+    CHECK_OK(vl53l0x_start_continuous(run.handle, on_sample, NULL));
+    vTaskDelay(pdMS_TO_TICKS(200));
+    vl53l0x_sim_reset_stats(sim);
+    vTaskDelay(pdMS_TO_TICKS((int)(IDLE_S * 1000)));
+    CHECK_OK(vl53l0x_sim_get_stats(sim, &idle));
+    vTaskDelay(pdMS_TO_TICKS(run_ms));
+    CHECK_OK(vl53l0x_sim_get_stats(sim, &all));
+    CHECK_OK(vl53l0x_stop_continuous(run.handle));
+
+    printf("%-20s idle bus %5.2f%% | whole run %5lu transfers, %6llu bytes, %4d callbacks\n   events:", title,
+           (double)idle.bus_us / (IDLE_S * 1e6) * 100.0, (unsigned long)(all.reads + all.writes),
+           (unsigned long long)all.bytes, run.callbacks);
+    for (int i = 0; i < run.events && i < MAX_EVENTS; i++) {
+        printf(" %s@%lld", band_names[run.event_band[i]], (long long)run.event_ms[i]);
+    }
+    printf("\n");
+
+    CHECK_OK(vl53l0x_deinit(run.handle));
+    vl53l0x_sim_delete(sim);
+}
+
+int main(void) {
+    printf("HIGH_SPEED, band changes in ms from the start of the profile\n");
+    measure("read every sample", false);
+    measure("threshold window", true);
+    return 0;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file bench_write_batching.c
+ * @brief Transfers issued by VL53L0X_StaticInit() with and without a batch section
+ *
+ * StaticInit loads the tuning table, mostly single-byte writes to
+ * consecutive registers; inside vl53l0x_batch_begin()/vl53l0x_batch_end()
+ * the platform layer merges them. The 0xFF page cache is on in both runs.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "host_test.h"
+#include "vl53l0x_api.h"
+#include "vl53l0x_bus.h"
+#include "vl53l0x_sim.h"
+#include "vl53l0x_sim_io.h"
+#include "vl53l0x_platform.h"
+
+static void run(bool batched) {
+    vl53l0x_sim_config_t sim_config = VL53L0X_SIM_DEFAULT_CONFIG();
+    vl53l0x_sim_handle_t sim;
+    vl53l0x_sim_stats_t st;
+    VL53L0X_Dev_t dev;
+
+    memset(&dev, 0, sizeof(dev));
+    dev.I2cDevAddr = 0x29;
+    dev.comms_speed_khz = 400;
+    CHECK_OK(vl53l0x_sim_create(&sim_config, &sim));
+    dev.sim = sim;
+    CHECK_OK(vl53l0x_sim_attach(sim, &dev));
+    CHECK(VL53L0X_DataInit(&dev) == VL53L0X_ERROR_NONE);
+
+    vl53l0x_sim_reset_stats(sim);
+    if (batched) {
+        vl53l0x_batch_begin(&dev);
+    }
+    CHECK(VL53L0X_StaticInit(&dev) == VL53L0X_ERROR_NONE);
+    if (batched) {
+        CHECK(vl53l0x_batch_end(&dev) == VL53L0X_ERROR_NONE);
+    }
+    CHECK_OK(vl53l0x_sim_get_stats(sim, &st));
+
+    printf("%-10s %4lu writes, %4lu reads, %5llu bytes, %6.2f ms bus\n", batched ? "batched" : "unbatched",
+           (unsigned long)st.writes, (unsigned long)st.reads, (unsigned long long)st.bytes,
+           (double)st.bus_us / 1000.0);
+
+    vl53l0x_sim_detach(sim);
+    vl53l0x_sim_delete(sim);
+}
+
+int main(void) {
+    printf("VL53L0X_StaticInit(), 400 kHz\n");
+    run(false);
+    run(true);
+    return 0;
+}
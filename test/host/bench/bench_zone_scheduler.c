@@ -0,0 +1,231 @@
+/**
+ * @file bench_zone_scheduler.c
+ * @brief Tasks, per-zone rate and bus load of six zones under the shared scheduler
+ *
+ * Six simulated HIGH_SPEED zones behind XSHUT pins, ranged for 3 s with
+ * no rate budget, 8 Hz each and a mixed 30/15/15/10/10/5 Hz budget, once
+ * through obstacle_detection and once with a vl53l0x_start_continuous()
+ * task per sensor, the design the scheduler replaced. Each sample's
+ * ranging window is rebuilt from its completion time and the programmed
+ * measurement time, to tell how much of it another sensor spent ranging
+ * too.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "host_test.h"
+#include "obstacle_detection.h"
+#include "vl53l0x_sim.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define NUM_ZONES   6
+#define RUN_MS      3000
+#define MAX_SAMPLES 4096
+
+static struct {
+    int64_t done_us[NUM_ZONES][MAX_SAMPLES];
+    int count[NUM_ZONES];
+    bool recording;
+} windows;
+
+static uint32_t task_samples[NUM_ZONES];
+
+static uint16_t zone_range(int64_t time_us, void* user_data) {
+    int zone = (int)(intptr_t)user_data;
+    if (windows.recording && windows.count[zone] < MAX_SAMPLES) {
+        windows.done_us[zone][windows.count[zone]++] = time_us;
+    }
+    return (uint16_t)(600 + 100 * zone);
+}
+
+static void on_event(obstacle_zone_t zone, uint16_t distance_mm, obstacle_event_t event, void* user_data) {
+    (void)zone;
+    (void)distance_mm;
+    (void)event;
+    (void)user_data;
+}
+
+static void on_sample(const vl53l0x_measurement_t* measurement, void* user_data) {
+    (void)measurement;
+    task_samples[(intptr_t)user_data]++;
+}
+
+/**
+ * @brief Fraction of all ranging time during which some other zone was ranging too
+ *
+ * Marks the zones ranging in each 10 us slot of the run, then counts the
+ * slots of every zone that carry more than one mark.
+ */
+static double shared_ranging(int64_t start_us, const uint32_t measurement_us[NUM_ZONES]) {
+    static uint8_t ranging[(RUN_MS + 100) * 100];
+    const int64_t slots = sizeof(ranging);
+    uint64_t busy = 0;
+    uint64_t shared = 0;
+
+    memset(ranging, 0, sizeof(ranging));
+    for (int z = 0; z < NUM_ZONES; z++) {
+        for (int i = 0; i < windows.count[z]; i++) {
+            int64_t end = (windows.done_us[z][i] - start_us) / 10;
+            int64_t begin = end - measurement_us[z] / 10;
+            for (int64_t t = begin < 0 ? 0 : begin; t < end && t < slots; t++) {
+                ranging[t] |= 1u << z;
+            }
+        }
+    }
+    for (int64_t t = 0; t < slots; t++) {
+        int zones = __builtin_popcount(ranging[t]);
+        busy += zones;
+        shared += zones > 1 ? zones : 0;
+    }
+    return busy ? 100.0 * (double)shared / (double)busy : 0.0;
+}
+
+static void create_sims(vl53l0x_sim_handle_t sims[NUM_ZONES]) {
+    for (int i = 0; i < NUM_ZONES; i++) {
+        vl53l0x_sim_config_t sim_config = VL53L0X_SIM_DEFAULT_CONFIG();
+        sim_config.seed = 3 + i;
+        sim_config.uid_lower = i + 1;
+        sim_config.range_fn = zone_range;
+        sim_config.range_user_data = (void*)(intptr_t)i;
+        CHECK_OK(vl53l0x_sim_create(&sim_config, &sims[i]));
+    }
+}
+
+static void begin_recording(vl53l0x_sim_handle_t sims[NUM_ZONES]) {
+    memset(windows.count, 0, sizeof(windows.count));
+    for (int i = 0; i < NUM_ZONES; i++) {
+        vl53l0x_sim_reset_stats(sims[i]);
+    }
+    windows.recording = true;
+}
+
+/**
+ * @brief Print one run and delete its simulators
+ */
+static void report(const char* title, const uint16_t rates[NUM_ZONES], const obstacle_detection_stats_t* stats,
+                   vl53l0x_sim_handle_t sims[NUM_ZONES], const vl53l0x_sim_stats_t st[NUM_ZONES],
+                   int64_t start_us) {
+    uint32_t measurement_us[NUM_ZONES];
+    uint64_t bus_us = 0;
+    uint32_t transfers = 0;
+    uint32_t samples = 0;
+
+    printf("%s\n  tasks %u, ranging stack %lu bytes\n", title, stats->tasks, (unsigned long)stats->stack_bytes);
+    for (int i = 0; i < NUM_ZONES; i++) {
+        printf("  zone %d budget %2u Hz: %5.1f Hz (%lu missed slots)\n", i, rates[i], stats->zones[i].rate_hz,
+               (unsigned long)stats->zones[i].missed_slots);
+        measurement_us[i] = st[i].measurement_us;
+        bus_us += st[i].bus_us;
+        transfers += st[i].reads + st[i].writes;
+        samples += st[i].samples;
+    }
+    printf("  bus %.1f%% of 400 kHz, %.1f transfers per sample\n", (double)bus_us / (RUN_MS * 10.0),
+           samples ? (double)transfers / samples : 0.0);
+    printf("  ranging time shared with another zone %.1f%%\n", shared_ranging(start_us, measurement_us));
+
+    for (int i = 0; i < NUM_ZONES; i++) {
+        vl53l0x_sim_delete(sims[i]);
+    }
+}
+
+static void run(const char* title, const uint16_t rates[NUM_ZONES]) {
+    obstacle_zone_config_t zones[NUM_ZONES];
+    vl53l0x_sim_handle_t sims[NUM_ZONES];
+    vl53l0x_sim_stats_t st[NUM_ZONES];
+    obstacle_detection_stats_t stats;
+
+    create_sims(sims);
+    memset(zones, 0, sizeof(zones));
+    for (int i = 0; i < NUM_ZONES; i++) {
+        zones[i].zone = (obstacle_zone_t)i;
+        zones[i].scl_pin = GPIO_NUM_5;
+        zones[i].sda_pin = GPIO_NUM_6;
+        zones[i].xshut_pin = (gpio_num_t)(GPIO_NUM_10 + i);
+        zones[i].gpio_int_pin = GPIO_NUM_NC;
+        zones[i].warning_distance_mm = 300;
+        zones[i].critical_distance_mm = 150;
+        zones[i].mode = VL53L0X_MODE_HIGH_SPEED;
+        zones[i].rate_hz = rates[i];
+        zones[i].enabled = true;
+        zones[i].simulator = sims[i];
+    }
+    CHECK_OK(obstacle_detection_init(zones, NUM_ZONES));
+
+    begin_recording(sims);
+    int64_t start_us = esp_timer_get_time();
+    CHECK_OK(obstacle_detection_start(on_event, NULL));
+    vTaskDelay(pdMS_TO_TICKS(RUN_MS));
+    windows.recording = false;
+    CHECK_OK(obstacle_detection_get_stats(&stats));
+    for (int i = 0; i < NUM_ZONES; i++) {
+        CHECK_OK(vl53l0x_sim_get_stats(sims[i], &st[i]));
+    }
+    CHECK_OK(obstacle_detection_deinit());
+
+    report(title, rates, &stats, sims, st, start_us);
+}
+
+/**
+ * @brief The same zones with the driver's continuous task on every sensor
+ */
+static void run_tasks(const char* title, const uint16_t rates[NUM_ZONES]) {
+    vl53l0x_config_t configs[NUM_ZONES];
+    vl53l0x_handle_t handles[NUM_ZONES];
+    vl53l0x_sim_handle_t sims[NUM_ZONES];
+    vl53l0x_sim_stats_t st[NUM_ZONES];
+    obstacle_detection_stats_t stats;
+
+    create_sims(sims);
+    for (int i = 0; i < NUM_ZONES; i++) {
+        vl53l0x_config_t config = VL53L0X_DEFAULT_CONFIG();
+        config.simulator = sims[i];
+        config.mode = VL53L0X_MODE_HIGH_SPEED;
+        config.fixed_mode = true;
+        config.i2c_address = 0x29 + i;
+        config.xshut_pin = (gpio_num_t)(GPIO_NUM_10 + i);
+        config.target_rate_hz = rates[i];
+        config.history_depth = 2;
+        configs[i] = config;
+    }
+    CHECK_OK(vl53l0x_init_multi(configs, NUM_ZONES, handles));
+
+    memset(&stats, 0, sizeof(stats));
+    memset(task_samples, 0, sizeof(task_samples));
+    begin_recording(sims);
+    int64_t start_us = esp_timer_get_time();
+    for (int i = 0; i < NUM_ZONES; i++) {
+        CHECK_OK(vl53l0x_start_continuous(handles[i], on_sample, (void*)(intptr_t)i));
+    }
+    vTaskDelay(pdMS_TO_TICKS(RUN_MS));
+    windows.recording = false;
+    float elapsed_s = (esp_timer_get_time() - start_us) / 1e6f;
+    for (int i = 0; i < NUM_ZONES; i++) {
+        vl53l0x_footprint_t footprint;
+        CHECK_OK(vl53l0x_get_footprint(handles[i], &footprint));
+        CHECK_OK(vl53l0x_sim_get_stats(sims[i], &st[i]));
+        stats.tasks += footprint.task_stack_bytes > 0;
+        stats.stack_bytes += footprint.task_stack_bytes;
+        stats.zones[i].rate_hz = task_samples[i] / elapsed_s;
+    }
+    for (int i = 0; i < NUM_ZONES; i++) {
+        CHECK_OK(vl53l0x_deinit(handles[i]));
+    }
+
+    report(title, rates, &stats, sims, st, start_us);
+}
+
+int main(void) {
+    static const uint16_t unlimited[NUM_ZONES] = { 0, 0, 0, 0, 0, 0 };
+    static const uint16_t spread[NUM_ZONES] = { 8, 8, 8, 8, 8, 8 };
+    static const uint16_t mixed[NUM_ZONES] = { 30, 15, 15, 10, 10, 5 };
+
+    run("HIGH_SPEED, no rate budget", unlimited);
+    run("HIGH_SPEED, 8 Hz each", spread);
+    run("HIGH_SPEED, 30/15/15/10/10/5 Hz", mixed);
+    run_tasks("HIGH_SPEED, no rate budget, a task per sensor", unlimited);
+    run_tasks("HIGH_SPEED, 8 Hz each, a task per sensor", spread);
+    run_tasks("HIGH_SPEED, 30/15/15/10/10/5 Hz, a task per sensor", mixed);
+    return 0;
+}
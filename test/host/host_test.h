@@ -0,0 +1,27 @@
+/**
+ * @file host_test.h
+ * @brief Minimal checks for the host tests: report the failing line and exit
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHECK(cond) do {                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                            \
+        }                                                                       \
+    } while (0)
+
+#define CHECK_OK(expr) do {                                                     \
+        int check_ret_ = (int)(expr);                                           \
+        if (check_ret_ != 0) {                                                  \
+            fprintf(stderr, "%s:%d: %s returned 0x%x\n", __FILE__, __LINE__, #expr, check_ret_); \
+            exit(1);                                                            \
+        }                                                                       \
+    } while (0)
+
+#endif // HOST_TEST_H
@@ -0,0 +1,592 @@
+/**
+ * @file host_port.c
+ * @brief ESP-IDF and FreeRTOS services the components use, on top of POSIX
+ *
+ * Tasks are threads, mutexes are pthread mutexes and critical sections share
+ * one recursive mutex. Task priorities and core affinity are ignored. The
+ * I2C controllers pass transfers to the target set with host_i2c_set_target();
+ * without one nothing answers, and sensors are attached through the
+ * register-level simulator instead.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "driver/gpio.h"
+#include "driver/i2c_master.h"
+#include "soc/soc_caps.h"
+#include "nvs.h"
+#include "host_port.h"
+
+/* ---------------------------------------------------------------------------
+ * Time
+ * ------------------------------------------------------------------------- */
+
+static int64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void sleep_us(int64_t us) {
+    if (us <= 0) {
+        sched_yield();
+        return;
+    }
+    struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000 };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+static struct timespec deadline_after_us(int64_t us) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += us / 1000000;
+    ts.tv_nsec += (us % 1000000) * 1000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return ts;
+}
+
+int64_t esp_timer_get_time(void) {
+    return monotonic_us();
+}
+
+void esp_rom_delay_us(uint32_t us) {
+    // Sleeps instead of spinning, so other tasks keep running on a single host CPU
+    sleep_us(us);
+}
+
+const char *esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK:                    return "ESP_OK";
+        case ESP_FAIL:                  return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:            return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:       return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:     return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:      return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:         return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED:     return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:           return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_INVALID_RESPONSE:  return "ESP_ERR_INVALID_RESPONSE";
+        case ESP_ERR_INVALID_CRC:       return "ESP_ERR_INVALID_CRC";
+        case ESP_ERR_INVALID_VERSION:   return "ESP_ERR_INVALID_VERSION";
+        case ESP_ERR_NOT_FINISHED:      return "ESP_ERR_NOT_FINISHED";
+        case ESP_ERR_NVS_NOT_FOUND:     return "ESP_ERR_NVS_NOT_FOUND";
+        default:                        return "UNKNOWN ERROR";
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * Critical sections
+ * ------------------------------------------------------------------------- */
+
+static pthread_mutex_t critical_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+void vPortEnterCritical(void) {
+    pthread_mutex_lock(&critical_lock);
+}
+
+void vPortExitCritical(void) {
+    pthread_mutex_unlock(&critical_lock);
+}
+
+/* ---------------------------------------------------------------------------
+ * Tasks and notifications
+ * ------------------------------------------------------------------------- */
+
+struct host_task_s {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify;
+    TaskFunction_t fn;
+    void *arg;
+};
+
+static __thread TaskHandle_t current_task;
+
+static TaskHandle_t new_task(TaskFunction_t fn, void *arg) {
+    TaskHandle_t task = calloc(1, sizeof(*task));
+    if (!task) {
+        return NULL;
+    }
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&task->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&task->lock, NULL);
+    task->fn = fn;
+    task->arg = arg;
+    return task;
+}
+
+static void *task_entry(void *arg) {
+    current_task = (TaskHandle_t)arg;
+    current_task->fn(current_task->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                       UBaseType_t priority, TaskHandle_t *created_task) {
+    (void)name;
+    (void)stack_depth;
+    (void)priority;
+
+    TaskHandle_t task = new_task(fn, arg);
+    if (!task) {
+        return pdFAIL;
+    }
+    if (created_task) {
+        *created_task = task;
+    }
+    if (pthread_create(&task->thread, NULL, task_entry, task) != 0) {
+        free(task);
+        return pdFAIL;
+    }
+    pthread_detach(task->thread);
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    // Only self-deletion is used. The task record is never freed, so a late
+    // notification to a finished task does not touch freed memory.
+    if (!task || task == current_task) {
+        pthread_exit(NULL);
+    }
+    abort();
+}
+
+void vTaskDelay(TickType_t ticks) {
+    sleep_us((int64_t)ticks * portTICK_PERIOD_MS * 1000);
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(monotonic_us() / 1000 / portTICK_PERIOD_MS);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    if (!current_task) {
+        // Threads not created through xTaskCreate (main, test threads) get a record on first use
+        current_task = new_task(NULL, NULL);
+    }
+    return current_task;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait) {
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    struct timespec deadline = deadline_after_us((int64_t)ticks_to_wait * portTICK_PERIOD_MS * 1000);
+
+    pthread_mutex_lock(&task->lock);
+    while (task->notify == 0 && ticks_to_wait != 0) {
+        int ret = (ticks_to_wait == portMAX_DELAY)
+                      ? pthread_cond_wait(&task->cond, &task->lock)
+                      : pthread_cond_timedwait(&task->cond, &task->lock, &deadline);
+        if (ret == ETIMEDOUT) {
+            break;
+        }
+    }
+    uint32_t value = task->notify;
+    if (clear_on_exit) {
+        task->notify = 0;
+    } else if (value > 0) {
+        task->notify--;
+    }
+    pthread_mutex_unlock(&task->lock);
+
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    pthread_mutex_lock(&task->lock);
+    task->notify++;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken) {
+    xTaskNotifyGive(task);
+    if (higher_priority_task_woken) {
+        *higher_priority_task_woken = pdFALSE;
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * Mutexes
+ * ------------------------------------------------------------------------- */
+
+struct host_mutex_s {
+    pthread_mutex_t lock;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    SemaphoreHandle_t mutex = calloc(1, sizeof(*mutex));
+    if (mutex) {
+        pthread_mutex_init(&mutex->lock, NULL);
+    }
+    return mutex;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks_to_wait) {
+    if (ticks_to_wait == portMAX_DELAY) {
+        return pthread_mutex_lock(&mutex->lock) == 0 ? pdTRUE : pdFALSE;
+    }
+
+    int64_t deadline_us = monotonic_us() + (int64_t)ticks_to_wait * portTICK_PERIOD_MS * 1000;
+    while (pthread_mutex_trylock(&mutex->lock) != 0) {
+        if (monotonic_us() >= deadline_us) {
+            return pdFALSE;
+        }
+        sleep_us(100);
+    }
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex) {
+    return pthread_mutex_unlock(&mutex->lock) == 0 ? pdTRUE : pdFALSE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t mutex) {
+    if (mutex) {
+        pthread_mutex_destroy(&mutex->lock);
+        free(mutex);
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * GPIO
+ * ------------------------------------------------------------------------- */
+
+static uint8_t gpio_levels[GPIO_NUM_MAX];
+
+esp_err_t gpio_config(const gpio_config_t *config) {
+    return (config && config->pin_bit_mask >> GPIO_NUM_MAX == 0) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+    if (gpio_num < 0 || gpio_num >= GPIO_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    gpio_levels[gpio_num] = level ? 1 : 0;
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num) {
+    return (gpio_num >= 0 && gpio_num < GPIO_NUM_MAX) ? gpio_levels[gpio_num] : 0;
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags) {
+    (void)intr_alloc_flags;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void *args) {
+    (void)isr_handler;
+    (void)args;
+    return (gpio_num >= 0 && gpio_num < GPIO_NUM_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num) {
+    return (gpio_num >= 0 && gpio_num < GPIO_NUM_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+/* ---------------------------------------------------------------------------
+ * I2C master
+ * ------------------------------------------------------------------------- */
+
+struct i2c_master_bus_t {
+    i2c_port_num_t port;
+    pthread_mutex_t lock;        // One transfer at a time per controller
+};
+
+struct i2c_master_dev_t {
+    i2c_master_bus_handle_t bus;
+    uint16_t address;
+};
+
+static host_i2c_target_t i2c_target;
+static void *i2c_target_ctx;
+static i2c_master_bus_handle_t i2c_controllers[SOC_I2C_NUM];
+
+void host_i2c_set_target(host_i2c_target_t target, void *ctx) {
+    i2c_target = target;
+    i2c_target_ctx = ctx;
+}
+
+static esp_err_t bus_transfer(i2c_master_bus_handle_t bus, uint16_t address, const uint8_t *write,
+                              size_t write_len, uint8_t *read, size_t read_len) {
+    host_i2c_transfer_t transfer = {
+        .port = bus->port,
+        .address = address,
+        .write = write,
+        .write_len = write_len,
+        .read = read,
+        .read_len = read_len,
+    };
+
+    pthread_mutex_lock(&bus->lock);
+    // Address NACK when nothing is connected
+    esp_err_t ret = i2c_target ? i2c_target(&transfer, i2c_target_ctx) : ESP_FAIL;
+    pthread_mutex_unlock(&bus->lock);
+    return ret;
+}
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t *bus_config, i2c_master_bus_handle_t *ret_bus_handle) {
+    if (!bus_config || !ret_bus_handle || bus_config->i2c_port < -1 || bus_config->i2c_port >= SOC_I2C_NUM) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // -1 takes the first free controller, like the IDF driver
+    i2c_port_num_t port = bus_config->i2c_port;
+    for (i2c_port_num_t i = 0; port < 0 && i < SOC_I2C_NUM; i++) {
+        if (!i2c_controllers[i]) {
+            port = i;
+        }
+    }
+    if (port < 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (i2c_controllers[port]) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    *ret_bus_handle = calloc(1, sizeof(**ret_bus_handle));
+    if (!*ret_bus_handle) {
+        return ESP_ERR_NO_MEM;
+    }
+    (*ret_bus_handle)->port = port;
+    pthread_mutex_init(&(*ret_bus_handle)->lock, NULL);
+    i2c_controllers[port] = *ret_bus_handle;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_get_bus_handle(i2c_port_num_t port_num, i2c_master_bus_handle_t *ret_handle) {
+    if (port_num < 0 || port_num >= SOC_I2C_NUM || !ret_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *ret_handle = i2c_controllers[port_num];
+    return *ret_handle ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t i2c_del_master_bus(i2c_master_bus_handle_t bus_handle) {
+    if (bus_handle) {
+        i2c_controllers[bus_handle->port] = NULL;
+        pthread_mutex_destroy(&bus_handle->lock);
+        free(bus_handle);
+    }
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus_handle, const i2c_device_config_t *dev_config,
+                                    i2c_master_dev_handle_t *ret_handle) {
+    if (!bus_handle || !dev_config || !ret_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *ret_handle = calloc(1, sizeof(**ret_handle));
+    if (!*ret_handle) {
+        return ESP_ERR_NO_MEM;
+    }
+    (*ret_handle)->bus = bus_handle;
+    (*ret_handle)->address = dev_config->device_address;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_rm_device(i2c_master_dev_handle_t handle) {
+    free(handle);
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t i2c_dev, const uint8_t *write_buffer, size_t write_size,
+                              int xfer_timeout_ms) {
+    (void)xfer_timeout_ms;
+    if (!i2c_dev || !write_buffer || write_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return bus_transfer(i2c_dev->bus, i2c_dev->address, write_buffer, write_size, NULL, 0);
+}
+
+esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t i2c_dev, const uint8_t *write_buffer,
+                                      size_t write_size, uint8_t *read_buffer, size_t read_size,
+                                      int xfer_timeout_ms) {
+    (void)xfer_timeout_ms;
+    if (!i2c_dev || !write_buffer || write_size == 0 || !read_buffer || read_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return bus_transfer(i2c_dev->bus, i2c_dev->address, write_buffer, write_size, read_buffer, read_size);
+}
+
+esp_err_t i2c_master_bus_reset(i2c_master_bus_handle_t bus_handle) {
+    return bus_handle ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t i2c_master_probe(i2c_master_bus_handle_t bus_handle, uint16_t address, int xfer_timeout_ms) {
+    (void)xfer_timeout_ms;
+    if (!bus_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return (bus_transfer(bus_handle, address, NULL, 0, NULL, 0) == ESP_OK) ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+/* ---------------------------------------------------------------------------
+ * NVS: blobs kept in memory until host_nvs_reset()
+ * ------------------------------------------------------------------------- */
+
+#define NVS_MAX_ENTRIES     32
+#define NVS_MAX_NAMESPACES  8
+#define NVS_NAME_LEN        16      // 15 characters and the terminator, as on target
+#define NVS_MAX_BLOB        64
+
+typedef struct {
+    bool used;
+    uint8_t ns;                     // Namespace index
+    char key[NVS_NAME_LEN];
+    uint8_t data[NVS_MAX_BLOB];
+    size_t len;
+} nvs_entry_t;
+
+static pthread_mutex_t nvs_lock = PTHREAD_MUTEX_INITIALIZER;
+static char nvs_namespaces[NVS_MAX_NAMESPACES][NVS_NAME_LEN];
+static nvs_entry_t nvs_entries[NVS_MAX_ENTRIES];
+static host_nvs_stats_t nvs_stats;
+
+void host_nvs_reset(void) {
+    pthread_mutex_lock(&nvs_lock);
+    memset(nvs_namespaces, 0, sizeof(nvs_namespaces));
+    memset(nvs_entries, 0, sizeof(nvs_entries));
+    memset(&nvs_stats, 0, sizeof(nvs_stats));
+    pthread_mutex_unlock(&nvs_lock);
+}
+
+void host_nvs_get_stats(host_nvs_stats_t *stats) {
+    pthread_mutex_lock(&nvs_lock);
+    *stats = nvs_stats;
+    pthread_mutex_unlock(&nvs_lock);
+}
+
+// Handles are namespace index + 1, with bit 31 set for read-write
+#define NVS_HANDLE_RW 0x80000000u
+
+static nvs_entry_t *find_entry(nvs_handle_t handle, const char *key) {
+    uint8_t ns = (uint8_t)((handle & ~NVS_HANDLE_RW) - 1);
+    for (int i = 0; i < NVS_MAX_ENTRIES; i++) {
+        if (nvs_entries[i].used && nvs_entries[i].ns == ns && strcmp(nvs_entries[i].key, key) == 0) {
+            return &nvs_entries[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle) {
+    if (!name || !out_handle || strlen(name) >= NVS_NAME_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_ERR_NVS_NOT_FOUND;
+    pthread_mutex_lock(&nvs_lock);
+    for (int i = 0; i < NVS_MAX_NAMESPACES; i++) {
+        if (nvs_namespaces[i][0] == '\0' && open_mode == NVS_READWRITE) {
+            // Read-write open creates the namespace
+            strcpy(nvs_namespaces[i], name);
+        }
+        if (strcmp(nvs_namespaces[i], name) == 0) {
+            *out_handle = (nvs_handle_t)(i + 1) | (open_mode == NVS_READWRITE ? NVS_HANDLE_RW : 0);
+            ret = ESP_OK;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return ret;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length) {
+    if (!key || !length) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_OK;
+    pthread_mutex_lock(&nvs_lock);
+    nvs_stats.reads++;
+    nvs_entry_t *entry = find_entry(handle, key);
+    if (!entry) {
+        ret = ESP_ERR_NVS_NOT_FOUND;
+    } else if (out_value && *length < entry->len) {
+        ret = ESP_ERR_NVS_INVALID_LENGTH;
+    } else if (out_value) {
+        memcpy(out_value, entry->data, entry->len);
+    }
+    if (entry) {
+        *length = entry->len;
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return ret;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length) {
+    if (!key || !value || strlen(key) >= NVS_NAME_LEN || length > NVS_MAX_BLOB) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!(handle & NVS_HANDLE_RW)) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+
+    esp_err_t ret = ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+    pthread_mutex_lock(&nvs_lock);
+    nvs_entry_t *entry = find_entry(handle, key);
+    for (int i = 0; !entry && i < NVS_MAX_ENTRIES; i++) {
+        if (!nvs_entries[i].used) {
+            entry = &nvs_entries[i];
+            entry->used = true;
+            entry->ns = (uint8_t)((handle & ~NVS_HANDLE_RW) - 1);
+            strcpy(entry->key, key);
+        }
+    }
+    if (entry) {
+        memcpy(entry->data, value, length);
+        entry->len = length;
+        nvs_stats.writes++;
+        ret = ESP_OK;
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return ret;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key) {
+    if (!key) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!(handle & NVS_HANDLE_RW)) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+
+    pthread_mutex_lock(&nvs_lock);
+    nvs_entry_t *entry = find_entry(handle, key);
+    if (entry) {
+        memset(entry, 0, sizeof(*entry));
+        nvs_stats.erases++;
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return entry ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    (void)handle;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {
+    (void)handle;
+}
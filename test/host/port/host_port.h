@@ -0,0 +1,66 @@
+/**
+ * @file host_port.h
+ * @brief Test hooks of the host port: what sits on the fake I2C buses, NVS contents
+ */
+
+#ifndef HOST_PORT_H
+#define HOST_PORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "driver/i2c_master.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief One transfer as it appears on the wire
+ *
+ * Probes have neither write nor read data. The controller is held for the
+ * whole call, as the I2C driver does.
+ */
+typedef struct {
+    i2c_port_num_t port;         /*!< Controller the device was added to */
+    uint16_t address;            /*!< 7-bit address the transfer was sent to */
+    const uint8_t *write;        /*!< Bytes written after the address */
+    size_t write_len;
+    uint8_t *read;               /*!< Buffer for the bytes read after a repeated start */
+    size_t read_len;
+} host_i2c_transfer_t;
+
+/**
+ * @brief Devices on the fake buses: ESP_OK for an ACKed transfer
+ */
+typedef esp_err_t (*host_i2c_target_t)(const host_i2c_transfer_t *transfer, void *ctx);
+
+/**
+ * @brief Connect devices to every fake bus (NULL: nothing answers)
+ */
+void host_i2c_set_target(host_i2c_target_t target, void *ctx);
+
+/**
+ * @brief NVS stand-in counters
+ */
+typedef struct {
+    uint32_t reads;              /*!< nvs_get_blob calls */
+    uint32_t writes;             /*!< Blobs stored */
+    uint32_t erases;             /*!< Keys erased */
+} host_nvs_stats_t;
+
+/**
+ * @brief Erase every namespace and key, as on a freshly flashed board, and clear the counters
+ */
+void host_nvs_reset(void);
+
+/**
+ * @brief Get the NVS stand-in counters
+ */
+void host_nvs_get_stats(host_nvs_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_PORT_H
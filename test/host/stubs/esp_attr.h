@@ -0,0 +1,9 @@
+/**
+ * @file esp_attr.h
+ * @brief Host stand-in: placement attributes have no meaning off target
+ */
+
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
@@ -0,0 +1,12 @@
+/**
+ * @file esp_log.h
+ * @brief Host stand-in: logging is compiled out so test output stays readable
+ */
+
+#pragma once
+
+#define ESP_LOGE(tag, ...) ((void)(tag))
+#define ESP_LOGW(tag, ...) ((void)(tag))
+#define ESP_LOGI(tag, ...) ((void)(tag))
+#define ESP_LOGD(tag, ...) ((void)(tag))
+#define ESP_LOGV(tag, ...) ((void)(tag))
@@ -0,0 +1,43 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host stand-in for the FreeRTOS kernel types, backed by pthreads
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE             0
+#define pdTRUE              1
+#define pdPASS              pdTRUE
+#define pdFAIL              pdFALSE
+#define portMAX_DELAY       ((TickType_t)0xFFFFFFFFu)
+
+#define configTICK_RATE_HZ  CONFIG_FREERTOS_HZ
+#define portTICK_PERIOD_MS  ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(((TickType_t)(ms) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+#define pdTICKS_TO_MS(t)    ((TickType_t)((uint64_t)(t) * 1000 / configTICK_RATE_HZ))
+
+#define portYIELD_FROM_ISR(x) ((void)(x))
+
+// Spinlocks become one process-wide recursive mutex
+typedef struct {
+    int unused;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+
+void vPortEnterCritical(void);
+void vPortExitCritical(void);
+
+#define portENTER_CRITICAL(mux)     ((void)(mux), vPortEnterCritical())
+#define portEXIT_CRITICAL(mux)      ((void)(mux), vPortExitCritical())
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux), vPortEnterCritical())
+#define portEXIT_CRITICAL_ISR(mux)  ((void)(mux), vPortExitCritical())
@@ -0,0 +1,20 @@
+/**
+ * @file semphr.h
+ * @brief Host stand-in for FreeRTOS mutexes
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_mutex_s *SemaphoreHandle_t;
+
+// Size of the kernel object on the ESP32 port, for footprint reports
+typedef struct {
+    uint8_t opaque[80];
+} StaticSemaphore_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks_to_wait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex);
+void vSemaphoreDelete(SemaphoreHandle_t mutex);
@@ -0,0 +1,12 @@
+/**
+ * @file sdkconfig.h
+ * @brief Host stand-in for the generated project configuration
+ */
+
+#pragma once
+
+// The ESP-IDF default is 100 Hz; the host build ranges at 1000 Hz unless a
+// target overrides it (test_bus_faults_100hz)
+#ifndef CONFIG_FREERTOS_HZ
+#define CONFIG_FREERTOS_HZ 1000
+#endif
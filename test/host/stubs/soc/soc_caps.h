@@ -0,0 +1,8 @@
+/**
+ * @file soc_caps.h
+ * @brief Host stand-in: capabilities of the original ESP32
+ */
+
+#pragma once
+
+#define SOC_I2C_NUM 2
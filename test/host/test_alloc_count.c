@@ -0,0 +1,87 @@
+/**
+ * @file test_alloc_count.c
+ * @brief The I2C write path does not touch the heap
+ *
+ * Init (calibration and tuning load included), single shots, continuous
+ * ranging and mode switches in every mode must leave the platform layer's
+ * allocation counter where it was. Only a write larger than the per-device
+ * scratch buffer may allocate.
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include "host_test.h"
+#include "vl53l0x_driver.h"
+#include "vl53l0x_sim.h"
+#include "vl53l0x_sim_io.h"
+#include "vl53l0x_platform.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const vl53l0x_mode_t modes[] = {
+    VL53L0X_MODE_DEFAULT, VL53L0X_MODE_HIGH_ACCURACY, VL53L0X_MODE_HIGH_SPEED,
+    VL53L0X_MODE_LONG_RANGE, VL53L0X_MODE_ULTRA_FAST, VL53L0X_MODE_MULTI_SHOT,
+};
+
+static void on_sample(const vl53l0x_measurement_t* measurement, void* user_data) {
+    (void)measurement;
+    atomic_fetch_add((atomic_int*)user_data, 1);
+}
+
+int main(void) {
+    vl53l0x_sim_config_t sim_config = VL53L0X_SIM_DEFAULT_CONFIG();
+    vl53l0x_sim_handle_t sim;
+    vl53l0x_handle_t handle;
+    vl53l0x_measurement_t m;
+
+    uint32_t start = vl53l0x_get_platform_alloc_count();
+
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        CHECK_OK(vl53l0x_sim_create(&sim_config, &sim));
+        vl53l0x_config_t config = VL53L0X_DEFAULT_CONFIG();
+        config.simulator = sim;
+        config.mode = modes[i];
+        CHECK_OK(vl53l0x_init(&config, &handle));
+        CHECK_OK(vl53l0x_read_single(handle, &m));
+
+        // HIGH_ACCURACY (200 ms per sample) is only ranged from init, to keep the test short
+        if (modes[i] != VL53L0X_MODE_HIGH_ACCURACY) {
+            atomic_int samples = 0;
+            CHECK_OK(vl53l0x_start_continuous(handle, on_sample, &samples));
+            vTaskDelay(pdMS_TO_TICKS(400));
+            CHECK_OK(vl53l0x_stop_continuous(handle));
+            CHECK(atomic_load(&samples) > 0);
+        }
+        for (size_t j = 0; j < sizeof(modes) / sizeof(modes[0]); j++) {
+            if (modes[j] != VL53L0X_MODE_HIGH_ACCURACY) {
+                CHECK_OK(vl53l0x_set_mode(handle, modes[j]));
+                CHECK_OK(vl53l0x_read_single(handle, &m));
+            }
+        }
+
+        CHECK_OK(vl53l0x_deinit(handle));
+        vl53l0x_sim_delete(sim);
+        printf("%-14s allocations so far: %lu\n", vl53l0x_get_mode_name(modes[i]),
+               (unsigned long)(vl53l0x_get_platform_alloc_count() - start));
+    }
+    CHECK(vl53l0x_get_platform_alloc_count() == start);
+
+    // The counter does see the heap fallback
+    VL53L0X_Dev_t dev;
+    memset(&dev, 0, sizeof(dev));
+    CHECK_OK(vl53l0x_sim_create(&sim_config, &sim));
+    dev.sim = sim;
+    CHECK_OK(vl53l0x_sim_attach(sim, &dev));
+    uint8_t small[VL53L0X_I2C_SCRATCH_SIZE - 1] = { 0 };
+    uint8_t large[VL53L0X_I2C_SCRATCH_SIZE] = { 0 };
+    CHECK(VL53L0X_WriteMulti(&dev, 0x20, small, sizeof(small)) == VL53L0X_ERROR_NONE);
+    CHECK(vl53l0x_get_platform_alloc_count() == start);
+    CHECK(VL53L0X_WriteMulti(&dev, 0x20, large, sizeof(large)) == VL53L0X_ERROR_NONE);
+    CHECK(vl53l0x_get_platform_alloc_count() == start + 1);
+    vl53l0x_sim_detach(sim);
+    vl53l0x_sim_delete(sim);
+
+    printf("ok\n");
+    return 0;
+}
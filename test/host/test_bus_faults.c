@@ -0,0 +1,214 @@
+/**
+ * @file test_bus_faults.c
+ * @brief Stuck and glitching buses stall callers for milliseconds, not seconds
+ *
+ * A stuck bus costs one deadline, a recovery and one retry per transfer,
+ * after which transfers fail fast. A NACK is retried without resetting the
+ * bus. Deadlines are whole ticks, so the same holds at a 100 Hz tick
+ * (test_bus_faults_100hz). A sensor ranging continuously on such a
+ * bus keeps its mutex waits short, goes DEGRADED and comes back once the
+ * bus is released. A ranging task that cannot be stopped keeps its handle
+ * alive through vl53l0x_deinit().
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include "host_test.h"
+#include "vl53l0x_driver.h"
+#include "vl53l0x_sim.h"
+#include "vl53l0x_sim_io.h"
+#include "vl53l0x_platform.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Shortest transfer deadline: two ticks, and never under 2 ms
+#define TICK_US                 (1000000 / configTICK_RATE_HZ)
+#define DEADLINE_US             (2 * TICK_US > 2000 ? 2 * TICK_US : 2000)
+// Two deadlines and a recovery. The bounds leave room for host scheduling
+// (sleeps on a loaded single-CPU host overshoot by tens of ms) and still
+// sit far below the 1 s transfer timeout they replace.
+#define MAX_TRANSFER_STALL_US   (2 * DEADLINE_US + 26000)
+// A transfer stall plus the time to finish the sample step that held the mutex
+#define MAX_MUTEX_WAIT_US       (MAX_TRANSFER_STALL_US + 20000)
+#define FAIL_FAST_US            500
+
+static atomic_int good_samples;
+static atomic_int degraded_samples;
+
+static void on_sample(const vl53l0x_measurement_t* measurement, void* user_data) {
+    (void)user_data;
+    if (measurement->is_valid) {
+        atomic_fetch_add(&good_samples, 1);
+    } else if (measurement->health == VL53L0X_HEALTH_DEGRADED) {
+        atomic_fetch_add(&degraded_samples, 1);
+    }
+}
+
+/**
+ * @brief Longest vl53l0x_get_health() call (it takes the sensor mutex) over a period
+ */
+static int64_t worst_mutex_wait_us(vl53l0x_handle_t handle, int period_ms) {
+    int64_t worst_us = 0;
+    int64_t end_us = esp_timer_get_time() + (int64_t)period_ms * 1000;
+
+    while (esp_timer_get_time() < end_us) {
+        vl53l0x_health_t health;
+        int64_t start_us = esp_timer_get_time();
+        CHECK_OK(vl53l0x_get_health(handle, &health));
+        int64_t wait_us = esp_timer_get_time() - start_us;
+        if (wait_us > worst_us) {
+            worst_us = wait_us;
+        }
+        vTaskDelay(1);
+    }
+    return worst_us;
+}
+
+static void transfer_deadlines(void) {
+    vl53l0x_sim_config_t sim_config = VL53L0X_SIM_DEFAULT_CONFIG();
+    vl53l0x_sim_handle_t sim;
+    VL53L0X_Dev_t dev;
+    uint8_t value;
+
+    memset(&dev, 0, sizeof(dev));
+    dev.comms_speed_khz = 400;
+    CHECK_OK(vl53l0x_sim_create(&sim_config, &sim));
+    dev.sim = sim;
+    CHECK_OK(vl53l0x_sim_attach(sim, &dev));
+
+    printf("stuck bus released by one recovery\n");
+    vl53l0x_sim_inject_fault(sim, VL53L0X_SIM_FAULT_BUS_STUCK, 1);
+    int64_t start_us = esp_timer_get_time();
+    CHECK(VL53L0X_RdByte(&dev, VL53L0X_REG_IDENTIFICATION_MODEL_ID, &value) == VL53L0X_ERROR_NONE);
+    int64_t stall_us = esp_timer_get_time() - start_us;
+    printf("  read succeeded after %lld us\n", (long long)stall_us);
+    CHECK(value == 0xEE);
+    CHECK(stall_us < MAX_TRANSFER_STALL_US);
+
+    printf("NACK retried without a bus reset\n");
+    vl53l0x_sim_stats_t st;
+    CHECK_OK(vl53l0x_sim_get_stats(sim, &st));
+    uint32_t resets = st.bus_resets;
+    vl53l0x_sim_inject_fault(sim, VL53L0X_SIM_FAULT_BUS_ERROR, 1);
+    CHECK(VL53L0X_RdByte(&dev, VL53L0X_REG_IDENTIFICATION_MODEL_ID, &value) == VL53L0X_ERROR_NONE);
+    CHECK_OK(vl53l0x_sim_get_stats(sim, &st));
+    printf("  read succeeded, %lu bus resets\n", (unsigned long)(st.bus_resets - resets));
+    CHECK(value == 0xEE);
+    CHECK(st.bus_resets == resets);
+
+    printf("stuck bus that recovery does not release\n");
+    vl53l0x_sim_inject_fault(sim, VL53L0X_SIM_FAULT_BUS_STUCK, 1000000);
+    start_us = esp_timer_get_time();
+    CHECK(VL53L0X_RdByte(&dev, VL53L0X_REG_IDENTIFICATION_MODEL_ID, &value) != VL53L0X_ERROR_NONE);
+    stall_us = esp_timer_get_time() - start_us;
+    start_us = esp_timer_get_time();
+    CHECK(VL53L0X_WrByte(&dev, 0x20, 0x00) != VL53L0X_ERROR_NONE);
+    int64_t fast_us = esp_timer_get_time() - start_us;
+    printf("  read failed after %lld us, next write failed after %lld us\n", (long long)stall_us,
+           (long long)fast_us);
+    CHECK(stall_us < MAX_TRANSFER_STALL_US);
+    CHECK(fast_us < FAIL_FAST_US);
+
+    vl53l0x_sim_detach(sim);
+    vl53l0x_sim_delete(sim);
+}
+
+static void continuous_on_faulty_bus(void) {
+    vl53l0x_sim_config_t sim_config = VL53L0X_SIM_DEFAULT_CONFIG();
+    vl53l0x_sim_handle_t sim;
+    vl53l0x_handle_t handle;
+    vl53l0x_health_t health;
+
+    CHECK_OK(vl53l0x_sim_create(&sim_config, &sim));
+    vl53l0x_config_t config = VL53L0X_DEFAULT_CONFIG();
+    config.simulator = sim;
+    config.mode = VL53L0X_MODE_HIGH_SPEED;
+    CHECK_OK(vl53l0x_init(&config, &handle));
+    CHECK_OK(vl53l0x_start_continuous(handle, on_sample, NULL));
+    vTaskDelay(pdMS_TO_TICKS(100));
+
+    printf("continuous, transient stuck bus and bus errors\n");
+    int64_t worst_us = 0;
+    for (int i = 0; i < 5; i++) {
+        vl53l0x_sim_inject_fault(sim, (i % 2) ? VL53L0X_SIM_FAULT_BUS_ERROR : VL53L0X_SIM_FAULT_BUS_STUCK, 1);
+        int64_t wait_us = worst_mutex_wait_us(handle, 50);
+        worst_us = (wait_us > worst_us) ? wait_us : worst_us;
+    }
+    CHECK_OK(vl53l0x_get_health(handle, &health));
+    printf("  worst mutex wait %lld us, health %d\n", (long long)worst_us, health);
+    CHECK(worst_us < MAX_MUTEX_WAIT_US);
+    CHECK(health == VL53L0X_HEALTH_OK);
+
+    printf("continuous, permanently stuck bus\n");
+    atomic_store(&degraded_samples, 0);
+    vl53l0x_sim_inject_fault(sim, VL53L0X_SIM_FAULT_BUS_STUCK, 1000000);
+    worst_us = worst_mutex_wait_us(handle, 300);
+    CHECK_OK(vl53l0x_get_health(handle, &health));
+    printf("  worst mutex wait %lld us, health %d, degraded reports %d\n", (long long)worst_us, health,
+           atomic_load(&degraded_samples));
+    CHECK(worst_us < MAX_MUTEX_WAIT_US);
+    CHECK(health == VL53L0X_HEALTH_DEGRADED);
+    CHECK(atomic_load(&degraded_samples) > 0);
+
+    printf("bus released\n");
+    vl53l0x_sim_inject_fault(sim, VL53L0X_SIM_FAULT_NONE, 0);
+    atomic_store(&good_samples, 0);
+    vTaskDelay(pdMS_TO_TICKS(200));
+    CHECK_OK(vl53l0x_get_health(handle, &health));
+    printf("  health %d, good samples %d\n", health, atomic_load(&good_samples));
+    CHECK(health == VL53L0X_HEALTH_OK);
+    CHECK(atomic_load(&good_samples) > 0);
+
+    CHECK_OK(vl53l0x_stop_continuous(handle));
+    CHECK_OK(vl53l0x_deinit(handle));
+    vl53l0x_sim_delete(sim);
+}
+
+static atomic_bool callback_blocked;
+
+static void on_sample_blocking(const vl53l0x_measurement_t* measurement, void* user_data) {
+    (void)measurement;
+    (void)user_data;
+    while (atomic_load(&callback_blocked)) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+/**
+ * @brief Deinit with the ranging task stuck in its callback fails and frees nothing
+ */
+static void deinit_with_stuck_task(void) {
+    vl53l0x_sim_config_t sim_config = VL53L0X_SIM_DEFAULT_CONFIG();
+    vl53l0x_sim_handle_t sim;
+    vl53l0x_handle_t handle;
+
+    printf("deinit while the ranging task is stuck\n");
+    CHECK_OK(vl53l0x_sim_create(&sim_config, &sim));
+    vl53l0x_config_t config = VL53L0X_DEFAULT_CONFIG();
+    config.simulator = sim;
+    config.mode = VL53L0X_MODE_HIGH_SPEED;
+    CHECK_OK(vl53l0x_init(&config, &handle));
+
+    atomic_store(&callback_blocked, true);
+    CHECK_OK(vl53l0x_start_continuous(handle, on_sample_blocking, NULL));
+    vTaskDelay(pdMS_TO_TICKS(100));
+    CHECK(vl53l0x_deinit(handle) == ESP_ERR_TIMEOUT);
+
+    // The handle is still usable once the task lets go
+    vl53l0x_health_t health;
+    CHECK_OK(vl53l0x_get_health(handle, &health));
+    atomic_store(&callback_blocked, false);
+    CHECK_OK(vl53l0x_deinit(handle));
+    vl53l0x_sim_delete(sim);
+}
+
+int main(void) {
+    printf("tick %d us, shortest transfer deadline %d us\n", TICK_US, DEADLINE_US);
+    transfer_deadlines();
+    continuous_on_faulty_bus();
+    deinit_with_stuck_task();
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,121 @@
+/**
+ * @file test_cal_cache.c
+ * @brief Reference calibration cached in NVS, keyed by the sensor unique ID
+ *
+ * Runs against the in-memory NVS of the host port and simulated sensors:
+ * the first boot calibrates and stores a record, the next boot of the same
+ * sensor restores it and skips the reference measurements, another sensor
+ * and a forced recalibration measure again, and the cache off leaves NVS
+ * alone. A forced recalibration that fails leaves no record behind.
+ */
+
+#include <stdio.h>
+#include "host_test.h"
+#include "host_port.h"
+#include "vl53l0x_driver.h"
+#include "vl53l0x_sim.h"
+#include "vl53l0x_cal_store.h"
+
+typedef struct {
+    uint32_t measurements;       // Measurements during init (reference calibration, VCSEL phase calibration)
+    uint32_t transfers;          // Register transfers during init
+    host_nvs_stats_t nvs;        // NVS counters after init
+} boot_t;
+
+/**
+ * @brief Boot one simulated sensor, take a sample and shut it down
+ */
+static boot_t boot(uint32_t uid_lower, bool cache, bool force) {
+    vl53l0x_sim_config_t sim_config = VL53L0X_SIM_DEFAULT_CONFIG();
+    vl53l0x_sim_handle_t sim;
+    vl53l0x_handle_t handle;
+    vl53l0x_sim_stats_t st;
+    vl53l0x_measurement_t m;
+    boot_t result;
+
+    sim_config.uid_lower = uid_lower;
+    CHECK_OK(vl53l0x_sim_create(&sim_config, &sim));
+    vl53l0x_config_t config = VL53L0X_DEFAULT_CONFIG();
+    config.simulator = sim;
+    config.cache_calibration = cache;
+    config.force_recalibration = force;
+    CHECK_OK(vl53l0x_init(&config, &handle));
+
+    CHECK_OK(vl53l0x_sim_get_stats(sim, &st));
+    result.measurements = st.samples;
+    result.transfers = st.reads + st.writes;
+    host_nvs_get_stats(&result.nvs);
+
+    CHECK_OK(vl53l0x_read_single(handle, &m));
+    CHECK(m.is_valid);
+    CHECK_OK(vl53l0x_deinit(handle));
+    vl53l0x_sim_delete(sim);
+
+    printf("  uid %lu cache %d force %d: %2lu measurements, %4lu transfers, NVS reads %lu writes %lu\n",
+           (unsigned long)uid_lower, cache, force, (unsigned long)result.measurements,
+           (unsigned long)result.transfers,
+           (unsigned long)result.nvs.reads, (unsigned long)result.nvs.writes);
+    return result;
+}
+
+int main(void) {
+    vl53l0x_sim_config_t defaults = VL53L0X_SIM_DEFAULT_CONFIG();
+    vl53l0x_ref_cal_t cal;
+
+    host_nvs_reset();
+
+    printf("first boot: full calibration, record stored\n");
+    boot_t first = boot(1, true, false);
+    CHECK(first.nvs.writes == 1);
+    CHECK_OK(vl53l0x_cal_load(defaults.uid_upper, 1, &cal));
+    CHECK(first.measurements > 0);
+    CHECK(cal.uid_upper == defaults.uid_upper && cal.uid_lower == 1);
+
+    printf("same sensor again: calibration restored\n");
+    boot_t cached = boot(1, true, false);
+    CHECK(cached.nvs.writes == first.nvs.writes);
+    CHECK(cached.measurements < first.measurements);
+    CHECK(cached.transfers < first.transfers);
+
+    printf("another sensor: its own record\n");
+    boot_t other = boot(2, true, false);
+    CHECK(other.nvs.writes == cached.nvs.writes + 1);
+    CHECK(other.measurements == first.measurements);
+    CHECK_OK(vl53l0x_cal_load(defaults.uid_upper, 2, &cal));
+
+    printf("forced recalibration: measured and stored again\n");
+    boot_t forced = boot(1, true, true);
+    CHECK(forced.nvs.erases == other.nvs.erases + 1);
+    CHECK(forced.nvs.writes == other.nvs.writes + 1);
+    CHECK(forced.measurements == first.measurements);
+
+    printf("cache off: NVS untouched\n");
+    boot_t off = boot(1, false, false);
+    CHECK(off.nvs.reads == forced.nvs.reads && off.nvs.writes == forced.nvs.writes);
+    CHECK(off.measurements == first.measurements);
+
+    printf("erased record: full calibration on the next boot\n");
+    CHECK_OK(vl53l0x_cal_erase(defaults.uid_upper, 1));
+    CHECK(vl53l0x_cal_load(defaults.uid_upper, 1, &cal) == ESP_ERR_NOT_FOUND);
+    boot_t erased = boot(1, true, false);
+    CHECK(erased.measurements == first.measurements);
+    CHECK(erased.nvs.writes == off.nvs.writes + 1);
+
+    printf("forced recalibration that fails: old record gone\n");
+    vl53l0x_sim_config_t sim_config = VL53L0X_SIM_DEFAULT_CONFIG();
+    vl53l0x_sim_handle_t sim;
+    vl53l0x_handle_t handle;
+    sim_config.uid_lower = 2;
+    CHECK_OK(vl53l0x_sim_create(&sim_config, &sim));
+    vl53l0x_sim_inject_fault(sim, VL53L0X_SIM_FAULT_NO_COMPLETION, 1);
+    vl53l0x_config_t config = VL53L0X_DEFAULT_CONFIG();
+    config.simulator = sim;
+    config.cache_calibration = true;
+    config.force_recalibration = true;
+    CHECK(vl53l0x_init(&config, &handle) != ESP_OK);
+    CHECK(vl53l0x_cal_load(defaults.uid_upper, 2, &cal) == ESP_ERR_NOT_FOUND);
+    vl53l0x_sim_delete(sim);
+
+    printf("ok\n");
+    return 0;
+}
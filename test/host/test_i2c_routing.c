@@ -0,0 +1,178 @@
+/**
+ * @file test_i2c_routing.c
+ * @brief Interleaved register traffic from several tasks reaches the right sensor
+ *
+ * Three ST devices, two sharing one controller, each with its own I2C
+ * device handle. One task per device writes and reads back its own
+ * pattern while the others do the same; the fake bus checks that every
+ * transfer carries the address of the device its task owns. A bus the
+ * application already holds on I2C0 leaves the other controller to the
+ * sensors.
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include "host_test.h"
+#include "host_port.h"
+#include "vl53l0x_platform.h"
+#include "vl53l0x_bus.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define NUM_DEVICES     3
+#define ITERATIONS      2000
+#define REG_IDENTITY    0xC0    // Model ID register: answers the device's own tag here
+#define REG_SCRATCH     0x20    // Written and read back by the owning task
+#define REG_BLOCK       0x40    // Multi-byte write/read
+
+typedef struct {
+    uint16_t address;
+    uint8_t regs[256];
+    uint32_t transfers;
+} fake_sensor_t;
+
+static fake_sensor_t sensors[NUM_DEVICES] = {
+    { .address = 0x30 },        // Front, own controller
+    { .address = 0x31 },        // Left and right share the other one
+    { .address = 0x32 },
+};
+
+static const struct {
+    gpio_num_t scl;
+    gpio_num_t sda;
+} pins[NUM_DEVICES] = {
+    { GPIO_NUM_5, GPIO_NUM_6 },
+    { GPIO_NUM_7, GPIO_NUM_8 },
+    { GPIO_NUM_7, GPIO_NUM_8 },
+};
+
+static VL53L0X_Dev_t devices[NUM_DEVICES];
+static __thread int expected_address = -1;    // Address the calling task owns
+static atomic_int misrouted;
+static atomic_int errors;
+static atomic_int done;
+
+static esp_err_t fake_bus(const host_i2c_transfer_t* transfer, void* ctx) {
+    (void)ctx;
+    fake_sensor_t* sensor = NULL;
+    for (int i = 0; i < NUM_DEVICES; i++) {
+        if (sensors[i].address == transfer->address) {
+            sensor = &sensors[i];
+        }
+    }
+    if (!sensor) {
+        return ESP_FAIL;
+    }
+    if (transfer->address != expected_address) {
+        atomic_fetch_add(&misrouted, 1);
+    }
+    sensor->transfers++;
+
+    // Index, then auto-incrementing data either way
+    uint8_t index = transfer->write[0];
+    for (size_t i = 1; i < transfer->write_len; i++) {
+        sensor->regs[index++] = transfer->write[i];
+    }
+    for (size_t i = 0; i < transfer->read_len; i++) {
+        transfer->read[i] = sensor->regs[index++];
+    }
+
+    // Let the other tasks in between transfers
+    vTaskDelay(0);
+    return ESP_OK;
+}
+
+static void device_task(void* arg) {
+    int n = (int)(intptr_t)arg;
+    VL53L0X_DEV dev = &devices[n];
+    expected_address = sensors[n].address;
+
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        uint16_t word = (uint16_t)((n << 12) | i);
+        uint16_t read_word = 0;
+        uint8_t identity = 0;
+        uint8_t block[6];
+        uint8_t read_block[6];
+
+        for (size_t b = 0; b < sizeof(block); b++) {
+            block[b] = (uint8_t)(n * 50 + i + b);
+        }
+        if (VL53L0X_WrWord(dev, REG_SCRATCH, word) != VL53L0X_ERROR_NONE ||
+            VL53L0X_RdByte(dev, REG_IDENTITY, &identity) != VL53L0X_ERROR_NONE ||
+            VL53L0X_RdWord(dev, REG_SCRATCH, &read_word) != VL53L0X_ERROR_NONE ||
+            VL53L0X_WriteMulti(dev, REG_BLOCK, block, sizeof(block)) != VL53L0X_ERROR_NONE ||
+            VL53L0X_ReadMulti(dev, REG_BLOCK, read_block, sizeof(read_block)) != VL53L0X_ERROR_NONE) {
+            atomic_fetch_add(&errors, 1);
+            break;
+        }
+        if (identity != sensors[n].address || read_word != word || memcmp(block, read_block, sizeof(block)) != 0) {
+            atomic_fetch_add(&misrouted, 1);
+        }
+    }
+
+    atomic_fetch_add(&done, 1);
+    vTaskDelete(NULL);
+}
+
+int main(void) {
+    host_i2c_set_target(fake_bus, NULL);
+
+    for (int n = 0; n < NUM_DEVICES; n++) {
+        VL53L0X_DEV dev = &devices[n];
+        sensors[n].regs[REG_IDENTITY] = (uint8_t)sensors[n].address;
+        dev->I2cDevAddr = (uint8_t)sensors[n].address;
+        dev->comms_speed_khz = 400;
+        CHECK_OK(vl53l0x_bus_acquire(pins[n].scl, pins[n].sda, &dev->i2c_bus));
+        i2c_device_config_t dev_config = {
+            .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+            .device_address = sensors[n].address,
+            .scl_speed_hz = 400000,
+        };
+        CHECK_OK(i2c_master_bus_add_device(dev->i2c_bus->handle, &dev_config, &dev->i2c_dev_handle));
+    }
+    CHECK(devices[1].i2c_bus == devices[2].i2c_bus);
+    CHECK(devices[0].i2c_bus != devices[1].i2c_bus);
+
+    for (int n = 0; n < NUM_DEVICES; n++) {
+        CHECK(xTaskCreate(device_task, "routing", 4096, (void*)(intptr_t)n, 5, NULL) == pdPASS);
+    }
+    while (atomic_load(&done) < NUM_DEVICES) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    for (int n = 0; n < NUM_DEVICES; n++) {
+        printf("0x%02X: %lu transfers\n", sensors[n].address, (unsigned long)sensors[n].transfers);
+        CHECK(sensors[n].transfers >= ITERATIONS * 5);
+    }
+    printf("errors %d, misrouted %d\n", atomic_load(&errors), atomic_load(&misrouted));
+    CHECK(atomic_load(&errors) == 0);
+    CHECK(atomic_load(&misrouted) == 0);
+
+    for (int n = 0; n < NUM_DEVICES; n++) {
+        CHECK_OK(i2c_master_bus_rm_device(devices[n].i2c_dev_handle));
+        vl53l0x_bus_release(devices[n].i2c_bus);
+    }
+
+    printf("application bus on I2C0\n");
+    i2c_master_bus_config_t app_config = {
+        .i2c_port = I2C_NUM_0,
+        .sda_io_num = GPIO_NUM_21,
+        .scl_io_num = GPIO_NUM_22,
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+    };
+    i2c_master_bus_handle_t app_bus;
+    vl53l0x_i2c_bus_t* sensor_bus;
+    vl53l0x_i2c_bus_t* second_bus;
+    CHECK_OK(i2c_new_master_bus(&app_config, &app_bus));
+    CHECK_OK(vl53l0x_bus_acquire(GPIO_NUM_5, GPIO_NUM_6, &sensor_bus));
+    printf("  sensors got I2C%d\n", (int)sensor_bus->port);
+    CHECK(sensor_bus->port == I2C_NUM_1);
+    CHECK(vl53l0x_bus_acquire(GPIO_NUM_7, GPIO_NUM_8, &second_bus) != ESP_OK);
+    vl53l0x_bus_release(sensor_bus);
+    CHECK_OK(i2c_del_master_bus(app_bus));
+
+    host_i2c_set_target(NULL, NULL);
+    printf("ok\n");
+    return 0;
+}
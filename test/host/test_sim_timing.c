@@ -0,0 +1,180 @@
+/**
+ * @file test_sim_timing.c
+ * @brief The simulator times measurements from the sequencer registers
+ *
+ * Every mode, and every mode reached through a preset replay, must program
+ * registers whose measurement time matches the budget the driver reports.
+ * A timing register overwritten behind the driver's back must show up.
+ * Waiting on a shot in short slices must not count as sensor timeouts.
+ * A pending shot and continuous ranging must each lock the other out.
+ * Polled ranging delivers samples without a task and is stopped by deinit.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "host_test.h"
+#include "vl53l0x_driver.h"
+#include "vl53l0x_sim.h"
+#include "vl53l0x_sim_io.h"
+#include "vl53l0x_api.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// The ST API rounds each step timeout to whole macro periods
+#define BUDGET_TOLERANCE_US 1000
+
+static const vl53l0x_mode_t modes[] = {
+    VL53L0X_MODE_DEFAULT, VL53L0X_MODE_HIGH_ACCURACY, VL53L0X_MODE_HIGH_SPEED,
+    VL53L0X_MODE_LONG_RANGE, VL53L0X_MODE_ULTRA_FAST, VL53L0X_MODE_MULTI_SHOT,
+};
+
+/**
+ * @brief One single shot: the programmed time matches the reported budget
+ * and the sample cannot arrive before it
+ */
+static uint32_t check_shot(vl53l0x_handle_t handle, vl53l0x_sim_handle_t sim, vl53l0x_mode_t mode) {
+    uint32_t budget_us;
+    vl53l0x_measurement_t m;
+    vl53l0x_sim_stats_t st;
+
+    CHECK_OK(vl53l0x_get_timing_budget(handle, &budget_us));
+    CHECK_OK(vl53l0x_trigger_single(handle));
+    int64_t start_us = esp_timer_get_time();
+    CHECK_OK(vl53l0x_wait_single(handle, 1000));
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+    CHECK_OK(vl53l0x_fetch_single(handle, &m));
+    CHECK(m.is_valid);
+    CHECK_OK(vl53l0x_sim_get_stats(sim, &st));
+
+    printf("  %-14s budget %6lu us, registers %6lu us, sample after %6lld us\n",
+           vl53l0x_get_mode_name(mode), (unsigned long)budget_us,
+           (unsigned long)st.measurement_us, (long long)elapsed_us);
+    CHECK(abs((int)st.measurement_us - (int)budget_us) <= BUDGET_TOLERANCE_US);
+    CHECK(elapsed_us >= st.measurement_us);
+    return st.measurement_us;
+}
+
+static void on_sample(const vl53l0x_measurement_t* measurement, void* user_data) {
+    (void)measurement;
+    (void)user_data;
+}
+
+int main(void) {
+    vl53l0x_sim_config_t sim_config = VL53L0X_SIM_DEFAULT_CONFIG();
+    vl53l0x_sim_handle_t sim;
+    vl53l0x_handle_t handle;
+
+    for (int fixed = 0; fixed < 2; fixed++) {
+        printf("each mode from init%s\n", fixed ? ", fixed mode (no presets)" : "");
+        for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+            CHECK_OK(vl53l0x_sim_create(&sim_config, &sim));
+            vl53l0x_config_t config = VL53L0X_DEFAULT_CONFIG();
+            config.simulator = sim;
+            config.mode = modes[i];
+            config.fixed_mode = fixed;
+            CHECK_OK(vl53l0x_init(&config, &handle));
+            check_shot(handle, sim, modes[i]);
+            if (fixed) {
+                vl53l0x_mode_t other = (modes[i] == VL53L0X_MODE_DEFAULT) ? VL53L0X_MODE_LONG_RANGE
+                                                                         : VL53L0X_MODE_DEFAULT;
+                CHECK(vl53l0x_set_mode(handle, other) == ESP_ERR_NOT_SUPPORTED);
+                CHECK_OK(vl53l0x_set_mode(handle, modes[i]));
+                check_shot(handle, sim, modes[i]);
+            }
+            CHECK_OK(vl53l0x_deinit(handle));
+            vl53l0x_sim_delete(sim);
+        }
+    }
+
+    printf("mode switches (first switch records the preset, later ones replay it)\n");
+    CHECK_OK(vl53l0x_sim_create(&sim_config, &sim));
+    vl53l0x_config_t config = VL53L0X_DEFAULT_CONFIG();
+    config.simulator = sim;
+    CHECK_OK(vl53l0x_init(&config, &handle));
+    for (int round = 0; round < 2; round++) {
+        for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+            CHECK_OK(vl53l0x_set_mode(handle, modes[i]));
+            check_shot(handle, sim, modes[i]);
+        }
+    }
+
+    printf("final range timeout overwritten behind the driver\n");
+    CHECK_OK(vl53l0x_set_mode(handle, VL53L0X_MODE_DEFAULT));
+    uint32_t good_us = check_shot(handle, sim, VL53L0X_MODE_DEFAULT);
+    uint8_t halve[] = { VL53L0X_REG_FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI, 0x00, 0x00 };
+    uint8_t index = VL53L0X_REG_FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI;
+    CHECK_OK(vl53l0x_sim_read(sim, index, &halve[1], 2, 10));
+    halve[1] -= 1;  // One less power of two: half the final range macro periods
+    CHECK_OK(vl53l0x_sim_write(sim, halve, sizeof(halve), 10));
+
+    vl53l0x_measurement_t m;
+    vl53l0x_sim_stats_t st;
+    CHECK_OK(vl53l0x_read_single(handle, &m));
+    CHECK_OK(vl53l0x_sim_get_stats(sim, &st));
+    printf("  registers now %lu us instead of %lu us\n", (unsigned long)st.measurement_us, (unsigned long)good_us);
+    CHECK(st.measurement_us < good_us * 3 / 4);
+
+    printf("async shot waited for in 1 ms slices\n");
+    vl53l0x_wait_stats_t wait;
+    int slices = 0;
+    esp_err_t ret;
+    CHECK(vl53l0x_get_wait_stats(handle, &wait) == ESP_ERR_INVALID_STATE);
+    CHECK_OK(vl53l0x_reset_wait_stats(handle));
+    CHECK_OK(vl53l0x_trigger_single(handle));
+    while ((ret = vl53l0x_wait_single(handle, 1)) == ESP_ERR_TIMEOUT) {
+        slices++;
+    }
+    CHECK_OK(ret);
+    CHECK_OK(vl53l0x_fetch_single(handle, &m));
+    CHECK_OK(vl53l0x_get_wait_stats(handle, &wait));
+    printf("  %d slices timed out, stats: %lu waits, %lu timeouts\n", slices,
+           (unsigned long)wait.measurements, (unsigned long)wait.timeouts);
+    CHECK(slices > 0);
+    CHECK(wait.measurements == 1);
+    CHECK(wait.timeouts == 0);
+
+    printf("single shot and continuous ranging exclude each other\n");
+    CHECK_OK(vl53l0x_trigger_single(handle));
+    CHECK(vl53l0x_start_continuous(handle, on_sample, NULL) == ESP_ERR_INVALID_STATE);
+    CHECK_OK(vl53l0x_wait_single(handle, 1000));
+    CHECK_OK(vl53l0x_fetch_single(handle, &m));
+    CHECK_OK(vl53l0x_start_continuous(handle, on_sample, NULL));
+    CHECK(vl53l0x_trigger_single(handle) == ESP_ERR_INVALID_STATE);
+    CHECK(vl53l0x_start_continuous(handle, on_sample, NULL) == ESP_ERR_INVALID_STATE);
+    CHECK_OK(vl53l0x_stop_continuous(handle));
+    CHECK_OK(vl53l0x_read_single(handle, &m));
+
+    printf("polled ranging\n");
+    CHECK_OK(vl53l0x_trigger_single(handle));
+    CHECK(vl53l0x_start_ranging(handle) == ESP_ERR_INVALID_STATE);
+    CHECK_OK(vl53l0x_wait_single(handle, 1000));
+    CHECK_OK(vl53l0x_fetch_single(handle, &m));
+    CHECK_OK(vl53l0x_start_ranging(handle));
+    CHECK(vl53l0x_start_continuous(handle, on_sample, NULL) == ESP_ERR_INVALID_STATE);
+    CHECK(vl53l0x_stop_continuous(handle) == ESP_ERR_INVALID_STATE);
+    CHECK(vl53l0x_set_threshold_window(handle, 100, 200) == ESP_ERR_NOT_SUPPORTED);
+    int polled = 0;
+    int64_t poll_start_us = esp_timer_get_time();
+    while (polled < 5 && esp_timer_get_time() - poll_start_us < 1000000) {
+        bool ready = false;
+        CHECK_OK(vl53l0x_poll_ranging(handle, &m, &ready));
+        if (ready) {
+            CHECK(m.is_valid);
+            polled++;
+        } else {
+            vTaskDelay(1);
+        }
+    }
+    printf("  %d samples in %lld ms\n", polled, (long long)(esp_timer_get_time() - poll_start_us) / 1000);
+    CHECK(polled == 5);
+    CHECK_OK(vl53l0x_read_single(handle, &m));
+    CHECK_OK(vl53l0x_stop_ranging(handle));
+    CHECK(vl53l0x_stop_ranging(handle) == ESP_ERR_INVALID_STATE);
+    CHECK_OK(vl53l0x_start_ranging(handle));
+
+    CHECK_OK(vl53l0x_deinit(handle));
+    vl53l0x_sim_delete(sim);
+    printf("ok\n");
+    return 0;
+}